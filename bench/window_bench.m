@@ -0,0 +1,331 @@
+// window_bench.m - Micro-benchmarks for the registry, classifier and retry queue hot paths
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <mach/mach_time.h>
+
+#include "../src/core/common_types.h"
+#include "../src/core/logging.h"
+#include "../src/tracker/window_registry.h"
+#include "../src/tracker/window_rules.h"
+#include "../src/operations/window_retry_queue.h"
+
+// The registry benchmarks run against the real shared segments, in a namespace
+// of their own so injected applications neither disturb nor see them. Every
+// benchmark records one latency sample per operation (or per batch for sub-100ns
+// operations) and reports throughput plus p50/p99.
+
+#define REGISTRY_OPS_PER_THREAD 20000
+#define REGISTRY_MISS_ID_BASE 1000000   // IDs that are never registered
+#define CLASSIFIER_PROPS 1024           // Synthetic window descriptions
+#define CLASSIFIER_BATCH 64             // Calls timed together
+#define CLASSIFIER_BATCHES 20000
+#define RETRY_BURST_ROUNDS 20
+
+// Registry configuration: entries present, processes, threads per process
+typedef struct {
+    int entries;
+    int processes;
+    int threads;
+} registry_config_t;
+
+static const registry_config_t registry_configs[] = {
+    {1, 1, 1},
+    {64, 1, 1},
+    {512, 1, 1},
+    {2048, 1, 1},
+    {2048, 1, 4},
+    {2048, 1, 16},
+    {2048, 1, 32},
+    {2048, 2, 1},
+    {2048, 8, 1},
+    {2048, 32, 1},
+    {2048, 8, 4},
+    {32768, 1, 1},
+    {32768, 8, 4},
+};
+
+// State shared between the benchmark parent and its worker processes
+typedef struct {
+    _Atomic int ready;          // Workers prepared and waiting
+    _Atomic bool go;            // Released by the parent
+    uint64_t samples[];         // Per-op latency in ticks, one block per worker thread
+} registry_shared_run_t;
+
+// Per-thread arguments
+typedef struct {
+    window_registry_t* registry;
+    registry_shared_run_t* run;
+    const registry_config_t* config;
+    uint64_t* samples;
+    unsigned int seed;
+} registry_worker_t;
+
+static mach_timebase_info_data_t timebase;
+
+// Forward declarations
+static double ticks_to_ns(uint64_t ticks);
+static int compare_u64(const void* a, const void* b);
+static void report(const char* name, uint64_t* samples, size_t count, double divisor,
+                   uint64_t ops, uint64_t wall_ticks);
+static void* registry_worker_thread(void* arg);
+static void registry_worker_process(registry_shared_run_t* run, const registry_config_t* config, int process);
+static void bench_registry(const registry_config_t* config);
+static void bench_classifier(void);
+static void bench_retry_queue(size_t burst);
+
+int main(void) {
+    mach_timebase_info(&timebase);
+    
+    // Keep registry messages from skewing the timings
+    wm_log_level = WM_LOG_LEVEL_ERROR;
+    
+    // Worker processes inherit the namespace
+    setenv("WM_REGISTRY_NAMESPACE", "window_bench", 1);
+    
+    printf("%-44s %12s %10s %10s\n", "benchmark", "ops/s", "p50 (ns)", "p99 (ns)");
+    
+    for (size_t i = 0; i < sizeof(registry_configs) / sizeof(registry_configs[0]); i++) {
+        bench_registry(&registry_configs[i]);
+    }
+    
+    bench_classifier();
+    
+    bench_retry_queue(64);
+    bench_retry_queue(1024);
+    bench_retry_queue(8192);
+    
+    return 0;
+}
+
+// Convert mach ticks to nanoseconds
+static double ticks_to_ns(uint64_t ticks) {
+    return (double)ticks * timebase.numer / timebase.denom;
+}
+
+static int compare_u64(const void* a, const void* b) {
+    uint64_t va = *(const uint64_t*)a;
+    uint64_t vb = *(const uint64_t*)b;
+    return (va > vb) - (va < vb);
+}
+
+// Print one result line; samples are tick counts covering divisor operations each
+static void report(const char* name, uint64_t* samples, size_t count, double divisor,
+                   uint64_t ops, uint64_t wall_ticks) {
+    qsort(samples, count, sizeof(uint64_t), compare_u64);
+    
+    double p50 = ticks_to_ns(samples[count / 2]) / divisor;
+    double p99 = ticks_to_ns(samples[(count * 99) / 100]) / divisor;
+    double seconds = ticks_to_ns(wall_ticks) / 1e9;
+    
+    printf("%-44s %12.0f %10.1f %10.1f\n", name, seconds > 0 ? (double)ops / seconds : 0.0, p50, p99);
+}
+
+// Registry worker: 75% hits, 12.5% misses, 12.5% marks over the populated set
+static void* registry_worker_thread(void* arg) {
+    registry_worker_t* worker = (registry_worker_t*)arg;
+    
+    while (!atomic_load_explicit(&worker->run->go, memory_order_acquire)) {
+        // Spin so every worker starts together
+    }
+    
+    for (int i = 0; i < REGISTRY_OPS_PER_THREAD; i++) {
+        int op = rand_r(&worker->seed) & 7;
+        CGSWindowID windowID = 1 + (CGSWindowID)(rand_r(&worker->seed) % worker->config->entries);
+    
+        uint64_t start = mach_absolute_time();
+        if (op == 0) {
+            registry_is_window_modified(worker->registry, REGISTRY_MISS_ID_BASE + windowID);
+        } else if (op == 1) {
+            registry_mark_window_modified(worker->registry, windowID);
+        } else {
+            registry_is_window_modified(worker->registry, windowID);
+        }
+        worker->samples[i] = mach_absolute_time() - start;
+    }
+    
+    return NULL;
+}
+
+// One benchmark process: join the registry, populate it and run the threads
+static void registry_worker_process(registry_shared_run_t* run, const registry_config_t* config, int process) {
+    window_registry_t* registry = registry_init();
+    if (!registry) {
+        fprintf(stderr, "registry_init failed in worker %d\n", process);
+        atomic_fetch_add(&run->ready, 1);
+        _exit(1);
+    }
+    
+    for (int i = 1; i <= config->entries; i++) {
+        registry_mark_window_modified(registry, (CGSWindowID)i);
+    }
+    
+    pthread_t threads[32];
+    registry_worker_t workers[32];
+    for (int t = 0; t < config->threads; t++) {
+        workers[t].registry = registry;
+        workers[t].run = run;
+        workers[t].config = config;
+        workers[t].samples = run->samples +
+            (size_t)(process * config->threads + t) * REGISTRY_OPS_PER_THREAD;
+        workers[t].seed = (unsigned int)(process * 7919 + t * 104729 + 1);
+        pthread_create(&threads[t], NULL, registry_worker_thread, &workers[t]);
+    }
+    
+    atomic_fetch_add(&run->ready, 1);
+    
+    for (int t = 0; t < config->threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    
+    registry_cleanup(registry);
+    _exit(0);
+}
+
+// Registry lookups and marks under concurrent processes and threads
+static void bench_registry(const registry_config_t* config) {
+    size_t workers = (size_t)config->processes * config->threads;
+    size_t sample_count = workers * REGISTRY_OPS_PER_THREAD;
+    size_t size = sizeof(registry_shared_run_t) + sample_count * sizeof(uint64_t);
+    
+    registry_shared_run_t* run = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANON, -1, 0);
+    if (run == MAP_FAILED) {
+        perror("mmap");
+        return;
+    }
+    
+    pid_t pids[32];
+    for (int p = 0; p < config->processes; p++) {
+        pids[p] = fork();
+        if (pids[p] == 0) {
+            registry_worker_process(run, config, p);
+        }
+    }
+    
+    while (atomic_load(&run->ready) < config->processes) {
+        usleep(1000);
+    }
+    
+    uint64_t start = mach_absolute_time();
+    atomic_store_explicit(&run->go, true, memory_order_release);
+    
+    for (int p = 0; p < config->processes; p++) {
+        waitpid(pids[p], NULL, 0);
+    }
+    uint64_t wall = mach_absolute_time() - start;
+    
+    char name[64];
+    snprintf(name, sizeof(name), "registry %5d entries %2d proc x %2d thr",
+             config->entries, config->processes, config->threads);
+    report(name, run->samples, sample_count, 1.0, sample_count, wall);
+    
+    munmap(run, size);
+}
+
+// window_rules_classify over a mix of synthetic window descriptions
+static void bench_classifier(void) {
+    window_properties_t* props = calloc(CLASSIFIER_PROPS, sizeof(window_properties_t));
+    uint64_t* samples = malloc(CLASSIFIER_BATCHES * sizeof(uint64_t));
+    if (!props || !samples) {
+        free(props);
+        free(samples);
+        return;
+    }
+    
+    // Standard, panel, sheet, helper, tiny and transparent windows, with and without style masks
+    unsigned int seed = 42;
+    for (int i = 0; i < CLASSIFIER_PROPS; i++) {
+        window_properties_t* p = &props[i];
+        p->present = WINDOW_PROP_HAS_ALPHA | WINDOW_PROP_HAS_SIZE | WINDOW_PROP_HAS_LAYER | WINDOW_PROP_HAS_LEVEL;
+        p->alpha = (rand_r(&seed) % 10 == 0) ? 0.1 : 1.0;
+        p->width = (rand_r(&seed) % 8 == 0) ? 20 : 200 + rand_r(&seed) % 1600;
+        p->height = (rand_r(&seed) % 8 == 0) ? 20 : 150 + rand_r(&seed) % 1000;
+        p->layer = (rand_r(&seed) % 10 == 0) ? 25 : 0;
+        p->level = (rand_r(&seed) % 10 == 0) ? (int)(rand_r(&seed) % 8) : 0;
+        if (rand_r(&seed) % 2) {
+            static const uint32_t styles[] = {0x1, 0x1 | 0x2 | 0x4, 0x8, 0x200, 0x0};
+            p->style_mask = styles[rand_r(&seed) % 5];
+            p->present |= WINDOW_PROP_HAS_STYLE_MASK;
+        }
+    }
+    
+    volatile int sink = 0;
+    uint64_t start = mach_absolute_time();
+    for (int b = 0; b < CLASSIFIER_BATCHES; b++) {
+        uint64_t batch_start = mach_absolute_time();
+        for (int i = 0; i < CLASSIFIER_BATCH; i++) {
+            sink += window_rules_classify(&props[(b * CLASSIFIER_BATCH + i) & (CLASSIFIER_PROPS - 1)]).window_class;
+        }
+        samples[b] = mach_absolute_time() - batch_start;
+    }
+    uint64_t wall = mach_absolute_time() - start;
+    (void)sink;
+    
+    report("classifier window_rules_classify", samples, CLASSIFIER_BATCHES, CLASSIFIER_BATCH,
+           (uint64_t)CLASSIFIER_BATCHES * CLASSIFIER_BATCH, wall);
+    
+    free(props);
+    free(samples);
+}
+
+// Retry queue: bursts of inserts with random due times, then drain them
+static void bench_retry_queue(size_t burst) {
+    size_t sample_count = burst * RETRY_BURST_ROUNDS;
+    uint64_t* push_samples = malloc(sample_count * sizeof(uint64_t));
+    uint64_t* pop_samples = malloc(sample_count * sizeof(uint64_t));
+    window_retry_queue_t* queue = retry_queue_create(16, burst);
+    if (!push_samples || !pop_samples || !queue) {
+        free(push_samples);
+        free(pop_samples);
+        retry_queue_destroy(queue);
+        return;
+    }
+    
+    unsigned int seed = 7;
+    uint64_t push_wall = 0;
+    uint64_t pop_wall = 0;
+    size_t n = 0;
+    size_t m = 0;
+    
+    for (int round = 0; round < RETRY_BURST_ROUNDS; round++) {
+        uint64_t start = mach_absolute_time();
+        for (size_t i = 0; i < burst; i++) {
+            retry_window_t entry = {
+                .windowID = (CGSWindowID)(round * burst + i + 1),
+                .attempts = 0,
+                .next_attempt_time = (double)(rand_r(&seed) % 10000) / 1000.0
+            };
+    
+            uint64_t op_start = mach_absolute_time();
+            retry_queue_push(queue, &entry);
+            push_samples[n++] = mach_absolute_time() - op_start;
+        }
+        push_wall += mach_absolute_time() - start;
+    
+        start = mach_absolute_time();
+        retry_window_t entry;
+        for (;;) {
+            uint64_t op_start = mach_absolute_time();
+            if (!retry_queue_pop(queue, &entry)) {
+                break;
+            }
+            pop_samples[m++] = mach_absolute_time() - op_start;
+        }
+        pop_wall += mach_absolute_time() - start;
+    }
+    
+    char name[64];
+    snprintf(name, sizeof(name), "retry queue push (burst %zu)", burst);
+    report(name, push_samples, n, 1.0, n, push_wall);
+    snprintf(name, sizeof(name), "retry queue pop (burst %zu)", burst);
+    report(name, pop_samples, m, 1.0, m, pop_wall);
+    
+    free(push_samples);
+    free(pop_samples);
+    retry_queue_destroy(queue);
+}
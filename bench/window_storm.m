@@ -0,0 +1,337 @@
+// window_storm.m - Synthetic window storm for end-to-end latency testing
+#import <Cocoa/Cocoa.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <mach/mach_time.h>
+
+// Opens WM_STORM_RATE windows per second in each of WM_STORM_PROCESSES
+// processes for WM_STORM_DURATION seconds, cycling through standard, panel,
+// sheet and tiny helper windows. Each window is watched through the public
+// CGWindowList API until WindowServer reports it floating or excluded from
+// capture, which gives the time-to-modified of the injected library. Windows
+// close after WM_STORM_LIFETIME seconds so the destroy path is exercised too.
+//
+// Run it through the injector (`make storm`) and without it
+// (`make storm-baseline`) to compare CPU time and peak memory.
+
+#define STORM_DEFAULT_RATE 20         // Windows per second per process
+#define STORM_DEFAULT_PROCESSES 1
+#define STORM_DEFAULT_DURATION 30     // Seconds of window creation
+#define STORM_DEFAULT_LIFETIME 3      // Seconds each window stays open
+#define STORM_POLL_INTERVAL 0.002     // Seconds between modification checks
+#define STORM_MODIFY_TIMEOUT 5.0      // Seconds before a window counts as unmodified
+#define STORM_MAX_SAMPLES 65536
+
+// Window kinds created in rotation
+typedef enum {
+    STORM_KIND_STANDARD,
+    STORM_KIND_PANEL,
+    STORM_KIND_SHEET,
+    STORM_KIND_TINY,
+    STORM_KIND_COUNT
+} storm_kind_t;
+
+static const char *storm_kind_names[STORM_KIND_COUNT] = {"standard", "panel", "sheet", "tiny"};
+
+// Per-kind results
+typedef struct {
+    int created;
+    int modified;
+    int timed_out;
+    int sample_count;
+    double samples[STORM_MAX_SAMPLES]; // Time to modified (ms)
+} storm_results_t;
+
+static storm_results_t storm_results[STORM_KIND_COUNT];
+static mach_timebase_info_data_t timebase;
+
+// Read a positive integer setting from the environment
+static int stormSetting(const char *name, int defaultValue) {
+    const char *value = getenv(name);
+    int parsed = value ? atoi(value) : 0;
+    return parsed > 0 ? parsed : defaultValue;
+}
+
+// Milliseconds since a mach_absolute_time() reading
+static double elapsedMilliseconds(uint64_t start) {
+    return (double)(mach_absolute_time() - start) * timebase.numer / timebase.denom / 1e6;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// A window being watched
+@interface StormWindow : NSObject
+@property (nonatomic, strong) NSWindow *window;
+@property (nonatomic, strong) NSWindow *host;     // Parent of a sheet
+@property (nonatomic) storm_kind_t kind;
+@property (nonatomic) uint64_t shownAt;
+@end
+
+@implementation StormWindow
+@end
+
+@interface StormController : NSObject
+@property (nonatomic) int rate;
+@property (nonatomic) int duration;
+@property (nonatomic) int lifetime;
+@property (nonatomic) int created;
+@property (nonatomic) int target;
+@property (nonatomic, strong) NSMutableArray<StormWindow *> *pending;
+@property (nonatomic, strong) NSTimer *spawnTimer;
+@property (nonatomic, strong) NSTimer *pollTimer;
+@end
+
+@implementation StormController
+
+- (void)start {
+    self.pending = [NSMutableArray array];
+    self.target = self.rate * self.duration;
+    
+    self.spawnTimer = [NSTimer scheduledTimerWithTimeInterval:1.0 / self.rate
+                                                       target:self
+                                                     selector:@selector(spawnWindow)
+                                                     userInfo:nil
+                                                      repeats:YES];
+    self.pollTimer = [NSTimer scheduledTimerWithTimeInterval:STORM_POLL_INTERVAL
+                                                      target:self
+                                                    selector:@selector(pollWindows)
+                                                    userInfo:nil
+                                                     repeats:YES];
+}
+
+// Create the next window in the rotation
+- (void)spawnWindow {
+    if (self.created >= self.target) {
+        [self.spawnTimer invalidate];
+        self.spawnTimer = nil;
+        return;
+    }
+    
+    storm_kind_t kind = (storm_kind_t)(self.created % STORM_KIND_COUNT);
+    StormWindow *entry = [[StormWindow alloc] init];
+    entry.kind = kind;
+    
+    NSRect frame = NSMakeRect(40 + (self.created % 20) * 30, 40 + (self.created % 15) * 30, 480, 320);
+    switch (kind) {
+        case STORM_KIND_STANDARD:
+            entry.window = [[NSWindow alloc] initWithContentRect:frame
+                                                       styleMask:NSWindowStyleMaskTitled | NSWindowStyleMaskClosable |
+                                                                 NSWindowStyleMaskResizable
+                                                         backing:NSBackingStoreBuffered
+                                                           defer:NO];
+            break;
+    
+        case STORM_KIND_PANEL:
+            entry.window = [[NSPanel alloc] initWithContentRect:NSMakeRect(frame.origin.x, frame.origin.y, 240, 180)
+                                                      styleMask:NSWindowStyleMaskTitled | NSWindowStyleMaskUtilityWindow
+                                                        backing:NSBackingStoreBuffered
+                                                          defer:NO];
+            break;
+    
+        case STORM_KIND_SHEET:
+            entry.host = [[NSWindow alloc] initWithContentRect:frame
+                                                     styleMask:NSWindowStyleMaskTitled
+                                                       backing:NSBackingStoreBuffered
+                                                         defer:NO];
+            entry.window = [[NSWindow alloc] initWithContentRect:NSMakeRect(0, 0, 300, 150)
+                                                       styleMask:NSWindowStyleMaskTitled
+                                                         backing:NSBackingStoreBuffered
+                                                           defer:NO];
+            break;
+    
+        case STORM_KIND_TINY:
+            entry.window = [[NSWindow alloc] initWithContentRect:NSMakeRect(frame.origin.x, frame.origin.y, 16, 16)
+                                                       styleMask:NSWindowStyleMaskBorderless
+                                                         backing:NSBackingStoreBuffered
+                                                           defer:NO];
+            entry.window.alphaValue = 0.05;
+            break;
+    
+        default:
+            return;
+    }
+    
+    // ARC owns the windows
+    entry.window.releasedWhenClosed = NO;
+    entry.host.releasedWhenClosed = NO;
+    entry.window.title = [NSString stringWithFormat:@"Storm %d (%s)", self.created, storm_kind_names[kind]];
+    
+    entry.shownAt = mach_absolute_time();
+    if (entry.host) {
+        [entry.host makeKeyAndOrderFront:nil];
+        [entry.host beginSheet:entry.window completionHandler:nil];
+    } else {
+        [entry.window makeKeyAndOrderFront:nil];
+    }
+    
+    storm_results[kind].created++;
+    self.created++;
+    [self.pending addObject:entry];
+    
+    // Close after the lifetime so windows keep being destroyed during the storm
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.lifetime * NSEC_PER_SEC)),
+                   dispatch_get_main_queue(), ^{
+        if (entry.host) {
+            [entry.host endSheet:entry.window];
+            [entry.host close];
+        }
+        [entry.window close];
+    });
+}
+
+// Check every unresolved window with one WindowServer query
+- (void)pollWindows {
+    if (self.pending.count == 0) {
+        if (!self.spawnTimer) {
+            [self finish];
+        }
+        return;
+    }
+    
+    CFMutableArrayRef ids = CFArrayCreateMutable(NULL, (CFIndex)self.pending.count, NULL);
+    for (StormWindow *entry in self.pending) {
+        CFArrayAppendValue(ids, (const void *)(uintptr_t)entry.window.windowNumber);
+    }
+    
+    NSArray *descriptions = CFBridgingRelease(CGWindowListCreateDescriptionFromArray(ids));
+    CFRelease(ids);
+    
+    NSMutableDictionary<NSNumber *, NSDictionary *> *byID = [NSMutableDictionary dictionary];
+    for (NSDictionary *description in descriptions) {
+        NSNumber *number = description[(__bridge NSString *)kCGWindowNumber];
+        if (number) {
+            byID[number] = description;
+        }
+    }
+    
+    NSMutableArray<StormWindow *> *done = [NSMutableArray array];
+    for (StormWindow *entry in self.pending) {
+        double elapsed = elapsedMilliseconds(entry.shownAt);
+        NSDictionary *description = byID[@(entry.window.windowNumber)];
+    
+        int layer = [description[(__bridge NSString *)kCGWindowLayer] intValue];
+        NSNumber *sharing = description[(__bridge NSString *)kCGWindowSharingState];
+        bool modified = description && (layer == NSFloatingWindowLevel ||
+                                        (sharing && [sharing intValue] == kCGWindowSharingNone));
+    
+        storm_results_t *results = &storm_results[entry.kind];
+        if (modified) {
+            results->modified++;
+            if (results->sample_count < STORM_MAX_SAMPLES) {
+                results->samples[results->sample_count++] = elapsed;
+            }
+            [done addObject:entry];
+        } else if (!description || elapsed > STORM_MODIFY_TIMEOUT * 1000.0) {
+            // Closed or given up on before the library touched it
+            results->timed_out++;
+            [done addObject:entry];
+        }
+    }
+    
+    [self.pending removeObjectsInArray:done];
+}
+
+// Print this process's results and exit
+- (void)finish {
+    [self.pollTimer invalidate];
+    self.pollTimer = nil;
+    
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                        usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    
+    printf("[Storm %d] %-9s %8s %8s %8s %9s %9s %9s %9s\n", getpid(), "kind", "created", "modified",
+           "timeout", "p50 (ms)", "p95 (ms)", "p99 (ms)", "max (ms)");
+    for (int k = 0; k < STORM_KIND_COUNT; k++) {
+        storm_results_t *results = &storm_results[k];
+        double p50 = 0, p95 = 0, p99 = 0, max = 0;
+        if (results->sample_count > 0) {
+            qsort(results->samples, (size_t)results->sample_count, sizeof(double), compareDoubles);
+            p50 = results->samples[results->sample_count / 2];
+            p95 = results->samples[(results->sample_count * 95) / 100];
+            p99 = results->samples[(results->sample_count * 99) / 100];
+            max = results->samples[results->sample_count - 1];
+        }
+        printf("[Storm %d] %-9s %8d %8d %8d %9.1f %9.1f %9.1f %9.1f\n", getpid(), storm_kind_names[k],
+               results->created, results->modified, results->timed_out, p50, p95, p99, max);
+    }
+    
+    // ru_maxrss is in bytes on macOS
+    printf("[Storm %d] CPU time: %.2f s, peak RSS: %.1f MB\n", getpid(), cpuSeconds, usage.ru_maxrss / (1024.0 * 1024.0));
+    fflush(stdout);
+    
+    [NSApp terminate:nil];
+}
+
+@end
+
+// Start the other storm processes; they inherit the injected environment
+static int spawnStormChildren(const char *executable, int count, pid_t *pids) {
+    extern char **environ;
+    int started = 0;
+    
+    setenv("WM_STORM_CHILD", "1", 1);
+    for (int i = 0; i < count; i++) {
+        char *args[] = {(char *)executable, NULL};
+        if (posix_spawn(&pids[started], executable, NULL, NULL, args, environ) == 0) {
+            started++;
+        } else {
+            perror("posix_spawn");
+        }
+    }
+    unsetenv("WM_STORM_CHILD");
+    
+    return started;
+}
+
+int main(int __attribute__((unused)) argc, char *argv[]) {
+    @autoreleasepool {
+        mach_timebase_info(&timebase);
+    
+        int processes = stormSetting("WM_STORM_PROCESSES", STORM_DEFAULT_PROCESSES);
+        bool isChild = getenv("WM_STORM_CHILD") != NULL;
+    
+        pid_t children[64];
+        int childCount = 0;
+        if (!isChild && processes > 1) {
+            childCount = spawnStormChildren(argv[0], processes > 64 ? 63 : processes - 1, children);
+        }
+    
+        [NSApplication sharedApplication];
+        [NSApp setActivationPolicy:NSApplicationActivationPolicyRegular];
+    
+        StormController *controller = [[StormController alloc] init];
+        controller.rate = stormSetting("WM_STORM_RATE", STORM_DEFAULT_RATE);
+        controller.duration = stormSetting("WM_STORM_DURATION", STORM_DEFAULT_DURATION);
+        controller.lifetime = stormSetting("WM_STORM_LIFETIME", STORM_DEFAULT_LIFETIME);
+    
+        if (!isChild) {
+            printf("[Storm] %d process(es), %d windows/s each for %d s (lifetime %d s)\n",
+                   childCount + 1, controller.rate, controller.duration, controller.lifetime);
+        }
+    
+        // Run our own storm; finish terminates the app, so exit cleanly afterwards
+        [[NSNotificationCenter defaultCenter] addObserverForName:NSApplicationWillTerminateNotification
+                                                          object:nil
+                                                           queue:nil
+                                                      usingBlock:^(NSNotification * __attribute__((unused)) note) {
+            for (int i = 0; i < childCount; i++) {
+                waitpid(children[i], NULL, 0);
+            }
+        }];
+    
+        [controller start];
+        [NSApp run];
+    }
+    
+    return 0;
+}
@@ -4,6 +4,7 @@
 
 #import <Cocoa/Cocoa.h>
 #include "../core/common_types.h"
+#include "../tracker/window_rules.h"
 
 // CGS function pointers
 extern CGSConnectionID (*CGSDefaultConnection_ptr)(void);
@@ -13,6 +14,14 @@ extern OSStatus (*CGSSetWindowSharingState_ptr)(CGSConnectionID cid, CGSWindowID
 extern OSStatus (*CGSSetWindowTags_ptr)(CGSConnectionID cid, CGSWindowID wid, int *tags, int count);
 extern OSStatus (*CGSRegisterNotifyProc_ptr)(CGSNotifyConnectionProcPtr proc, int event, void *userdata);
 extern CGSConnectionID (*CGSGetWindowOwner_ptr)(CGSConnectionID cid, CGSWindowID wid);
+extern OSStatus (*CGSDisableUpdate_ptr)(CGSConnectionID cid);
+extern OSStatus (*CGSReenableUpdate_ptr)(CGSConnectionID cid);
+
+// Getters and tag clearing used to capture and restore original attributes
+extern OSStatus (*CGSGetWindowLevel_ptr)(CGSConnectionID cid, CGSWindowID wid, int *level);
+extern OSStatus (*CGSGetWindowSharingState_ptr)(CGSConnectionID cid, CGSWindowID wid, int *sharingState);
+extern OSStatus (*CGSGetWindowTags_ptr)(CGSConnectionID cid, CGSWindowID wid, int *tags, int tagSize);
+extern OSStatus (*CGSClearWindowTags_ptr)(CGSConnectionID cid, CGSWindowID wid, int *tags, int count);
 
 // Load CGS functions
 bool loadCGSFunctions(void);
@@ -20,9 +29,16 @@ bool loadCGSFunctions(void);
 // Window safety check functions
 bool isOwnerIDZeroWindow(CGSWindowID windowID);
 
+// Owner connection cache (positive and negative results, cleared on destroy)
+bool getWindowOwnerCached(CGSWindowID windowID, CGSConnectionID *ownerOut);
+void invalidateWindowOwner(CGSWindowID windowID);
+
 // Window info functions
 NSDictionary* getWindowInfoWithCGS(CGSWindowID windowID);
-window_class_t determineWindowClass(CGSWindowID windowID, NSDictionary *windowInfo);
+bool getWindowPropertiesWithCGS(CGSWindowID windowID, window_properties_t *props);
+void invalidateWindowProperties(CGSWindowID windowID);
+window_class_t determineWindowClass(CGSWindowID windowID, const window_properties_t *props);
+bool classifyWindowWithCGS(CGSWindowID windowID, window_verdict_t *verdict);
 bool isUtilityWindow(CGSWindowID windowID);
 bool isWindowReadyForModification(CGSWindowID windowID);
 bool isWindowInitialized(CGSWindowID windowID);
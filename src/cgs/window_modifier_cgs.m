@@ -1,44 +1,182 @@
 // window_modifier_cgs.m - Core Graphics Services functions
 #import "window_modifier_cgs.h"
+#import "../tracker/window_table.h"
+#import "../tracker/window_rules.h"
+#import "../tracker/window_stats.h"
+#import "../core/logging.h"
+#import "../core/trace.h"
 #import <dlfcn.h>
 #import <pthread.h>
 
-// Global safe window cache to prevent repeated memory access attempts to unsafe windows
-static NSMutableSet *knownUnsafeWindowIDs = nil;
-static pthread_mutex_t unsafeWindowMutex = PTHREAD_MUTEX_INITIALIZER;
+// Owner connection cache: window ID -> owner CGSConnectionID for both outcomes.
+// Owner 0 (or an exception while checking) marks the window as permanently unsafe.
+// The owner of a window never changes, so entries live until the window is destroyed.
+#define WINDOW_OWNER_CACHE_SIZE 2048 // Open-addressing slots (power of two)
+#define WINDOW_OWNER_CACHE_MAX_LOAD (WINDOW_OWNER_CACHE_SIZE * 3 / 4)
 
-// Initialize the safe window caching system
-static void initUnsafeWindowCache(void) {
-    static dispatch_once_t onceToken;
-    dispatch_once(&onceToken, ^{
-        knownUnsafeWindowIDs = [[NSMutableSet alloc] init];
-    });
+typedef struct {
+    CGSWindowID windowID;        // 0 when the slot is empty
+    CGSConnectionID ownerCID;    // Owner connection (0 = unsafe)
+} window_owner_entry_t;
+
+static window_owner_entry_t windowOwnerCache[WINDOW_OWNER_CACHE_SIZE];
+static int windowOwnerCacheCount = 0;
+static pthread_mutex_t windowOwnerMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Home slot of a window ID in the owner cache
+static uint32_t windowOwnerHome(CGSWindowID windowID) {
+    return (windowID * 2654435761u) & (WINDOW_OWNER_CACHE_SIZE - 1);
 }
 
-// Check if a window is known to be unsafe
-static bool isKnownUnsafeWindow(CGSWindowID windowID) {
-    if (!knownUnsafeWindowIDs) {
-        initUnsafeWindowCache();
+// Find a window's slot (caller holds windowOwnerMutex), returns -1 if absent
+static int windowOwnerFind(CGSWindowID windowID) {
+    uint32_t slot = windowOwnerHome(windowID);
+    
+    for (int probe = 0; probe < WINDOW_OWNER_CACHE_SIZE; probe++) {
+        if (windowOwnerCache[slot].windowID == windowID) {
+            return (int)slot;
+        }
+        if (windowOwnerCache[slot].windowID == 0) {
+            return -1;
+        }
+        slot = (slot + 1) & (WINDOW_OWNER_CACHE_SIZE - 1);
     }
     
-    pthread_mutex_lock(&unsafeWindowMutex);
-    bool result = [knownUnsafeWindowIDs containsObject:@(windowID)];
-    pthread_mutex_unlock(&unsafeWindowMutex);
+    return -1;
+}
+
+// Insert a window that isn't cached yet (caller holds windowOwnerMutex)
+static void windowOwnerInsert(CGSWindowID windowID, CGSConnectionID ownerCID) {
+    uint32_t slot = windowOwnerHome(windowID);
+    while (windowOwnerCache[slot].windowID != 0) {
+        slot = (slot + 1) & (WINDOW_OWNER_CACHE_SIZE - 1);
+    }
+    windowOwnerCache[slot].windowID = windowID;
+    windowOwnerCache[slot].ownerCID = ownerCID;
+    windowOwnerCacheCount++;
+}
+
+// Drop every resolved owner but keep the unsafe marks, which can't be looked up
+// again without risk (caller holds windowOwnerMutex)
+static void windowOwnerEvictResolved(void) {
+    static window_owner_entry_t unsafe[WINDOW_OWNER_CACHE_SIZE];
+    int unsafeCount = 0;
+    
+    for (int i = 0; i < WINDOW_OWNER_CACHE_SIZE; i++) {
+        if (windowOwnerCache[i].windowID != 0 && windowOwnerCache[i].ownerCID == 0) {
+            unsafe[unsafeCount++] = windowOwnerCache[i];
+        }
+    }
     
-    return result;
+    memset(windowOwnerCache, 0, sizeof(windowOwnerCache));
+    windowOwnerCacheCount = 0;
+    for (int i = 0; i < unsafeCount; i++) {
+        windowOwnerInsert(unsafe[i].windowID, 0);
+    }
 }
 
-// Mark a window as unsafe
-static void markWindowAsUnsafe(CGSWindowID windowID) {
-    if (!knownUnsafeWindowIDs) {
-        initUnsafeWindowCache();
+// Look up a cached owner
+static bool lookupCachedWindowOwner(CGSWindowID windowID, CGSConnectionID *ownerOut) {
+    pthread_mutex_lock(&windowOwnerMutex);
+    int slot = windowOwnerFind(windowID);
+    if (slot >= 0 && ownerOut) {
+        *ownerOut = windowOwnerCache[slot].ownerCID;
+    }
+    pthread_mutex_unlock(&windowOwnerMutex);
+    
+    return slot >= 0;
+}
+
+// Record a window's owner
+static void storeCachedWindowOwner(CGSWindowID windowID, CGSConnectionID ownerCID) {
+    pthread_mutex_lock(&windowOwnerMutex);
+    
+    int existing = windowOwnerFind(windowID);
+    if (existing >= 0) {
+        windowOwnerCache[existing].ownerCID = ownerCID;
+        pthread_mutex_unlock(&windowOwnerMutex);
+        return;
+    }
+    
+    // Resolved owners are only a cache: drop them rather than let probe chains grow
+    if (windowOwnerCacheCount >= WINDOW_OWNER_CACHE_MAX_LOAD) {
+        windowOwnerEvictResolved();
+    }
+    
+    // Unsafe marks alone fill the table; leave this window to the registry mark
+    if (windowOwnerCacheCount >= WINDOW_OWNER_CACHE_MAX_LOAD) {
+        pthread_mutex_unlock(&windowOwnerMutex);
+        WM_LOG_WARN("[CGS] Owner cache full of unsafe windows, not caching window %d\n", windowID);
+        return;
+    }
+    
+    windowOwnerInsert(windowID, ownerCID);
+    
+    pthread_mutex_unlock(&windowOwnerMutex);
+}
+
+// Forget a window's owner (on destroy), using backward-shift deletion
+void invalidateWindowOwner(CGSWindowID windowID) {
+    pthread_mutex_lock(&windowOwnerMutex);
+    
+    int found = windowOwnerFind(windowID);
+    if (found < 0) {
+        pthread_mutex_unlock(&windowOwnerMutex);
+        return;
+    }
+    
+    uint32_t mask = WINDOW_OWNER_CACHE_SIZE - 1;
+    uint32_t hole = (uint32_t)found;
+    uint32_t next = (hole + 1) & mask;
+    
+    while (windowOwnerCache[next].windowID != 0) {
+        uint32_t home = windowOwnerHome(windowOwnerCache[next].windowID);
+        
+        // Move the entry back if the hole lies on its probe path
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            windowOwnerCache[hole] = windowOwnerCache[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
     }
     
-    pthread_mutex_lock(&unsafeWindowMutex);
-    [knownUnsafeWindowIDs addObject:@(windowID)];
-    pthread_mutex_unlock(&unsafeWindowMutex);
+    windowOwnerCache[hole].windowID = 0;
+    windowOwnerCache[hole].ownerCID = 0;
+    windowOwnerCacheCount--;
+    
+    pthread_mutex_unlock(&windowOwnerMutex);
+}
+
+// Check if a window is known to be unsafe
+static bool isKnownUnsafeWindow(CGSWindowID windowID) {
+    CGSConnectionID ownerCID;
+    return lookupCachedWindowOwner(windowID, &ownerCID) && ownerCID == 0;
+}
+
+// Mark a window as unsafe
+static void markWindowAsUnsafe(CGSWindowID windowID) {
+    storeCachedWindowOwner(windowID, 0);
     
-    printf("[CGS] Marked window %d as permanently unsafe\n", windowID);
+    WM_LOG_DEBUG("[CGS] Marked window %d as permanently unsafe\n", windowID);
+}
+
+// Short-lived cache of parsed window descriptions, so one notification doesn't
+// pay for several CGSCopyWindowDescriptionList round-trips
+#define WINDOW_PROPS_CACHE_SIZE 256 // Direct-mapped slots (power of two)
+static const CFAbsoluteTime WINDOW_PROPS_TTL_SECONDS = 0.1;
+
+typedef struct {
+    CGSWindowID windowID;        // 0 when the slot is empty
+    CFAbsoluteTime fetched_at;   // When the description was fetched
+    window_properties_t props;   // Parsed properties
+} window_props_cache_entry_t;
+
+static window_props_cache_entry_t windowPropsCache[WINDOW_PROPS_CACHE_SIZE];
+static pthread_mutex_t windowPropsMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Slot for a window ID in the properties cache
+static uint32_t windowPropsSlot(CGSWindowID windowID) {
+    return (windowID * 2654435761u) & (WINDOW_PROPS_CACHE_SIZE - 1);
 }
 
 // CGS Function pointers
@@ -48,24 +186,24 @@ OSStatus (*CGSSetWindowLevel_ptr)(CGSConnectionID cid, CGSWindowID wid, int leve
 OSStatus (*CGSSetWindowSharingState_ptr)(CGSConnectionID cid, CGSWindowID wid, int sharingState) = NULL;
 OSStatus (*CGSSetWindowTags_ptr)(CGSConnectionID cid, CGSWindowID wid, int *tags, int count) = NULL;
 OSStatus (*CGSRegisterNotifyProc_ptr)(CGSNotifyConnectionProcPtr proc, int event, void *userdata) = NULL;
+OSStatus (*CGSDisableUpdate_ptr)(CGSConnectionID cid) = NULL;
+OSStatus (*CGSReenableUpdate_ptr)(CGSConnectionID cid) = NULL;
+OSStatus (*CGSClearWindowTags_ptr)(CGSConnectionID cid, CGSWindowID wid, int *tags, int count) = NULL;
+OSStatus (*CGSGetWindowTags_ptr)(CGSConnectionID cid, CGSWindowID wid, int *tags, int tagSize) = NULL;
+OSStatus (*CGSGetWindowLevel_ptr)(CGSConnectionID cid, CGSWindowID wid, int *level) = NULL;
+OSStatus (*CGSGetWindowSharingState_ptr)(CGSConnectionID cid, CGSWindowID wid, int *sharingState) = NULL;
 
 // Additional CGS function pointers not exposed in header
-static OSStatus (*CGSClearWindowTags_ptr)(CGSConnectionID cid, CGSWindowID wid, int *tags, int count) = NULL;
-static OSStatus (*CGSGetWindowTags_ptr)(CGSConnectionID cid, CGSWindowID wid, int *tags, int *count) = NULL;
-static OSStatus (*CGSGetWindowLevel_ptr)(CGSConnectionID cid, CGSWindowID wid, int *level) = NULL;
 CGSConnectionID (*CGSGetWindowOwner_ptr)(CGSConnectionID cid, CGSWindowID wid) = NULL;
 static OSStatus (*CGSGetConnectionPSN_ptr)(CGSConnectionID cid, ProcessSerialNumber *psn) = NULL;
 static CFArrayRef (*CGSCopyWindowDescriptionList_ptr)(CGSConnectionID cid, CGSWindowID wid) = NULL;
 static CGSConnectionID (*CGSGetConnectionID_ptr)(void) = NULL;
 
-// Global window state dictionary (windowID -> window_init_state_t)
-CFMutableDictionaryRef window_states = NULL;
-
 // Load CGS functions
 bool loadCGSFunctions(void) {
     void *handle = dlopen("/System/Library/Frameworks/CoreGraphics.framework/CoreGraphics", RTLD_LAZY);
     if (!handle) {
-        printf("[CGS] Error: Failed to open CoreGraphics framework\n");
+        WM_LOG_ERROR("[CGS] Error: Failed to open CoreGraphics framework\n");
         return false;
     }
     
@@ -80,6 +218,11 @@ bool loadCGSFunctions(void) {
     CGSSetWindowTags_ptr = dlsym(handle, "CGSSetWindowTags");
     CGSClearWindowTags_ptr = dlsym(handle, "CGSClearWindowTags");
     CGSGetWindowTags_ptr = dlsym(handle, "CGSGetWindowTags");
+    CGSGetWindowSharingState_ptr = dlsym(handle, "CGSGetWindowSharingState");
+    
+    // Optional update transaction functions used by batch modification
+    CGSDisableUpdate_ptr = dlsym(handle, "CGSDisableUpdate");
+    CGSReenableUpdate_ptr = dlsym(handle, "CGSReenableUpdate");
     
     // Load CGS functions for window detection
     CGSRegisterNotifyProc_ptr = dlsym(handle, "CGSRegisterNotifyProc");
@@ -95,65 +238,99 @@ bool loadCGSFunctions(void) {
                     CGSSetWindowSharingState_ptr != NULL && 
                     CGSSetWindowTags_ptr != NULL);
     
-    printf("[CGS] Core functions loaded: %s\n", success ? "Success" : "Failed");
+    WM_LOG_INFO("[CGS] Core functions loaded: %s\n", success ? "Success" : "Failed");
     
     bool detection_success = (CGSRegisterNotifyProc_ptr != NULL && 
                              CGSGetOnScreenWindowList_ptr != NULL);
     
-    printf("[CGS] Detection functions loaded: %s\n", detection_success ? "Success" : "Failed");
+    WM_LOG_INFO("[CGS] Detection functions loaded: %s\n", detection_success ? "Success" : "Failed");
     
     return success;
 }
 
-// Check if a window has owner ID 0 (fundamental boundary we should not cross)
-bool isOwnerIDZeroWindow(CGSWindowID windowID) {
-    // First check our cache of known unsafe windows
-    if (isKnownUnsafeWindow(windowID)) {
+// Resolve a window's owner connection, asking WindowServer only once per window.
+// Returns false if ownership can't be determined; *ownerOut is 0 for unsafe windows.
+bool getWindowOwnerCached(CGSWindowID windowID, CGSConnectionID *ownerOut) {
+    CGSConnectionID ownerCID = 0;
+    
+    if (lookupCachedWindowOwner(windowID, &ownerCID)) {
+        if (ownerOut) {
+            *ownerOut = ownerCID;
+        }
         return true;
     }
     
     if (!CGSGetWindowOwner_ptr || !CGSDefaultConnection_ptr) {
-        // If we can't check ownership, assume it's unsafe
-        return true;
+        return false;
     }
     
     @try {
         CGSConnectionID cid = CGSDefaultConnection_ptr();
-        CGSConnectionID ownerCID = CGSGetWindowOwner_ptr(cid, windowID);
+        ownerCID = CGSGetWindowOwner_ptr(cid, windowID);
         
         // Windows with owner ID 0 are unsafe
         if (ownerCID == 0) {
-            // Add to cache for future quick checks
+            WM_LOG_DEBUG("[CGS] Detected owner ID 0 for window %d\n", windowID);
             markWindowAsUnsafe(windowID);
-            printf("[CGS] Detected owner ID 0 for window %d\n", windowID);
-            return true;
+        } else {
+            storeCachedWindowOwner(windowID, ownerCID);
         }
-        
-        return false;
     }
     @catch (NSException *exception) {
-        // If we got an exception checking ownership, assume it's unsafe
-        printf("[CGS] Exception checking window ownership: %s\n", 
-              [[exception description] UTF8String]);
+        // If we got an exception checking ownership, treat it as unsafe
+        WM_LOG_ERROR("[CGS] Exception checking window ownership: %s\n", 
+                    [[exception description] UTF8String]);
         markWindowAsUnsafe(windowID);
+        ownerCID = 0;
+    }
+    
+    if (ownerOut) {
+        *ownerOut = ownerCID;
+    }
+    return true;
+}
+
+// Check if a window has owner ID 0 (fundamental boundary we should not cross)
+bool isOwnerIDZeroWindow(CGSWindowID windowID) {
+    CGSConnectionID ownerCID = 0;
+    
+    // If we can't check ownership, assume it's unsafe
+    if (!getWindowOwnerCached(windowID, &ownerCID)) {
         return true;
     }
+    
+    return ownerCID == 0;
 }
 
+static CFDictionaryRef copyWindowDescriptionWithCGS(CGSWindowID windowID);
+
 // Get window information using CGS with enhanced safety checks
 NSDictionary *getWindowInfoWithCGS(CGSWindowID windowID) {
+    wm_trace_id_t span = wm_trace_make_id();
+    WM_TRACE_BEGIN(span, "GetWindowInfo", "window %d", windowID);
+    CFDictionaryRef description = copyWindowDescriptionWithCGS(windowID);
+    WM_TRACE_END(span, "GetWindowInfo", "found %d", description != NULL);
+    
+    return description ? CFBridgingRelease(description) : nil;
+}
+
+// Window description lookup (+1 reference, NULL if unavailable or unsafe).
+// The reply is the one allocation the WindowServer API forces on us; it is
+// left out of the hot path allocation count, and callers keep it out of the
+// autorelease pool so nothing else is allocated on its behalf.
+static CFDictionaryRef copyWindowDescriptionWithCGS(CGSWindowID windowID) {
     if (!CGSCopyWindowDescriptionList_ptr || !CGSDefaultConnection_ptr) {
-        return nil;
+        return NULL;
     }
     
     // First check if this is a known unsafe window
     if (isKnownUnsafeWindow(windowID)) {
-        return nil;
+        return NULL;
     }
     
     // Then check if it has owner ID 0
     if (isOwnerIDZeroWindow(windowID)) {
-        return nil;
+        return NULL;
     }
     
     // Extra safety: try-catch all CGS operations
@@ -162,24 +339,26 @@ NSDictionary *getWindowInfoWithCGS(CGSWindowID windowID) {
         CFArrayRef windowDescriptions = NULL;
         
         @try {
+            int depth = wm_hot_path_suspend();
             windowDescriptions = CGSCopyWindowDescriptionList_ptr(cid, windowID);
+            wm_hot_path_resume(depth);
             
             if (!windowDescriptions || CFArrayGetCount(windowDescriptions) < 1) {
                 if (windowDescriptions) {
                     CFRelease(windowDescriptions);
                 }
-                return nil;
+                return NULL;
             }
             
-            NSDictionary *windowInfo = (NSDictionary *)CFArrayGetValueAtIndex(windowDescriptions, 0);
-            CFRetain((__bridge CFTypeRef)windowInfo);
+            CFDictionaryRef description = (CFDictionaryRef)CFArrayGetValueAtIndex(windowDescriptions, 0);
+            CFRetain(description);
             CFRelease(windowDescriptions);
             
-            return CFBridgingRelease((__bridge_retained CFTypeRef)windowInfo);
+            return description;
         }
         @catch (NSException *exception) {
-            printf("[CGS] Exception while getting window info: %s\n", 
-                  [[exception description] UTF8String]);
+            WM_LOG_ERROR("[CGS] Exception while getting window info: %s\n", 
+                        [[exception description] UTF8String]);
             
             // Mark this window as unsafe for future checks
             markWindowAsUnsafe(windowID);
@@ -187,88 +366,122 @@ NSDictionary *getWindowInfoWithCGS(CGSWindowID windowID) {
             if (windowDescriptions) {
                 CFRelease(windowDescriptions);
             }
-            return nil;
+            return NULL;
         }
     }
     @catch (NSException *exception) {
-        printf("[CGS] Outer exception in getWindowInfoWithCGS: %s\n",
-              [[exception description] UTF8String]);
+        WM_LOG_ERROR("[CGS] Outer exception in getWindowInfoWithCGS: %s\n",
+                    [[exception description] UTF8String]);
         
         // Mark this window as unsafe for future checks
         markWindowAsUnsafe(windowID);
-        return nil;
+        return NULL;
     }
 }
 
-// Determine window class from CGS properties
-window_class_t determineWindowClass(CGSWindowID __attribute__((unused)) windowID, NSDictionary *windowInfo) {
-    if (!windowInfo) {
-        return WINDOW_CLASS_UNKNOWN;
-    }
-    
-    // Extract window metadata
-    NSNumber *alpha = windowInfo[@"kCGSWindowAlpha"];
-    NSNumber *width = windowInfo[@"kCGSWindowWidth"];
-    NSNumber *height = windowInfo[@"kCGSWindowHeight"];
-    NSString *windowLayer = windowInfo[@"kCGSWindowLayer"];
-    NSNumber *windowLevel = windowInfo[@"kCGSWindowLevel"];
-    NSNumber *styleMask = windowInfo[@"kCGSWindowStyleMask"];
-    
-    // Non-standard window levels indicate system or panel windows
-    if (windowLevel) {
-        int level = [windowLevel intValue];
-        if (level > 0) {
-            return (level > 3) ? WINDOW_CLASS_SYSTEM : WINDOW_CLASS_PANEL;
-        }
-    }
-    
-    // Layer detection (non-zero layers are usually utility windows)
-    if (windowLayer && [windowLayer intValue] != 0) {
-        return WINDOW_CLASS_HELPER;
+// Parse the properties we classify on out of a window description
+static void parseWindowProperties(NSDictionary *windowInfo, window_properties_t *props) {
+    memset(props, 0, sizeof(*props));
+    
+    id alpha = windowInfo[@"kCGSWindowAlpha"];
+    id width = windowInfo[@"kCGSWindowWidth"];
+    id height = windowInfo[@"kCGSWindowHeight"];
+    id layer = windowInfo[@"kCGSWindowLayer"];
+    id level = windowInfo[@"kCGSWindowLevel"];
+    id styleMask = windowInfo[@"kCGSWindowStyleMask"];
+    
+    if (alpha) {
+        props->alpha = [alpha doubleValue];
+        props->present |= WINDOW_PROP_HAS_ALPHA;
     }
-    
-    // Size detection (very small windows are helper/utility windows)
-    // Use a more lenient size requirement for standard macOS apps
     if (width && height) {
-        if ([width intValue] < 50 || [height intValue] < 50) {
-            return WINDOW_CLASS_HELPER;
-        }
+        props->present |= WINDOW_PROP_HAS_SIZE;
     }
-    
-    // Visibility detection (invisible or nearly invisible windows)
-    if (alpha && [alpha doubleValue] < 0.3) {
-        return WINDOW_CLASS_HELPER;
+    props->width = width ? [width intValue] : 0;
+    props->height = height ? [height intValue] : 0;
+    if (layer) {
+        props->layer = [layer intValue];
+        props->present |= WINDOW_PROP_HAS_LAYER;
+    }
+    if (level) {
+        props->level = [level intValue];
+        props->present |= WINDOW_PROP_HAS_LEVEL;
     }
-    
-    // Use style mask bits for classification if available
     if (styleMask) {
-        uint32_t style = [styleMask unsignedIntValue];
-        
-        // Check for utility window style
-        if (style & 0x8) {  // NSWindowStyleMaskUtilityWindow equivalent
-            return WINDOW_CLASS_PANEL;
-        }
-        
-        // Check for sheet style
-        if (style & 0x200) { // NSWindowStyleMaskSheet equivalent
-            return WINDOW_CLASS_SHEET;
-        }
-        
-        // Standard window with title bar
-        if (style & 0x1) {  // NSWindowStyleMaskTitled equivalent
-            return WINDOW_CLASS_STANDARD;
-        }
+        props->style_mask = [styleMask unsignedIntValue];
+        props->present |= WINDOW_PROP_HAS_STYLE_MASK;
+    }
+    if (windowInfo[@"kCGSWindowParentID"] != nil) {
+        props->present |= WINDOW_PROP_HAS_PARENT;
+    }
+}
+
+// Get parsed window properties, served from the short-TTL cache when possible
+bool getWindowPropertiesWithCGS(CGSWindowID windowID, window_properties_t *props) {
+    if (windowID == 0 || !props) {
+        return false;
     }
     
-    // Default to standard if it passes basic size/visibility tests
-    if ((width && [width intValue] >= 100) && 
-        (height && [height intValue] >= 100) && 
-        (alpha && [alpha doubleValue] >= 0.3)) {
-        return WINDOW_CLASS_STANDARD;
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    uint32_t slot = windowPropsSlot(windowID);
+    
+    pthread_mutex_lock(&windowPropsMutex);
+    window_props_cache_entry_t *entry = &windowPropsCache[slot];
+    if (entry->windowID == windowID && now - entry->fetched_at < WINDOW_PROPS_TTL_SECONDS) {
+        *props = entry->props;
+        pthread_mutex_unlock(&windowPropsMutex);
+        return true;
+    }
+    pthread_mutex_unlock(&windowPropsMutex);
+    
+    // Miss: one WindowServer round-trip, then cache the parsed result. The
+    // description is released here rather than autoreleased.
+    wm_trace_id_t span = wm_trace_make_id();
+    WM_TRACE_BEGIN(span, "GetWindowInfo", "window %d", windowID);
+    CFDictionaryRef description = copyWindowDescriptionWithCGS(windowID);
+    WM_TRACE_END(span, "GetWindowInfo", "found %d", description != NULL);
+    if (!description) {
+        return false;
     }
     
-    // When in doubt, treat as helper window
-    return WINDOW_CLASS_HELPER;
+    parseWindowProperties((__bridge NSDictionary *)description, props);
+    CFRelease(description);
+    
+    pthread_mutex_lock(&windowPropsMutex);
+    entry = &windowPropsCache[slot];
+    entry->windowID = windowID;
+    entry->fetched_at = now;
+    entry->props = *props;
+    pthread_mutex_unlock(&windowPropsMutex);
+    
+    return true;
+}
+
+// Drop a window's cached properties (on resize/update notifications)
+void invalidateWindowProperties(CGSWindowID windowID) {
+    uint32_t slot = windowPropsSlot(windowID);
+    
+    pthread_mutex_lock(&windowPropsMutex);
+    if (windowPropsCache[slot].windowID == windowID) {
+        windowPropsCache[slot].windowID = 0;
+    }
+    pthread_mutex_unlock(&windowPropsMutex);
+}
+
+// Determine window class from CGS properties
+window_class_t determineWindowClass(CGSWindowID __attribute__((unused)) windowID, const window_properties_t *props) {
+    return window_rules_classify(props).window_class;
+}
+
+// Classify a window and check its readiness in one pass over its properties
+bool classifyWindowWithCGS(CGSWindowID windowID, window_verdict_t *verdict) {
+    window_properties_t props;
+    if (!getWindowPropertiesWithCGS(windowID, &props)) {
+        return false;
+    }
+    
+    *verdict = window_rules_classify(&props);
+    return true;
 }
 
 // Check if a window is ready for modification
@@ -277,96 +490,33 @@ bool isWindowReadyForModification(CGSWindowID windowID) {
         return true; // If we can't check, assume it's ready
     }
     
-    NSDictionary *windowInfo = getWindowInfoWithCGS(windowID);
-    if (!windowInfo) {
+    window_verdict_t verdict;
+    if (!classifyWindowWithCGS(windowID, &verdict)) {
         return false; // Can't get window info, not ready
     }
     
-    // Check window properties
-    NSNumber *alpha = windowInfo[@"kCGSWindowAlpha"];
-    NSString *windowLayer = windowInfo[@"kCGSWindowLayer"];
-    NSNumber *width = windowInfo[@"kCGSWindowWidth"];
-    NSNumber *height = windowInfo[@"kCGSWindowHeight"];
-    
-    // Basic requirements - more lenient size check for standard macOS apps
-    BOOL isVisible = [alpha doubleValue] > 0.0;
-    BOOL isMainLayer = [windowLayer intValue] == 0;
-    BOOL hasReasonableSize = [width intValue] > 50 && [height intValue] > 50;
-    
-    return isVisible && isMainLayer && hasReasonableSize;
+    return verdict.ready;
 }
 
 // Check if a window should be treated as a utility window (not a main application window)
 bool isUtilityWindow(CGSWindowID windowID) {
     // First, check if we have this window in our tracking system
-    if (window_states) {
-        NSNumber *key = @(windowID);
-        if (CFDictionaryContainsKey(window_states, (__bridge CFNumberRef)key)) {
-            window_init_state_t *state = (window_init_state_t *)CFDictionaryGetValue(
-                window_states, (__bridge CFNumberRef)key);
-            
-            // Use the window classification to determine if it's a utility window
-            switch (state->window_class) {
-                // Windows that are considered utility/helper windows
-                case WINDOW_CLASS_PANEL:
-                case WINDOW_CLASS_SHEET:
-                case WINDOW_CLASS_SYSTEM:
-                case WINDOW_CLASS_HELPER:
-                case WINDOW_CLASS_POPUP:
-                case WINDOW_CLASS_MENU:
-                case WINDOW_CLASS_TOOLBAR:
-                case WINDOW_CLASS_SPLASH:
-                    return true;
-                    
-                // Windows that are considered standard/main application windows
-                case WINDOW_CLASS_NORMAL:
-                case WINDOW_CLASS_UTILITY:
-                case WINDOW_CLASS_DIALOG:
-                case WINDOW_CLASS_STANDARD:
-                    return false;
-                    
-                case WINDOW_CLASS_UNKNOWN:
-                    // Fall through to legacy checks for unknown classification
-                    break;
-            }
-        }
-    }
+    window_class_t windowClass = window_table_get_class(windowID);
     
-    // Fall back to legacy property-based detection if not tracked or unknown class
-    NSDictionary *windowInfo = getWindowInfoWithCGS(windowID);
-    if (!windowInfo) {
-        return false;
+    if (windowClass != WINDOW_CLASS_UNKNOWN) {
+        return window_class_is_utility(windowClass);
     }
     
-    // Extract window metadata
-    NSNumber *alpha = windowInfo[@"kCGSWindowAlpha"];
-    NSNumber *width = windowInfo[@"kCGSWindowWidth"];
-    NSNumber *height = windowInfo[@"kCGSWindowHeight"];
-    NSString *windowLayer = windowInfo[@"kCGSWindowLayer"];
-    
-    // Visibility, size, and layer checks - more lenient for standard macOS apps
-    if ((windowLayer && [windowLayer intValue] != 0) ||
-        ([width intValue] < 50 || [height intValue] < 50) ||
-        ([alpha doubleValue] < 0.3)) {
-        return true;
+    // Not tracked or not classified yet, classify from its current properties
+    window_verdict_t verdict;
+    if (!classifyWindowWithCGS(windowID, &verdict)) {
+        return false;
     }
     
-    return false;
+    return window_class_is_utility(verdict.window_class);
 }
 
 // Check if a window is fully initialized
 bool isWindowInitialized(CGSWindowID windowID) {
-    if (!window_states) {
-        return false;
-    }
-    
-    NSNumber *key = @(windowID);
-    if (!CFDictionaryContainsKey(window_states, (__bridge CFNumberRef)key)) {
-        return false;
-    }
-    
-    window_init_state_t *state = (window_init_state_t *)CFDictionaryGetValue(
-        window_states, (__bridge CFNumberRef)key);
-    
-    return state->is_initialized;
+    return window_table_is_initialized(windowID);
 }
@@ -93,11 +93,32 @@ typedef struct {
     bool nonActivating;    // Window doesn't activate when clicked
     bool ignoreExpose;     // Window ignores expose events
     bool allowsMoving;     // Window can be moved by user
+    bool excludeFromCapture; // Window is hidden from screen recording
     int level;             // Window level (z-order)
     float opacity;         // Window opacity (0.0-1.0)
 } WindowModificationOptions;
 
-// Window initialization state tracking
+// Presence flags for parsed window properties
+#define WINDOW_PROP_HAS_ALPHA                  (1 << 0)
+#define WINDOW_PROP_HAS_SIZE                   (1 << 1)
+#define WINDOW_PROP_HAS_LAYER                  (1 << 2)
+#define WINDOW_PROP_HAS_LEVEL                  (1 << 3)
+#define WINDOW_PROP_HAS_STYLE_MASK             (1 << 4)
+#define WINDOW_PROP_HAS_PARENT                 (1 << 5)
+
+// Window properties parsed from a CGS window description
+// Missing values are zero; check the presence flags where absence matters.
+typedef struct {
+    double alpha;          // Window alpha (kCGSWindowAlpha)
+    int width;             // Window width (kCGSWindowWidth)
+    int height;            // Window height (kCGSWindowHeight)
+    int layer;             // Window layer (kCGSWindowLayer)
+    int level;             // Window level (kCGSWindowLevel)
+    uint32_t style_mask;   // Style mask bits (kCGSWindowStyleMask)
+    uint32_t present;      // WINDOW_PROP_HAS_* flags
+} window_properties_t;
+
+// Window initialization state tracking (record copied out of the window table)
 typedef struct {
     CGSWindowID window_id;
     window_class_t window_class;
@@ -106,6 +127,19 @@ typedef struct {
     time_t first_seen;
 } window_init_state_t;
 
+// Window attributes captured before the first modification (reversible mode)
+#define WINDOW_ORIGINAL_HAS_LEVEL           (1 << 0)
+#define WINDOW_ORIGINAL_HAS_SHARING         (1 << 1)
+#define WINDOW_ORIGINAL_HAS_TAGS            (1 << 2)
+#define WINDOW_ORIGINAL_PREVENTS_ACTIVATION (1 << 3)   // Tag was already set
+
+typedef struct {
+    CGSWindowID window_id;
+    int level;             // Original window level
+    int sharing_state;     // Original kCGSWindowSharing*Value
+    uint32_t flags;        // WINDOW_ORIGINAL_* flags
+} window_original_state_t;
+
 // Window tracking information
 typedef struct {
     CGSWindowID windowID;  // Window ID in CoreGraphics Services
@@ -4,51 +4,70 @@
 #include <string.h>  // For strerror()
 #include <unistd.h>
 #include <dlfcn.h>
-#include <pthread.h>
 #include <stdbool.h>
 #include <mach-o/dyld.h>
+#include <mach/mach_time.h>
 
 #include "common_types.h" // Centralized type definitions
+#include "logging.h"
+#include "process_role.h"
+#include "trace.h"
 
 // Forward declarations for external components
 extern bool init_window_classifier(void);
+extern bool window_rules_init(void);
 extern void cleanup_window_classifier(void);
-extern void* window_modifier_main(void* arg);
+extern void window_modifier_eager_init(void);
+extern void window_modifier_lazy_init(void);
+extern void stopWindowModifier(void);
+extern size_t restoreWindowModifications(void);
 
 // Global state
-static pthread_t window_modifier_thread = 0;
 static bool injection_initialized = false;
 
 // Forward declarations
 static void cleanup_injection(void);
 
+// Check if lazy initialization was requested (WM_LAZY_INIT set by the injector)
+static bool lazy_init_requested(void) {
+    const char* value = getenv("WM_LAZY_INIT");
+    return value && value[0] != '\0' && strcmp(value, "0") != 0;
+}
+
+// Milliseconds elapsed since a mach_absolute_time() reading
+static double elapsed_ms(uint64_t start) {
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return (double)(mach_absolute_time() - start) * timebase.numer / timebase.denom / 1e6;
+}
+
 // Print basic process info for diagnostics
 static void print_process_info(void) {
     // Get executable path
     char path[1024];
     uint32_t size = sizeof(path);
     if (_NSGetExecutablePath(path, &size) == 0) {
-        printf("[Injector] Process path: %s\n", path);
+        WM_LOG_INFO("[Injector] Process path: %s\n", path);
     } else {
-        printf("[Injector] Failed to get process path\n");
+        WM_LOG_ERROR("[Injector] Failed to get process path\n");
     }
     
     // Get process ID and parent
     pid_t pid = getpid();
     pid_t ppid = getppid();
-    printf("[Injector] Process ID: %d, Parent: %d\n", pid, ppid);
+    WM_LOG_INFO("[Injector] Process ID: %d, Parent: %d\n", pid, ppid);
     
     // Get executable name
     const char* processName = getprogname();
-    printf("[Injector] Process name: %s\n", processName);
+    WM_LOG_INFO("[Injector] Process name: %s\n", processName);
 }
 
 // Register for cleanup during process termination
 static void register_cleanup(void) {
-    // Register our cleanup function with atexit
+    // Register our cleanup function with atexit (also runs if the dylib is unloaded)
     atexit(cleanup_injection);
     
-    printf("[Injector] Cleanup handler registered\n");
+    WM_LOG_INFO("[Injector] Cleanup handler registered\n");
 }
 
 // Clean up resources before termination
@@ -57,75 +76,78 @@ static void cleanup_injection(void) {
         return;
     }
     
-    printf("[Injector] Performing injection cleanup\n");
+    WM_LOG_INFO("[Injector] Performing injection cleanup\n");
     
-    // Stop window modifier thread
-    if (window_modifier_thread != 0) {
-        pthread_cancel(window_modifier_thread);
-        printf("[Injector] Window modifier thread stopped\n");
+    // Reversible mode: put modified windows back before the scheduler goes away
+    size_t restored = restoreWindowModifications();
+    if (restored > 0) {
+        WM_LOG_INFO("[Injector] Restored %zu window(s)\n", restored);
     }
     
+    // Stop the window modifier scheduler
+    stopWindowModifier();
+    WM_LOG_INFO("[Injector] Window modifier stopped\n");
+    
     // Clean up window classifier
     cleanup_window_classifier();
     
     injection_initialized = false;
-    printf("[Injector] Injection cleanup complete\n");
+    WM_LOG_INFO("[Injector] Injection cleanup complete\n");
+    
+    // Write out anything still buffered before the process exits
+    wm_log_flush();
 }
 
 // Initialize the window modifier with enhanced error handling
 static bool init_window_modifier(void) {
     // Initialize window classifier
     if (!init_window_classifier()) {
-        printf("[Injector] Failed to initialize window classifier\n");
+        WM_LOG_ERROR("[Injector] Failed to initialize window classifier\n");
         return false;
     }
     
-    // Create window modifier thread with better error recovery
-    pthread_attr_t attr;
-    if (pthread_attr_init(&attr) != 0) {
-        printf("[Injector] Failed to initialize thread attributes\n");
-        cleanup_window_classifier();
-        return false;
-    }
-    
-    // Set thread as detached to avoid resource leaks
-    if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) != 0) {
-        printf("[Injector] Failed to set thread as detached\n");
-        pthread_attr_destroy(&attr);
-        cleanup_window_classifier();
-        return false;
-    }
-    
-    // Set higher thread priority for better responsiveness
-    struct sched_param param;
-    param.sched_priority = 50; // Mid-range priority
-    if (pthread_attr_setschedparam(&attr, &param) != 0) {
-        printf("[Injector] Warning: Failed to set thread priority (non-fatal)\n");
-        // Continue despite this error as it's not critical
-    }
-    
-    // Create the thread
-    int result = pthread_create(&window_modifier_thread, &attr, window_modifier_main, NULL);
-    pthread_attr_destroy(&attr);
-    
-    if (result != 0) {
-        printf("[Injector] Failed to create window modifier thread: %d (%s)\n", 
-               result, strerror(result));
-        cleanup_window_classifier();
-        return false;
-    }
+    // Services start on a user-initiated queue; the scheduler sets up its own QoS queues
+    window_modifier_eager_init();
     
-    printf("[Injector] Window modifier thread created\n");
+    WM_LOG_INFO("[Injector] Window modifier services starting\n");
     return true;
 }
 
 // Main entry point for injected code
 __attribute__((constructor))
 static void injection_entry(void) {
+    uint64_t start = mach_absolute_time();
+    
+    // Read the log level first so everything below is filtered
+    wm_log_init();
+    wm_trace_init();
+    
+    // Targeting rules from the injector (WM_RULES_FILE / WM_RULES), compiled once;
+    // they can also reassign process roles, so this comes before detection
+    window_rules_init();
+    
+    // Utility helpers (GPU, network, plugin hosts...) never own user-facing windows
+    process_role_t role = process_role_detect();
+    if (!process_role_should_activate(role)) {
+        WM_LOG_INFO("[Injector] Skipping %s process %s (%.3f ms)\n", 
+                    process_role_name(role), getprogname(), elapsed_ms(start));
+        return;
+    }
+    
+    // Lazy mode: nothing but the NSWindow swizzles until the process shows a window
+    if (lazy_init_requested()) {
+        register_cleanup();
+        window_modifier_lazy_init();
+        injection_initialized = true;
+        WM_LOG_INFO("[Injector] Lazy initialization armed in %.3f ms (%s)\n", 
+                    elapsed_ms(start), getprogname());
+        return;
+    }
+    
     // Print banner
-    printf("\n=======================================\n");
-    printf("Window Modifier Injection Started\n");
-    printf("=======================================\n");
+    WM_LOG_INFO("\n=======================================\n");
+    WM_LOG_INFO("Window Modifier Injection Started\n");
+    WM_LOG_INFO("=======================================\n");
     
     // Print process info
     print_process_info();
@@ -135,10 +157,10 @@ static void injection_entry(void) {
     
     // Initialize window modifier
     if (!init_window_modifier()) {
-        printf("[Injector] Failed to initialize window modifier\n");
+        WM_LOG_ERROR("[Injector] Failed to initialize window modifier\n");
         return;
     }
     
     injection_initialized = true;
-    printf("[Injector] Injection successfully initialized\n");
+    WM_LOG_INFO("[Injector] Injection successfully initialized in %.3f ms\n", elapsed_ms(start));
 }
@@ -0,0 +1,310 @@
+// logging.c - Leveled asynchronous logging
+#include "logging.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dispatch/dispatch.h>
+
+// Per-thread ring geometry
+#define WM_LOG_RING_RECORDS 64        // Records per thread (power of two)
+#define WM_LOG_RECORD_SIZE 256        // Bytes per record, longer messages are truncated
+#define WM_LOG_BATCH_SIZE 8192        // Bytes written per write() call
+
+// Preformatted message
+typedef struct {
+    uint16_t length;
+    char text[WM_LOG_RECORD_SIZE - sizeof(uint16_t)];
+} wm_log_record_t;
+
+// Single-producer / single-consumer ring owned by one thread at a time.
+// Rings are never freed; a ring released by an exiting thread is reused.
+typedef struct wm_log_ring {
+    _Atomic uint32_t head;           // Next record the owner writes
+    _Atomic uint32_t tail;           // Next record the drainer reads
+    _Atomic bool in_use;             // Owned by a live thread
+    struct wm_log_ring *next;        // Next ring (immutable once published)
+    wm_log_record_t records[WM_LOG_RING_RECORDS];
+} wm_log_ring_t;
+
+int wm_log_level = WM_LOG_LEVEL_WARN;
+
+static _Atomic(wm_log_ring_t *) ring_list = NULL;
+static _Thread_local wm_log_ring_t *thread_ring = NULL;
+static pthread_key_t ring_key;
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER; // Serializes consumers
+static dispatch_semaphore_t drain_semaphore = NULL;
+static _Atomic bool drainer_idle = false;
+static _Atomic bool log_running = false;
+static _Atomic bool log_configured = false;
+static pthread_once_t drainer_once = PTHREAD_ONCE_INIT;
+static _Atomic uint64_t dropped_count = 0;
+static uint64_t reported_dropped = 0;  // Guarded by drain_mutex
+
+// Forward declarations
+static int wm_log_parse_level(const char *value);
+static wm_log_ring_t *wm_log_acquire_ring(void);
+static void wm_log_release_ring(void *ring);
+static void wm_log_start_drainer(void);
+static void *wm_log_drain_main(void *arg);
+static size_t wm_log_drain(void);
+static void wm_log_write_all(const char *buffer, size_t length);
+
+// Read the runtime level; the logging thread starts with the first buffered message
+void wm_log_init(void) {
+    if (atomic_load(&log_configured)) {
+        return;
+    }
+    
+    const char *level = getenv("WM_LOG_LEVEL");
+    if (level) {
+        int parsed = wm_log_parse_level(level);
+        if (parsed >= 0) {
+            wm_log_level = parsed;
+        }
+    }
+    
+    atomic_store(&log_configured, true);
+}
+
+// Write out everything buffered so far
+void wm_log_flush(void) {
+    if (!atomic_load(&log_running)) {
+        return;
+    }
+    
+    while (wm_log_drain() > 0) {
+        // Keep going until every ring is empty
+    }
+}
+
+// Number of messages dropped because a thread's ring was full
+uint64_t wm_log_dropped(void) {
+    return atomic_load_explicit(&dropped_count, memory_order_relaxed);
+}
+
+// Format and enqueue a message
+void wm_log_write(int __attribute__((unused)) level, const char *format, ...) {
+    va_list args;
+    
+    // Processes that never log past the runtime level never pay for the thread
+    if (atomic_load_explicit(&log_configured, memory_order_relaxed)) {
+        pthread_once(&drainer_once, wm_log_start_drainer);
+    }
+    
+    wm_log_ring_t *ring = atomic_load_explicit(&log_running, memory_order_acquire) ? 
+                          wm_log_acquire_ring() : NULL;
+    
+    // Not running yet: format on the stack and write synchronously
+    if (!ring) {
+        char text[WM_LOG_RECORD_SIZE];
+        va_start(args, format);
+        int length = vsnprintf(text, sizeof(text), format, args);
+        va_end(args);
+        
+        if (length > 0) {
+            wm_log_write_all(text, (size_t)length < sizeof(text) ? (size_t)length : sizeof(text) - 1);
+        }
+        return;
+    }
+    
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= WM_LOG_RING_RECORDS) {
+        atomic_fetch_add_explicit(&dropped_count, 1, memory_order_relaxed);
+        return;
+    }
+    
+    wm_log_record_t *record = &ring->records[head & (WM_LOG_RING_RECORDS - 1)];
+    va_start(args, format);
+    int length = vsnprintf(record->text, sizeof(record->text), format, args);
+    va_end(args);
+    
+    if (length <= 0) {
+        return;
+    }
+    
+    // Truncated messages still end the line
+    if ((size_t)length >= sizeof(record->text)) {
+        length = sizeof(record->text) - 1;
+        record->text[length - 1] = '\n';
+    }
+    record->length = (uint16_t)length;
+    
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    
+    // Wake the drainer only if it is waiting. The fence pairs with the drainer's:
+    // either it sees the new head on its re-check, or we see it idle.
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&drainer_idle, memory_order_relaxed) && 
+        atomic_exchange_explicit(&drainer_idle, false, memory_order_acq_rel)) {
+        dispatch_semaphore_signal(drain_semaphore);
+    }
+}
+
+// Parse a level name or number, returns -1 if unrecognized
+static int wm_log_parse_level(const char *value) {
+    if (strcasecmp(value, "error") == 0) return WM_LOG_LEVEL_ERROR;
+    if (strcasecmp(value, "warn") == 0 || strcasecmp(value, "warning") == 0) return WM_LOG_LEVEL_WARN;
+    if (strcasecmp(value, "info") == 0) return WM_LOG_LEVEL_INFO;
+    if (strcasecmp(value, "debug") == 0) return WM_LOG_LEVEL_DEBUG;
+    
+    if (value[0] >= '0' && value[0] <= '9' && value[1] == '\0') {
+        int level = value[0] - '0';
+        return level > WM_LOG_LEVEL_DEBUG ? WM_LOG_LEVEL_DEBUG : level;
+    }
+    
+    return -1;
+}
+
+// Create the ring key, semaphore and drainer thread (runs once)
+static void wm_log_start_drainer(void) {
+    if (pthread_key_create(&ring_key, wm_log_release_ring) != 0) {
+        return;
+    }
+    
+    drain_semaphore = dispatch_semaphore_create(0);
+    if (!drain_semaphore) {
+        return;
+    }
+    
+    pthread_attr_t attr;
+    pthread_t thread;
+    if (pthread_attr_init(&attr) != 0) {
+        return;
+    }
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    
+    atomic_store(&log_running, true);
+    if (pthread_create(&thread, &attr, wm_log_drain_main, NULL) != 0) {
+        atomic_store(&log_running, false);
+    }
+    pthread_attr_destroy(&attr);
+}
+
+// Get the calling thread's ring, claiming a released one or allocating a new one
+static wm_log_ring_t *wm_log_acquire_ring(void) {
+    if (thread_ring) {
+        return thread_ring;
+    }
+    
+    wm_log_ring_t *ring = NULL;
+    
+    // Reuse a ring left behind by an exited thread
+    for (wm_log_ring_t *candidate = atomic_load(&ring_list); candidate; candidate = candidate->next) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&candidate->in_use, &expected, true)) {
+            ring = candidate;
+            break;
+        }
+    }
+    
+    if (!ring) {
+        ring = calloc(1, sizeof(wm_log_ring_t));
+        if (!ring) {
+            return NULL;
+        }
+        
+        atomic_init(&ring->in_use, true);
+        ring->next = atomic_load(&ring_list);
+        while (!atomic_compare_exchange_weak(&ring_list, &ring->next, ring)) {
+            // ring->next was reloaded with the current head
+        }
+    }
+    
+    thread_ring = ring;
+    pthread_setspecific(ring_key, ring);
+    return ring;
+}
+
+// Thread exit: hand the ring back for reuse (unread records are still drained)
+static void wm_log_release_ring(void *ring) {
+    atomic_store_explicit(&((wm_log_ring_t *)ring)->in_use, false, memory_order_release);
+}
+
+// Background thread: drain rings, sleep on the semaphore when idle
+static void *wm_log_drain_main(void * __attribute__((unused)) arg) {
+    for (;;) {
+        if (wm_log_drain() > 0) {
+            continue;
+        }
+        
+        // Announce we're going idle, then re-check so a message logged in between isn't missed
+        atomic_store(&drainer_idle, true);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (wm_log_drain() > 0) {
+            atomic_store(&drainer_idle, false);
+            continue;
+        }
+        
+        // No timeout: an idle process gets no wakeups from logging
+        dispatch_semaphore_wait(drain_semaphore, DISPATCH_TIME_FOREVER);
+        atomic_store(&drainer_idle, false);
+    }
+    
+    return NULL;
+}
+
+// Copy every pending record into batches and write them, returns the number of records
+static size_t wm_log_drain(void) {
+    char batch[WM_LOG_BATCH_SIZE];
+    size_t used = 0;
+    size_t drained = 0;
+    
+    pthread_mutex_lock(&drain_mutex);
+    
+    for (wm_log_ring_t *ring = atomic_load(&ring_list); ring; ring = ring->next) {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        
+        while (tail != head) {
+            wm_log_record_t *record = &ring->records[tail & (WM_LOG_RING_RECORDS - 1)];
+            if (used + record->length > sizeof(batch)) {
+                wm_log_write_all(batch, used);
+                used = 0;
+            }
+            memcpy(batch + used, record->text, record->length);
+            used += record->length;
+            tail++;
+            drained++;
+        }
+        
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+    
+    // Report drops once per drain pass
+    uint64_t dropped = atomic_load_explicit(&dropped_count, memory_order_relaxed);
+    if (dropped != reported_dropped) {
+        int length = snprintf(batch + used, sizeof(batch) - used, 
+                              "[Log] Dropped %llu messages (ring full)\n", 
+                              (unsigned long long)(dropped - reported_dropped));
+        if (length > 0 && (size_t)length < sizeof(batch) - used) {
+            used += (size_t)length;
+            reported_dropped = dropped;
+        }
+    }
+    
+    if (used > 0) {
+        wm_log_write_all(batch, used);
+    }
+    
+    pthread_mutex_unlock(&drain_mutex);
+    
+    return drained;
+}
+
+// Write a buffer to stdout, retrying partial writes
+static void wm_log_write_all(const char *buffer, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(STDOUT_FILENO, buffer, length);
+        if (written <= 0) {
+            return;
+        }
+        buffer += written;
+        length -= (size_t)written;
+    }
+}
@@ -0,0 +1,56 @@
+// logging.h - Leveled asynchronous logging
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Log calls format into a per-thread lock-free ring buffer and return; a
+// background thread drains the rings and writes them to stdout in batches,
+// so hot paths never take the stdio lock or block on a slow pipe.
+//
+// Levels are filtered twice: messages above WM_LOG_COMPILE_LEVEL compile to
+// nothing (arguments are not evaluated), and messages above the runtime level
+// (WM_LOG_LEVEL environment variable, default "warn") cost a single compare.
+
+// Log levels
+#define WM_LOG_LEVEL_ERROR 0
+#define WM_LOG_LEVEL_WARN  1
+#define WM_LOG_LEVEL_INFO  2
+#define WM_LOG_LEVEL_DEBUG 3
+
+// Highest level compiled in (override with -DWM_LOG_COMPILE_LEVEL=...)
+#ifndef WM_LOG_COMPILE_LEVEL
+#define WM_LOG_COMPILE_LEVEL WM_LOG_LEVEL_DEBUG
+#endif
+
+// Runtime level (set once by wm_log_init)
+extern int wm_log_level;
+
+// Read WM_LOG_LEVEL. The logging thread is started by the first message that
+// passes the level check; messages logged before wm_log_init (or if the thread
+// can't be started) are written synchronously
+void wm_log_init(void);
+
+// Write out everything buffered so far (call before the process exits)
+void wm_log_flush(void);
+
+// Number of messages dropped because a thread's ring was full
+uint64_t wm_log_dropped(void);
+
+// Format and enqueue a message (use the WM_LOG_* macros instead)
+void wm_log_write(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+#define WM_LOG(level, ...) \
+    do { \
+        if ((level) <= WM_LOG_COMPILE_LEVEL && (level) <= wm_log_level) { \
+            wm_log_write((level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define WM_LOG_ERROR(...) WM_LOG(WM_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define WM_LOG_WARN(...)  WM_LOG(WM_LOG_LEVEL_WARN, __VA_ARGS__)
+#define WM_LOG_INFO(...)  WM_LOG(WM_LOG_LEVEL_INFO, __VA_ARGS__)
+#define WM_LOG_DEBUG(...) WM_LOG(WM_LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#endif // LOGGING_H
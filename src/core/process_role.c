@@ -0,0 +1,175 @@
+// process_role.c - Process role detection and activation policy
+#include "process_role.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <mach-o/dyld.h>
+
+// Process name patterns for classification
+typedef struct {
+    const char* pattern;
+    process_role_t role;
+} process_pattern_t;
+
+// Common patterns in macOS process architecture
+static const process_pattern_t process_patterns[] = {
+    // UI/Rendering processes - common patterns across frameworks
+    {"Renderer", PROCESS_ROLE_UI},
+    {"WebProcess", PROCESS_ROLE_UI},
+    {"WebContent", PROCESS_ROLE_UI},
+    {"UIProcess", PROCESS_ROLE_UI},
+    {"ViewService", PROCESS_ROLE_UI},
+    {"RenderProcess", PROCESS_ROLE_UI},
+    
+    // Utility/Helper processes - common across macOS applications
+    {"GPU", PROCESS_ROLE_UTILITY},
+    {"Helper", PROCESS_ROLE_UTILITY},
+    {"Plugin", PROCESS_ROLE_UTILITY},
+    {"Utility", PROCESS_ROLE_UTILITY},
+    {"Service", PROCESS_ROLE_UTILITY},
+    {"Agent", PROCESS_ROLE_UTILITY},
+    {"XPC", PROCESS_ROLE_UTILITY},
+    {"Network", PROCESS_ROLE_UTILITY},
+    {"Storage", PROCESS_ROLE_UTILITY},
+    
+    // End marker
+    {NULL, PROCESS_ROLE_MAIN}
+};
+
+// Patterns added by the rules config (checked first, applied as-is)
+#define MAX_CONFIGURED_PATTERNS 16
+#define MAX_PATTERN_LENGTH 32
+
+typedef struct {
+    char pattern[MAX_PATTERN_LENGTH];
+    process_role_t role;
+} configured_pattern_t;
+
+static configured_pattern_t configured_patterns[MAX_CONFIGURED_PATTERNS];
+static int configured_pattern_count = 0;
+static pthread_mutex_t configured_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static process_role_t detected_role = PROCESS_ROLE_MAIN;
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+
+// Forward declarations
+static void process_role_detect_once(void);
+static bool process_is_main_bundle_executable(void);
+
+// Detect the role of the current process
+process_role_t process_role_detect(void) {
+    pthread_once(&detect_once, process_role_detect_once);
+    return detected_role;
+}
+
+// Give executables matching a pattern a role
+bool process_role_add_pattern(const char* pattern, process_role_t role) {
+    if (!pattern || pattern[0] == '\0' || strlen(pattern) >= MAX_PATTERN_LENGTH) {
+        return false;
+    }
+    
+    pthread_mutex_lock(&configured_mutex);
+    bool added = configured_pattern_count < MAX_CONFIGURED_PATTERNS;
+    if (added) {
+        configured_pattern_t* entry = &configured_patterns[configured_pattern_count++];
+        strcpy(entry->pattern, pattern);
+        entry->role = role;
+    }
+    pthread_mutex_unlock(&configured_mutex);
+    
+    return added;
+}
+
+// Human-readable role name
+const char* process_role_name(process_role_t role) {
+    switch (role) {
+        case PROCESS_ROLE_MAIN:
+            return "main";
+        case PROCESS_ROLE_UI:
+            return "ui";
+        case PROCESS_ROLE_UTILITY:
+            return "utility";
+    }
+    return "unknown";
+}
+
+// Whether a process with this role should initialize the window modifier
+bool process_role_should_activate(process_role_t role) {
+    if (role != PROCESS_ROLE_UTILITY) {
+        return true;
+    }
+    
+    // Opt-in override (injector --include-helpers)
+    const char* include = getenv("WM_INCLUDE_HELPERS");
+    return include && strcmp(include, "1") == 0;
+}
+
+// Detect process role based on executable name - generalized for all macOS applications
+static void process_role_detect_once(void) {
+    const char* processName = getprogname();
+    if (!processName) {
+        detected_role = PROCESS_ROLE_MAIN;
+        return;
+    }
+    
+    // Check for position in application bundle
+    detected_role = process_role_classify(processName, process_is_main_bundle_executable());
+}
+
+// Role of an executable name
+process_role_t process_role_classify(const char* processName, bool isMainBundle) {
+    if (!processName) {
+        return PROCESS_ROLE_MAIN;
+    }
+    
+    // Configured patterns are explicit, so they apply even to the main executable
+    pthread_mutex_lock(&configured_mutex);
+    for (int i = 0; i < configured_pattern_count; i++) {
+        if (strcasestr(processName, configured_patterns[i].pattern) != NULL) {
+            process_role_t role = configured_patterns[i].role;
+            pthread_mutex_unlock(&configured_mutex);
+            return role;
+        }
+    }
+    pthread_mutex_unlock(&configured_mutex);
+    
+    // Helper processes often contain these patterns
+    for (int i = 0; process_patterns[i].pattern != NULL; i++) {
+        if (strcasestr(processName, process_patterns[i].pattern) != NULL) {
+            // If this is the main bundle executable but has a pattern match,
+            // it could be a specially named main executable, so do extra checks
+            if (isMainBundle) {
+                // Is the pattern the entire name? If so, it's probably a helper
+                size_t patternLen = strlen(process_patterns[i].pattern);
+                size_t nameLen = strlen(processName);
+                
+                // If the pattern is a significant portion of the name, it's likely matching correctly
+                if (patternLen > 3 && patternLen >= nameLen / 2) {
+                    return process_patterns[i].role;
+                }
+                
+                // Otherwise, continue checking other patterns
+            } else {
+                // Not the main bundle executable, so pattern match is reliable
+                return process_patterns[i].role;
+            }
+        }
+    }
+    
+    // If we couldn't determine, default to standard
+    return PROCESS_ROLE_MAIN;
+}
+
+// Check if the executable is the outermost bundle's main executable
+// (helpers live in nested bundles such as X.app/Contents/Frameworks/X Helper.app)
+static bool process_is_main_bundle_executable(void) {
+    char path[PATH_MAX];
+    uint32_t size = sizeof(path);
+    if (_NSGetExecutablePath(path, &size) != 0) {
+        return false;
+    }
+    
+    const char* firstBundle = strstr(path, ".app/");
+    return firstBundle && strncmp(firstBundle, ".app/Contents/MacOS/", 20) == 0;
+}
@@ -0,0 +1,34 @@
+// process_role.h - Process role detection and activation policy
+#ifndef PROCESS_ROLE_H
+#define PROCESS_ROLE_H
+
+#include <stdbool.h>
+#include "common_types.h"
+
+// The dylib is loaded into every process of a multi-process app (renderers,
+// GPU, network and other helpers inherit DYLD_INSERT_LIBRARIES). This module
+// classifies the current process by executable name and decides whether it
+// should do anything at all: utility helpers never own user-facing windows,
+// so by default they stay completely inactive.
+
+// Detect the role of the current process (computed once, then cached)
+process_role_t process_role_detect(void);
+
+// Role of an executable name by the configured, then built-in, patterns.
+// isMainBundle marks the outermost bundle's main executable, which only
+// matches a built-in pattern that makes up a large part of its name.
+process_role_t process_role_classify(const char* processName, bool isMainBundle);
+
+// Give executables whose name contains pattern (case-insensitive) a role,
+// ahead of the built-in patterns. Call before process_role_detect(); returns
+// false once the configured pattern table is full.
+bool process_role_add_pattern(const char* pattern, process_role_t role);
+
+// Human-readable role name for logging
+const char* process_role_name(process_role_t role);
+
+// Whether a process with this role should initialize the window modifier.
+// Utility processes are skipped unless WM_INCLUDE_HELPERS=1.
+bool process_role_should_activate(process_role_t role);
+
+#endif // PROCESS_ROLE_H
@@ -0,0 +1,32 @@
+// trace.c - Optional os_signpost intervals for Instruments
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_SUBSYSTEM "com.windowmodifier"
+
+bool wm_trace_enabled = false;
+os_log_t wm_trace_log = NULL;
+
+// Read WM_SIGNPOST and create the log handle
+void wm_trace_init(void) {
+    const char *value = getenv("WM_SIGNPOST");
+    if (!value || strcmp(value, "1") != 0 || wm_trace_log) {
+        return;
+    }
+    
+    // Points of Interest shows up in Instruments without a custom instrument.
+    // Whether a recording is attached is checked by os_signpost itself, so a
+    // trace started after launch still sees the intervals
+    wm_trace_log = os_log_create(TRACE_SUBSYSTEM, OS_LOG_CATEGORY_POINTS_OF_INTEREST);
+    wm_trace_enabled = (wm_trace_log != NULL);
+}
+
+// New span identifier
+wm_trace_id_t wm_trace_make_id(void) {
+    if (!wm_trace_enabled) {
+        return OS_SIGNPOST_ID_NULL;
+    }
+    
+    return os_signpost_id_generate(wm_trace_log);
+}
@@ -0,0 +1,45 @@
+// trace.h - Optional os_signpost intervals for Instruments
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <os/signpost.h>
+
+// Signpost intervals mark the phases our injected code adds to the host's
+// window work (sweeps, modifications, CGS calls, registry lock holds, retry
+// passes) so they show up in an Instruments "Points of Interest" track.
+// Tracing is off unless WM_SIGNPOST=1 (set by `injector --trace`); when off
+// every macro below is a single branch on wm_trace_enabled.
+
+// Span identifier (OS_SIGNPOST_ID_NULL when tracing is off)
+typedef os_signpost_id_t wm_trace_id_t;
+
+// Whether tracing is on (set once by wm_trace_init)
+extern bool wm_trace_enabled;
+
+// Log handle the intervals are emitted on (NULL when tracing is off)
+extern os_log_t wm_trace_log;
+
+// Read WM_SIGNPOST and create the log handle
+void wm_trace_init(void);
+
+// New span identifier, for intervals that may overlap (e.g. across threads)
+wm_trace_id_t wm_trace_make_id(void);
+
+// Begin / end an interval; name must be a string literal, the optional
+// arguments are an os_log format string and its values
+#define WM_TRACE_BEGIN(spanId, name, ...) \
+    do { \
+        if (wm_trace_enabled) { \
+            os_signpost_interval_begin(wm_trace_log, (spanId), name, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define WM_TRACE_END(spanId, name, ...) \
+    do { \
+        if (wm_trace_enabled) { \
+            os_signpost_interval_end(wm_trace_log, (spanId), name, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif // TRACE_H
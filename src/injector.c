@@ -15,57 +15,63 @@
 #include <time.h>
 #include <sys/types.h>
 #include <sys/sysctl.h>
+#include <sys/event.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "tracker/window_registry.h"
+#include "tracker/window_rules.h"
+#include "core/process_role.h"
 
 // Constants for registry paths
 #define REGISTRY_DIR "/tmp/window_modifier"
 #define REGISTRY_FILE "registry.dat"
 
-// Process Types - Classification for application architecture
-typedef enum {
-    PROCESS_TYPE_STANDARD,       // Standard single-process app (most macOS applications)
-    PROCESS_TYPE_MULTI_PROCESS,  // App with multiple processes architecture
-    PROCESS_TYPE_AGENT           // Background agent or daemon process
-} process_type_t;
+// Path to our DYLIB
+static char dylibPath[PATH_MAX];
+
+// Maximum number of applications launched by one invocation
+#define MAX_TARGETS 32
+
+// How long to wait for killed instances and for terminated targets to exit
+#define KILL_WAIT_MS 2000
+#define TERMINATE_WAIT_MS 500
+
+// Supervisor: socket serving statistics, and relaunch backoff for apps that crash right away
+#define SUPERVISOR_SOCKET_PATH REGISTRY_DIR "/supervisor.sock"
+#define SUPERVISOR_QUICK_CRASH_SECONDS 10
+#define SUPERVISOR_FIRST_BACKOFF_MS 1000
+#define SUPERVISOR_MAX_BACKOFF_MS 60000
+#define SUPERVISOR_SEND_TIMEOUT_USEC 100000
 
-// Process identification and detection
+// One application to launch
 typedef struct {
-    const char *processName;       // Process name pattern
-    process_type_t processType;    // Type of process
-} ProcessPattern;
-
-// Common process architectural patterns
-// This detects common patterns across macOS applications
-// No application-specific patterns should be here
-static const ProcessPattern knownPatterns[] = {
-    // Multi-process architecture indicators - found in many modern macOS apps
-    {"Helper", PROCESS_TYPE_MULTI_PROCESS},
-    {"GPU", PROCESS_TYPE_MULTI_PROCESS},
-    {"Renderer", PROCESS_TYPE_MULTI_PROCESS},
-    {"WebProcess", PROCESS_TYPE_MULTI_PROCESS},
-    {"WebContent", PROCESS_TYPE_MULTI_PROCESS},
-    
-    // Services and agents
-    {"Agent", PROCESS_TYPE_AGENT},
-    {"Service", PROCESS_TYPE_AGENT},
-    {"Daemon", PROCESS_TYPE_AGENT},
-    
-    // Framework processes
-    {"XPC", PROCESS_TYPE_MULTI_PROCESS},
-    {"Extension", PROCESS_TYPE_MULTI_PROCESS},
-    {"Plugin", PROCESS_TYPE_MULTI_PROCESS},
-    
-    // Default - all other apps
-    {NULL, PROCESS_TYPE_STANDARD}  // Sentinel
-};
+    const char *appPath;             // Path from the command line or manifest
+    char executablePath[PATH_MAX];   // Main executable
+    const char *appName;             // Executable name (for logging and process management)
+    char registryNamespace[256];     // WM_REGISTRY_NAMESPACE the app runs with
+    pid_t pid;                       // PID once launched (0 before launch or after exit)
+    time_t launchTime;               // When the current instance was launched
+    int launches;                    // Launches so far (supervisor)
+    int quickCrashes;                // Consecutive crashes shortly after launch (supervisor)
+    int forks;                       // Forks of the main process seen (supervisor)
+    bool relaunchPending;            // Relaunch timer armed (supervisor)
+    window_registry_t *registry;     // Registry held open across restarts (supervisor)
+} LaunchTarget;
 
-// Path to our DYLIB
-static char dylibPath[PATH_MAX];
+// Applications of this invocation (read by the signal handler)
+static LaunchTarget targets[MAX_TARGETS];
+static int targetCount = 0;
+
+// Interval between --stats refreshes
+#define STATS_REFRESH_SECONDS 1
 
-// PID of the main process we launched
-static pid_t mainPid = 0;
+// Set by SIGINT/SIGTERM to stop the --stats loop
+static volatile sig_atomic_t statsStopRequested = 0;
 
 // Forward declaration
-static int injectDylib(const char *executablePath, const char *dylibPath, bool waitForExit);
+static pid_t injectDylib(const char *executablePath, const char *dylibPath);
+static int waitForProcessesExit(pid_t *pids, int count, int timeoutMs);
+static int showStats(void);
 
 /**
  * Signal handler for clean termination
@@ -73,18 +79,24 @@ static int injectDylib(const char *executablePath, const char *dylibPath, bool w
 static void signalHandler(int sig) {
     printf("\nReceived signal %d, shutting down...\n", sig);
     
-    // Kill the main process if it's still running
-    if (mainPid > 0) {
-        kill(mainPid, SIGTERM);
-        printf("Sent SIGTERM to process %d\n", mainPid);
-        
-        // Give a short time for the process to exit gracefully
-        usleep(500000); // 500ms
-        
-        // Force kill if still running
-        if (kill(mainPid, 0) == 0) {
-            printf("Process still running, sending SIGKILL\n");
-            kill(mainPid, SIGKILL);
+    // Ask every launched process that is still running to terminate
+    pid_t pids[MAX_TARGETS];
+    int count = 0;
+    for (int i = 0; i < targetCount; i++) {
+        if (targets[i].pid > 0) {
+            kill(targets[i].pid, SIGTERM);
+            printf("Sent SIGTERM to process %d\n", targets[i].pid);
+            pids[count++] = targets[i].pid;
+        }
+    }
+    
+    // Give them a short time to exit gracefully, then force kill the rest
+    if (count > 0 && waitForProcessesExit(pids, count, TERMINATE_WAIT_MS) > 0) {
+        for (int i = 0; i < count; i++) {
+            if (pids[i] != 0) {
+                printf("Process %d still running, sending SIGKILL\n", pids[i]);
+                kill(pids[i], SIGKILL);
+            }
         }
     }
     
@@ -121,26 +133,62 @@ static bool isValidAppPath(const char *path) {
 }
 
 /**
- * Detects the type of application based on its executable name and structure
+ * Compiles the rules config (WM_RULES_FILE, then WM_RULES) as the library does
+ * in a process with the given executable name. With a NULL name every section
+ * is checked but none is applied.
+ */
+static bool compileRules(const char *processName, window_rule_set_t *rules) {
+    *rules = *window_rules_default();
+    char error[PATH_MAX + 192];
+    
+    const char *path = getenv("WM_RULES_FILE");
+    if (path && *path && !window_rules_compile_file(path, processName, rules, error, sizeof(error))) {
+        printf("Error: %s\n", error);
+        return false;
+    }
+    
+    const char *inlineRules = getenv("WM_RULES");
+    if (inlineRules && *inlineRules && !window_rules_compile(inlineRules, processName, rules, error, sizeof(error))) {
+        printf("Error: WM_RULES: %s\n", error);
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * Detects the role the library will give an executable, using the same
+ * patterns as the injected code: the rules config compiled for this
+ * executable's name (including its sections), then the built-in patterns
  */
-static process_type_t detectProcessType(const char *executablePath) {
+static process_role_t detectProcessRole(const char *executablePath) {
     const char *execName = strrchr(executablePath, '/');
     execName = execName ? execName + 1 : executablePath;
     
-    // Check against known patterns
-    for (int i = 0; knownPatterns[i].processName != NULL; i++) {
-        if (strstr(execName, knownPatterns[i].processName) != NULL) {
-            return knownPatterns[i].processType;
+    // Configured patterns come first, as in process_role_classify
+    static window_rule_set_t rules;
+    if (compileRules(execName, &rules)) {
+        for (int i = 0; i < rules.process_pattern_count; i++) {
+            if (strcasestr(execName, rules.process_patterns[i].pattern) != NULL) {
+                return rules.process_patterns[i].role;
+            }
         }
     }
     
-    // If executable is in a standard macOS app bundle, it's likely a standard app
-    if (strstr(executablePath, ".app/Contents/MacOS/") != NULL) {
-        return PROCESS_TYPE_STANDARD;
-    }
+    // The outermost bundle's main executable only matches strong patterns
+    const char *firstBundle = strstr(executablePath, ".app/");
+    bool isMainBundle = firstBundle && strncmp(firstBundle, ".app/Contents/MacOS/", 20) == 0;
     
-    // Default to standard
-    return PROCESS_TYPE_STANDARD;
+    return process_role_classify(execName, isMainBundle);
+}
+
+/**
+ * Checks the rules config before anything is launched, so a typo is reported
+ * here instead of in every injected process
+ */
+static bool validateRules(void) {
+    static window_rule_set_t rules;
+    return compileRules(NULL, &rules);
 }
 
 /**
@@ -222,19 +270,151 @@ static bool findMainExecutable(const char *appPath, char *exePath, size_t maxLen
 }
 
 /**
- * Find and kill all running instances of an application
+ * Waits until the given processes exit or the timeout passes. Exited entries
+ * are set to 0; returns how many are still running.
+ */
+static int waitForProcessesExit(pid_t *pids, int count, int timeoutMs) {
+    int kq = kqueue();
+    if (kq == -1) {
+        perror("kqueue failed");
+        return count;
+    }
+    
+    // Processes that are already gone fail to register with ESRCH
+    int remaining = 0;
+    for (int i = 0; i < count; i++) {
+        struct kevent change;
+        EV_SET(&change, pids[i], EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, (void *)(intptr_t)i);
+        if (kevent(kq, &change, 1, NULL, 0, NULL) == -1) {
+            pids[i] = 0;
+        } else {
+            remaining++;
+        }
+    }
+    
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (remaining > 0) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long elapsedMs = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsedMs >= timeoutMs) {
+            break;
+        }
+        
+        long leftMs = timeoutMs - elapsedMs;
+        struct timespec timeout = { leftMs / 1000, (leftMs % 1000) * 1000000 };
+        struct kevent events[MAX_TARGETS];
+        int n = kevent(kq, NULL, 0, events, MAX_TARGETS, &timeout);
+        if (n == -1 && errno != EINTR) {
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            pids[(intptr_t)events[i].udata] = 0;
+            remaining--;
+        }
+    }
+    
+    close(kq);
+    return remaining;
+}
+
+/**
+ * Kill all running instances of the target applications and wait until they are gone
+ */
+static void killRunningInstances(const LaunchTarget *launchTargets, int count) {
+    int bufferSize = proc_listpids(PROC_ALL_PIDS, 0, NULL, 0);
+    if (bufferSize <= 0) {
+        printf("Warning: Failed to list processes: %s\n", strerror(errno));
+        return;
+    }
+    
+    // Leave room for processes started since the size query
+    bufferSize += 64 * sizeof(pid_t);
+    pid_t *allPids = malloc(bufferSize);
+    pid_t *killed = malloc(bufferSize);
+    if (!allPids || !killed) {
+        free(allPids);
+        free(killed);
+        return;
+    }
+    
+    int pidCount = proc_listpids(PROC_ALL_PIDS, 0, allPids, bufferSize) / (int)sizeof(pid_t);
+    int killedCount = 0;
+    pid_t self = getpid();
+    
+    for (int i = 0; i < count; i++) {
+        printf("Stopping any running %s instances...\n", launchTargets[i].appName);
+    }
+    
+    // Match executable names by substring, as pkill does, so helpers go too
+    for (int p = 0; p < pidCount; p++) {
+        if (allPids[p] <= 0 || allPids[p] == self) {
+            continue;
+        }
+        
+        char path[PROC_PIDPATHINFO_MAXSIZE];
+        if (proc_pidpath(allPids[p], path, sizeof(path)) <= 0) {
+            continue;
+        }
+        const char *name = strrchr(path, '/');
+        name = name ? name + 1 : path;
+        
+        for (int i = 0; i < count; i++) {
+            if (strstr(name, launchTargets[i].appName) != NULL) {
+                if (kill(allPids[p], SIGKILL) == 0) {
+                    killed[killedCount++] = allPids[p];
+                }
+                break;
+            }
+        }
+    }
+    
+    // Wait for the kills to take effect instead of sleeping a fixed time
+    if (killedCount > 0) {
+        int survivors = waitForProcessesExit(killed, killedCount, KILL_WAIT_MS);
+        printf("Stopped %d process%s", killedCount - survivors, killedCount - survivors == 1 ? "" : "es");
+        if (survivors > 0) {
+            printf(" (%d still exiting)", survivors);
+        }
+        printf("\n");
+    }
+    
+    free(allPids);
+    free(killed);
+}
+
+/**
+ * Derives the registry namespace of an application: its bundle identifier,
+ * or the executable name when it isn't inside a bundle
  */
-static void killRunningInstances(const char *appName) {
-    char cmd[PATH_MAX + 50];
+static void registryNamespaceForApp(const char *appPath, const char *appName, char *ns, size_t maxLen) {
+    snprintf(ns, maxLen, "%s", appName);
     
-    // Use pkill to kill all processes with the app name
-    snprintf(cmd, sizeof(cmd), "pkill -9 \"%s\" 2>/dev/null || true", appName);
+    // The bundle root is everything up to and including ".app"
+    const char *bundleEnd = strstr(appPath, ".app");
+    if (!bundleEnd) {
+        return;
+    }
     
-    printf("Stopping any running %s instances...\n", appName);
-    system(cmd);
+    CFURLRef bundleURL = CFURLCreateFromFileSystemRepresentation(kCFAllocatorDefault,
+        (const UInt8 *)appPath, (CFIndex)(bundleEnd + 4 - appPath), true);
+    if (!bundleURL) {
+        return;
+    }
+    
+    CFBundleRef bundle = CFBundleCreate(kCFAllocatorDefault, bundleURL);
+    CFRelease(bundleURL);
+    if (!bundle) {
+        return;
+    }
     
-    // Small delay to ensure processes are terminated
-    usleep(500000); // 500ms
+    CFStringRef identifier = CFBundleGetIdentifier(bundle);
+    char buffer[256];
+    if (identifier && CFStringGetCString(identifier, buffer, sizeof(buffer), kCFStringEncodingUTF8)) {
+        snprintf(ns, maxLen, "%s", buffer);
+    }
+    CFRelease(bundle);
 }
 
 /**
@@ -270,31 +450,32 @@ static void cleanupRegistry(void) {
 }
 
 /**
- * Enhanced DYLIB injection with robust error handling for all macOS applications
+ * Enhanced DYLIB injection with robust error handling for all macOS applications.
+ * Returns the PID of the launched process without waiting for it, or -1 on failure.
  */
-static int injectDylib(const char *executablePath, const char *dylibPath, bool waitForExit) {
+static pid_t injectDylib(const char *executablePath, const char *dylibPath) {
     // Validate inputs with detailed error reporting
     if (!executablePath) {
         fprintf(stderr, "Error: No executable path provided for injection\n");
-        return 1;
+        return -1;
     }
     
     if (!dylibPath) {
         fprintf(stderr, "Error: No DYLIB path provided for injection\n");
-        return 1;
+        return -1;
     }
     
     // Verify executable exists and has proper permissions
     if (access(executablePath, F_OK) != 0) {
         fprintf(stderr, "Error: Executable not found: %s (errno: %d - %s)\n", 
                 executablePath, errno, strerror(errno));
-        return 1;
+        return -1;
     }
     
     if (access(executablePath, X_OK) != 0) {
         fprintf(stderr, "Error: Executable not executable: %s (errno: %d - %s)\n", 
                 executablePath, errno, strerror(errno));
-        return 1;
+        return -1;
     }
     
     // Get the file name from path
@@ -323,7 +504,7 @@ static int injectDylib(const char *executablePath, const char *dylibPath, bool w
     char **newEnv = (char **)malloc((parentEnvCount + 3) * sizeof(char *));
     if (!newEnv) {
         perror("Failed to allocate memory for environment");
-        return 1;
+        return -1;
     }
     
     // Copy parent environment variables, skipping any existing DYLD_INSERT_LIBRARIES
@@ -351,12 +532,10 @@ static int injectDylib(const char *executablePath, const char *dylibPath, bool w
     printf("DYLIB: %s\n", dylibPath);
     printf("Executable: %s\n", executablePath);
     
-    // Detect process type for logging
-    process_type_t processType = detectProcessType(executablePath);
-    printf("Detected process type: %s\n", 
-           processType == PROCESS_TYPE_MULTI_PROCESS ? "Multi-process application" : 
-           processType == PROCESS_TYPE_AGENT ? "Agent/service process" : 
-           "Standard application");
+    // Detect process role for logging
+    process_role_t role = detectProcessRole(executablePath);
+    printf("Detected process role: %s%s\n", process_role_name(role),
+           process_role_should_activate(role) ? "" : " (inactive)");
     
     // Launch the process using posix_spawnp
     status = posix_spawnp(&pid, executablePath, NULL, NULL, args, newEnv);
@@ -366,29 +545,127 @@ static int injectDylib(const char *executablePath, const char *dylibPath, bool w
     
     if (status != 0) {
         printf("Error: posix_spawn: %s\n", strerror(status));
-        return 1;
+        return -1;
     }
     
     printf("%s started with PID: %d\n", execName, pid);
+    return pid;
+}
+
+/**
+ * Waits for every launched target to exit, reaping each as its exit arrives.
+ * Returns the last non-zero exit status, or 0 if all exited cleanly.
+ */
+static int waitForTargets(void) {
+    int result = 0;
+    int remaining = 0;
+    int kq = kqueue();
     
-    // Save the main process PID for signal handling
-    if (waitForExit) {
-        mainPid = pid;
+    for (int i = 0; i < targetCount; i++) {
+        if (targets[i].pid <= 0) {
+            continue;
+        }
+        
+        // A target that already exited fails to register and is reaped below
+        struct kevent change;
+        EV_SET(&change, targets[i].pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, (void *)(intptr_t)i);
+        if (kq != -1 && kevent(kq, &change, 1, NULL, 0, NULL) == 0) {
+            remaining++;
+            continue;
+        }
+        
+        int status;
+        if (waitpid(targets[i].pid, &status, 0) != -1) {
+            printf("%s exited with status: %d\n", targets[i].appName, WEXITSTATUS(status));
+            if (WEXITSTATUS(status) != 0) {
+                result = WEXITSTATUS(status);
+            }
+        }
+        targets[i].pid = 0;
     }
     
-    // Wait for the child process to exit if requested
-    if (waitForExit) {
-        printf("\nProcess is running. Press Ctrl+C to exit.\n");
-        if (waitpid(pid, &status, 0) != -1) {
-            printf("Process exited with status: %d\n", WEXITSTATUS(status));
-            return WEXITSTATUS(status);
-        } else {
-            perror("waitpid failed");
-            return 1;
+    while (remaining > 0) {
+        struct kevent events[MAX_TARGETS];
+        int n = kevent(kq, NULL, 0, events, MAX_TARGETS, NULL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("kevent failed");
+            result = 1;
+            break;
+        }
+        
+        for (int e = 0; e < n; e++) {
+            LaunchTarget *target = &targets[(intptr_t)events[e].udata];
+            int status;
+            if (waitpid(target->pid, &status, 0) != -1) {
+                printf("%s exited with status: %d\n", target->appName, WEXITSTATUS(status));
+                if (WEXITSTATUS(status) != 0) {
+                    result = WEXITSTATUS(status);
+                }
+            }
+            target->pid = 0;
+            remaining--;
         }
     }
     
-    return 0;
+    if (kq != -1) {
+        close(kq);
+    }
+    return result;
+}
+
+/**
+ * Adds an application path to the launch list
+ */
+static bool addTarget(const char *appPath) {
+    if (targetCount >= MAX_TARGETS) {
+        printf("Warning: Ignoring %s, at most %d applications can be launched at once\n", appPath, MAX_TARGETS);
+        return false;
+    }
+    
+    LaunchTarget *target = &targets[targetCount++];
+    memset(target, 0, sizeof(*target));
+    target->appPath = appPath;
+    return true;
+}
+
+/**
+ * Adds every application listed in a manifest: one path per line,
+ * blank lines and lines starting with '#' are ignored
+ */
+static bool readManifest(const char *manifestPath) {
+    FILE *file = fopen(manifestPath, "r");
+    if (!file) {
+        printf("Error: Cannot open manifest %s: %s\n", manifestPath, strerror(errno));
+        return false;
+    }
+    
+    char line[PATH_MAX];
+    while (fgets(line, sizeof(line), file)) {
+        // Trim surrounding whitespace, including the newline
+        char *start = line;
+        while (*start == ' ' || *start == '\t') {
+            start++;
+        }
+        char *end = start + strlen(start);
+        while (end > start && (end[-1] == '\n' || end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) {
+            *--end = '\0';
+        }
+        
+        if (*start == '\0' || *start == '#') {
+            continue;
+        }
+        
+        char *appPath = strdup(start);
+        if (!appPath || !addTarget(appPath)) {
+            free(appPath);
+        }
+    }
+    
+    fclose(file);
+    return true;
 }
 
 /**
@@ -472,6 +749,393 @@ static const char* detectCPUArchitecture(void) {
     #endif
 }
 
+/**
+ * Stop the --stats loop on Ctrl-C
+ */
+static void statsSignalHandler(int __attribute__((unused)) sig) {
+    statsStopRequested = 1;
+}
+
+/**
+ * Write counters and latency percentiles of every injected process
+ */
+static void writeStatsReport(FILE *out, const char *hint) {
+    static wm_stats_slot_t slots[WM_STATS_MAX_SLOTS];
+    int count = registry_read_stats(slots, WM_STATS_MAX_SLOTS);
+    
+    // A supervisor holds the registries open and has a slot of its own; leave it out
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (slots[i].pid != getpid()) {
+            if (kept != i) {
+                memcpy(&slots[kept], &slots[i], sizeof(wm_stats_slot_t));
+            }
+            kept++;
+        }
+    }
+    count = kept;
+    
+    fprintf(out, "Window modifier statistics (%d process%s%s)\n\n", 
+            count, count == 1 ? "" : "es", hint);
+    
+    if (count == 0) {
+        fprintf(out, "No injected processes found\n");
+    }
+    
+    for (int i = 0; i < count; i++) {
+        wm_stats_slot_t *slot = &slots[i];
+        fprintf(out, "%s (pid %d)\n", slot->process_name, (int)slot->pid);
+        
+        for (int c = 0; c < WM_STAT_COUNT; c++) {
+            fprintf(out, "  %-20s %llu\n", wm_stats_counter_name((wm_stat_counter_t)c), 
+                    (unsigned long long)slot->counters[c]);
+        }
+        
+        fprintf(out, "  %-20s %10s %10s %10s %10s %10s\n", "latency (us)", "count", "p50", "p99", "max", "mean");
+        for (int h = 0; h < WM_HIST_COUNT; h++) {
+            const wm_histogram_t *hist = &slot->histograms[h];
+            uint64_t samples = hist->count;
+            fprintf(out, "  %-20s %10llu %10llu %10llu %10llu %10llu\n", 
+                    wm_stats_histogram_name((wm_stat_histogram_t)h),
+                    (unsigned long long)samples,
+                    (unsigned long long)wm_histogram_percentile(hist, 0.50),
+                    (unsigned long long)wm_histogram_percentile(hist, 0.99),
+                    (unsigned long long)hist->max_us,
+                    (unsigned long long)(samples ? hist->sum_us / samples : 0));
+        }
+        fprintf(out, "\n");
+    }
+}
+
+/**
+ * Print live counters and latency percentiles of every injected process
+ * from the shared registry segment until interrupted
+ */
+static int showStats(void) {
+    signal(SIGINT, statsSignalHandler);
+    signal(SIGTERM, statsSignalHandler);
+    
+    while (!statsStopRequested) {
+        // Clear the screen and home the cursor between refreshes
+        printf("\033[H\033[2J");
+        writeStatsReport(stdout, ", Ctrl-C to exit");
+        
+        fflush(stdout);
+        sleep(STATS_REFRESH_SECONDS);
+    }
+    
+    return 0;
+}
+
+/**
+ * Launch one target with its registry namespace and remember its PID
+ */
+static bool launchTarget(LaunchTarget *target) {
+    printf("\nLaunching %s with window modifier...\n", target->appName);
+    setenv("WM_REGISTRY_NAMESPACE", target->registryNamespace, 1);
+    printf("Registry namespace: %s\n", target->registryNamespace);
+    
+    target->launchTime = time(NULL);
+    target->launches++;
+    
+    // Inject the DYLIB into the executable
+    pid_t pid = injectDylib(target->executablePath, dylibPath);
+    if (pid == -1) {
+        printf("Error: Failed to inject DYLIB into %s\n", target->appName);
+        return false;
+    }
+    
+    target->pid = pid;
+    return true;
+}
+
+/**
+ * Open the supervisor's statistics socket (returns -1 if unavailable)
+ */
+static int openStatsSocket(void) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", SUPERVISOR_SOCKET_PATH);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        printf("Warning: Statistics socket unavailable: %s\n", strerror(errno));
+        return -1;
+    }
+    
+    // A socket file left by a previous supervisor would make bind fail
+    unlink(SUPERVISOR_SOCKET_PATH);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1 || listen(fd, 8) == -1) {
+        printf("Warning: Statistics socket unavailable: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    
+    printf("Serving statistics on %s\n", SUPERVISOR_SOCKET_PATH);
+    return fd;
+}
+
+/**
+ * Answer one statistics client with a snapshot of the supervised apps and their processes
+ */
+static void serveStats(int listenFd) {
+    int client = accept(listenFd, NULL, NULL);
+    if (client == -1) {
+        return;
+    }
+    
+    // A client that doesn't read must not stall the supervisor
+    struct timeval timeout = { 0, SUPERVISOR_SEND_TIMEOUT_USEC };
+    int on = 1;
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    
+    char *report = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&report, &size);
+    if (out) {
+        fprintf(out, "Supervised applications\n\n");
+        for (int i = 0; i < targetCount; i++) {
+            const LaunchTarget *target = &targets[i];
+            fprintf(out, "%s (%s): %s, %d launch%s, %d fork%s\n", target->appName, target->registryNamespace,
+                    target->pid > 0 ? "running" : target->relaunchPending ? "relaunch pending" : "stopped",
+                    target->launches, target->launches == 1 ? "" : "es",
+                    target->forks, target->forks == 1 ? "" : "s");
+        }
+        fprintf(out, "\n");
+        writeStatsReport(out, "");
+        fclose(out);
+        
+        for (size_t sent = 0; sent < size; ) {
+            ssize_t n = send(client, report + sent, size - sent, 0);
+            if (n <= 0) {
+                break;
+            }
+            sent += (size_t)n;
+        }
+        free(report);
+    }
+    
+    close(client);
+}
+
+// Forward declaration (a target that dies before it can be watched is handled as an exit)
+static void handleTargetExit(int kq, int index);
+
+/**
+ * Watch a launched target for exit, fork and exec
+ */
+static void watchTarget(int kq, int index) {
+    struct kevent change;
+    EV_SET(&change, targets[index].pid, EVFILT_PROC, EV_ADD, NOTE_EXIT | NOTE_FORK | NOTE_EXEC, 0,
+           (void *)(intptr_t)index);
+    if (kevent(kq, &change, 1, NULL, 0, NULL) == -1) {
+        handleTargetExit(kq, index);
+    }
+}
+
+/**
+ * Relaunch a target now, or arm a timer if it keeps crashing right after launch
+ */
+static void scheduleRelaunch(int kq, int index) {
+    LaunchTarget *target = &targets[index];
+    
+    // Back off on apps that crash right after launch instead of relaunching in a tight loop
+    long delayMs = 0;
+    if (time(NULL) - target->launchTime < SUPERVISOR_QUICK_CRASH_SECONDS) {
+        delayMs = SUPERVISOR_FIRST_BACKOFF_MS;
+        for (int i = 0; i < target->quickCrashes && delayMs < SUPERVISOR_MAX_BACKOFF_MS; i++) {
+            delayMs *= 2;
+        }
+        if (delayMs > SUPERVISOR_MAX_BACKOFF_MS) {
+            delayMs = SUPERVISOR_MAX_BACKOFF_MS;
+        }
+        target->quickCrashes++;
+    } else {
+        target->quickCrashes = 0;
+    }
+    
+    if (delayMs > 0) {
+        struct kevent change;
+        EV_SET(&change, index, EVFILT_TIMER, EV_ADD | EV_ONESHOT, 0, delayMs, NULL);
+        if (kevent(kq, &change, 1, NULL, 0, NULL) == 0) {
+            printf("Relaunching %s in %ld ms\n", target->appName, delayMs);
+            target->relaunchPending = true;
+            return;
+        }
+        perror("Failed to arm relaunch timer");
+    }
+    
+    if (launchTarget(target)) {
+        watchTarget(kq, index);
+    } else {
+        scheduleRelaunch(kq, index);
+    }
+}
+
+/**
+ * Reap an exited target and relaunch it if it didn't quit cleanly
+ */
+static void handleTargetExit(int kq, int index) {
+    LaunchTarget *target = &targets[index];
+    int status = 0;
+    if (waitpid(target->pid, &status, 0) == -1) {
+        perror("waitpid failed");
+    }
+    target->pid = 0;
+    
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        printf("%s quit normally, not relaunching\n", target->appName);
+        return;
+    }
+    
+    if (WIFSIGNALED(status)) {
+        printf("%s crashed (signal %d)\n", target->appName, WTERMSIG(status));
+    } else {
+        printf("%s exited with status: %d\n", target->appName, WEXITSTATUS(status));
+    }
+    scheduleRelaunch(kq, index);
+}
+
+/**
+ * Supervisor mode: launch the targets and relaunch them when they crash. One kqueue
+ * delivers process exits, forks and execs, relaunch timers, signals and statistics
+ * clients, so the supervisor sleeps until something happens.
+ */
+static int superviseTargets(void) {
+    int kq = kqueue();
+    if (kq == -1) {
+        perror("kqueue failed");
+        return 1;
+    }
+    
+    // Signals arrive as kqueue events instead of interrupting the loop
+    const int stopSignals[] = { SIGINT, SIGTERM, SIGHUP };
+    for (size_t i = 0; i < sizeof(stopSignals) / sizeof(stopSignals[0]); i++) {
+        signal(stopSignals[i], SIG_IGN);
+        struct kevent change;
+        EV_SET(&change, stopSignals[i], EVFILT_SIGNAL, EV_ADD, 0, 0, NULL);
+        kevent(kq, &change, 1, NULL, 0, NULL);
+    }
+    
+    // Hold every namespace open so its segments (and their grown shards) survive relaunches
+    for (int i = 0; i < targetCount; i++) {
+        setenv("WM_REGISTRY_NAMESPACE", targets[i].registryNamespace, 1);
+        targets[i].registry = registry_init();
+        if (!targets[i].registry) {
+            printf("Warning: Could not hold registry namespace %s open\n", targets[i].registryNamespace);
+        }
+    }
+    
+    int listenFd = openStatsSocket();
+    if (listenFd != -1) {
+        struct kevent change;
+        EV_SET(&change, listenFd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+        kevent(kq, &change, 1, NULL, 0, NULL);
+    }
+    
+    for (int i = 0; i < targetCount; i++) {
+        if (launchTarget(&targets[i])) {
+            watchTarget(kq, i);
+        } else {
+            scheduleRelaunch(kq, i);
+        }
+    }
+    
+    printf("\nSupervising %d application%s. Press Ctrl+C to stop.\n", targetCount, targetCount == 1 ? "" : "s");
+    
+    bool stopping = false;
+    while (!stopping) {
+        // Stop once every app quit normally
+        int supervised = 0;
+        for (int i = 0; i < targetCount; i++) {
+            if (targets[i].pid > 0 || targets[i].relaunchPending) {
+                supervised++;
+            }
+        }
+        if (supervised == 0) {
+            printf("All applications quit, supervisor exiting\n");
+            break;
+        }
+        
+        struct kevent events[MAX_TARGETS + 4];
+        int n = kevent(kq, NULL, 0, events, MAX_TARGETS + 4, NULL);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("kevent failed");
+            break;
+        }
+        
+        for (int e = 0; e < n && !stopping; e++) {
+            struct kevent *event = &events[e];
+            if (event->filter == EVFILT_PROC) {
+                int index = (int)(intptr_t)event->udata;
+                if (event->fflags & NOTE_FORK) {
+                    targets[index].forks++;
+                }
+                if (event->fflags & NOTE_EXEC) {
+                    printf("%s (pid %d) executed a new image\n", targets[index].appName, targets[index].pid);
+                }
+                if (event->fflags & NOTE_EXIT) {
+                    handleTargetExit(kq, index);
+                }
+            } else if (event->filter == EVFILT_TIMER) {
+                int index = (int)event->ident;
+                targets[index].relaunchPending = false;
+                if (launchTarget(&targets[index])) {
+                    watchTarget(kq, index);
+                } else {
+                    scheduleRelaunch(kq, index);
+                }
+            } else if (event->filter == EVFILT_READ) {
+                serveStats(listenFd);
+            } else if (event->filter == EVFILT_SIGNAL) {
+                printf("\nReceived signal %d, shutting down...\n", (int)event->ident);
+                stopping = true;
+            }
+        }
+    }
+    
+    // Terminate what is still running, then force kill the stragglers
+    pid_t pids[MAX_TARGETS];
+    int count = 0;
+    for (int i = 0; i < targetCount; i++) {
+        if (targets[i].pid > 0) {
+            kill(targets[i].pid, SIGTERM);
+            pids[count++] = targets[i].pid;
+        }
+    }
+    if (count > 0 && waitForProcessesExit(pids, count, TERMINATE_WAIT_MS) > 0) {
+        for (int i = 0; i < count; i++) {
+            if (pids[i] != 0) {
+                kill(pids[i], SIGKILL);
+            }
+        }
+    }
+    for (int i = 0; i < targetCount; i++) {
+        if (targets[i].pid > 0) {
+            waitpid(targets[i].pid, NULL, 0);
+            targets[i].pid = 0;
+        }
+    }
+    
+    // Releasing the last hold on a namespace removes its segments
+    for (int i = 0; i < targetCount; i++) {
+        registry_cleanup(targets[i].registry);
+        targets[i].registry = NULL;
+    }
+    
+    if (listenFd != -1) {
+        close(listenFd);
+        unlink(SUPERVISOR_SOCKET_PATH);
+    }
+    close(kq);
+    return 0;
+}
+
 /**
  * Main entry point
  */
@@ -480,40 +1144,124 @@ int main(int argc, char *argv[]) {
     const char* arch = detectCPUArchitecture();
     printf("Detected CPU Architecture: %s\n", arch);
     
+    // Stats mode only reads the shared registry; it must not reset it
+    if (argc >= 2 && strcmp(argv[1], "--stats") == 0) {
+        return showStats();
+    }
+    
     // Check command line arguments
     if (argc < 2) {
-        printf("Usage: %s /path/to/application.(app|executable) [--debug]\n", argv[0]);
-        printf("Description: Makes windows of the specified application float on top and non-activating.\n");
+        printf("Usage: %s /path/to/application.(app|executable) [more applications...] [--manifest file] [--supervise] [--debug] [--eager] [--reversible] [--rules file] [--include-helpers] [--trace]\n", argv[0]);
+        printf("       %s --stats\n", argv[0]);
+        printf("Description: Makes windows of the specified applications float on top and non-activating.\n");
         printf("Examples:\n");
         printf("  %s /Applications/YourApp.app\n", argv[0]);
         printf("  %s /Applications/AnotherApp.app --debug\n", argv[0]);
+        printf("  %s /Applications/YourApp.app /Applications/AnotherApp.app\n", argv[0]);
+        printf("  %s --manifest apps.txt\n", argv[0]);
+        printf("Options:\n");
+        printf("  --manifest  Also launch the applications listed in a file, one path per line\n");
+        printf("  --supervise  Keep running, relaunch applications that crash and serve statistics on %s\n", SUPERVISOR_SOCKET_PATH);
+        printf("  --debug  Enable debug logging and Objective-C diagnostics\n");
+        printf("  --eager  Initialize in every process at launch instead of on first window\n");
+        printf("  --reversible  Restore the original window level, sharing and tags when the library unloads\n");
+        printf("  --rules  Window and process targeting rules to use instead of the built-in ones\n");
+        printf("  --include-helpers  Also activate in utility helpers (GPU, network, plugins)\n");
+        printf("  --trace  Emit os_signpost intervals for Instruments (Points of Interest)\n");
+        printf("  --stats  Show live counters and latencies of all injected processes\n");
         return 1;
     }
     
-    // Get the application path from arguments
-    const char *appPath = argv[1];
-    bool debugMode = (argc > 2 && strcmp(argv[2], "--debug") == 0);
+    // Collect application paths and options; options apply to every application
+    bool debugMode = false;
+    bool eagerMode = false;
+    bool reversibleMode = false;
+    bool includeHelpers = false;
+    bool traceMode = false;
+    bool superviseMode = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--debug") == 0) {
+            debugMode = true;
+        } else if (strcmp(argv[i], "--eager") == 0) {
+            eagerMode = true;
+        } else if (strcmp(argv[i], "--reversible") == 0) {
+            reversibleMode = true;
+        } else if (strcmp(argv[i], "--include-helpers") == 0) {
+            includeHelpers = true;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            traceMode = true;
+        } else if (strcmp(argv[i], "--supervise") == 0) {
+            superviseMode = true;
+        } else if (strcmp(argv[i], "--rules") == 0) {
+            if (i + 1 >= argc) {
+                printf("Error: --rules requires a file\n");
+                return 1;
+            }
+            
+            // Injected processes may run from another directory
+            char rulesPath[PATH_MAX];
+            if (!realpath(argv[++i], rulesPath)) {
+                printf("Error: Rules file not found: %s\n", argv[i]);
+                return 1;
+            }
+            setenv("WM_RULES_FILE", rulesPath, 1);
+        } else if (strcmp(argv[i], "--manifest") == 0) {
+            if (i + 1 >= argc) {
+                printf("Error: --manifest requires a file\n");
+                return 1;
+            }
+            if (!readManifest(argv[++i])) {
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            printf("Warning: Ignoring unknown option: %s\n", argv[i]);
+        } else {
+            addTarget(argv[i]);
+        }
+    }
     
     if (debugMode) {
         printf("Debug mode enabled: extra logging will be displayed\n");
     }
     
-    // Verify the application exists
-    if (!isValidAppPath(appPath)) {
-        printf("Error: Application not found or not valid: %s\n", appPath);
+    if (!validateRules()) {
         return 1;
     }
     
-    // Find the executable path
-    char executablePath[PATH_MAX];
-    if (!findMainExecutable(appPath, executablePath, sizeof(executablePath))) {
-        printf("Error: Could not find main executable in: %s\n", appPath);
-        return 1;
+    // Resolve every application; one that can't be found doesn't hold up the others
+    int validCount = 0;
+    for (int i = 0; i < targetCount; i++) {
+        LaunchTarget *target = &targets[i];
+        
+        // Verify the application exists
+        if (!isValidAppPath(target->appPath)) {
+            printf("Error: Application not found or not valid: %s\n", target->appPath);
+            continue;
+        }
+        
+        // Find the executable path
+        if (!findMainExecutable(target->appPath, target->executablePath, sizeof(target->executablePath))) {
+            printf("Error: Could not find main executable in: %s\n", target->appPath);
+            continue;
+        }
+        
+        // Keep valid apps at the front of the list
+        if (validCount != i) {
+            targets[validCount] = *target;
+            target = &targets[validCount];
+        }
+        validCount++;
+        
+        // Get the app name (for logging and process management)
+        const char *appName = strrchr(target->executablePath, '/');
+        target->appName = appName ? appName + 1 : target->executablePath;
     }
+    targetCount = validCount;
     
-    // Get the app name (for logging and process management)
-    const char *appName = strrchr(executablePath, '/');
-    appName = appName ? appName + 1 : executablePath;
+    if (targetCount == 0) {
+        printf("Error: No application to launch\n");
+        return 1;
+    }
     
     // Get the DYLIB path (expected to be in the build directory)
     if (getcwd(dylibPath, sizeof(dylibPath)) == NULL) {
@@ -531,27 +1279,79 @@ int main(int argc, char *argv[]) {
     // Clean up registry files for fresh start
     cleanupRegistry();
     
-    // Kill any existing instances of the app
-    killRunningInstances(appName);
+    // Kill any existing instances of the apps
+    killRunningInstances(targets, targetCount);
     
     // Set up signal handlers for clean termination
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
     signal(SIGSEGV, signalHandler); // Also catch segfaults
     
-    printf("\nLaunching %s with window modifier...\n", appName);
-    
     // Set up debug environment if needed
     if (debugMode) {
         putenv("OBJC_DEBUG_MISSING_POOLS=YES");
         putenv("OBJC_PRINT_EXCEPTIONS=YES");
+        putenv("WM_LOG_LEVEL=debug");
     }
     
-    // Inject the DYLIB into the executable
-    if (injectDylib(executablePath, dylibPath, true) != 0) {
-        printf("Error: Failed to inject DYLIB into application\n");
+    // Helper processes that never show a window skip initialization entirely
+    if (!eagerMode) {
+        putenv("WM_LAZY_INIT=1");
+    } else {
+        unsetenv("WM_LAZY_INIT");
+    }
+    
+    // Modified windows are put back when the library unloads or the app is signalled
+    if (reversibleMode) {
+        putenv("WM_REVERSIBLE=1");
+    } else {
+        unsetenv("WM_REVERSIBLE");
+    }
+    
+    // Utility helpers stay inactive unless explicitly included
+    if (includeHelpers) {
+        putenv("WM_INCLUDE_HELPERS=1");
+    } else {
+        unsetenv("WM_INCLUDE_HELPERS");
+    }
+    
+    // Signposts cost nothing unless asked for
+    if (traceMode) {
+        putenv("WM_SIGNPOST=1");
+        printf("Tracing enabled: record with Instruments (Points of Interest) to see signpost intervals\n");
+    } else {
+        unsetenv("WM_SIGNPOST");
+    }
+    
+    // Give each app its own registry so it never contends with other injected apps;
+    // an explicit WM_REGISTRY_NAMESPACE in our environment wins (and is shared by all)
+    const char *explicitNamespace = getenv("WM_REGISTRY_NAMESPACE");
+    for (int i = 0; i < targetCount; i++) {
+        LaunchTarget *target = &targets[i];
+        if (explicitNamespace) {
+            snprintf(target->registryNamespace, sizeof(target->registryNamespace), "%s", explicitNamespace);
+        } else {
+            registryNamespaceForApp(target->appPath, target->appName,
+                                    target->registryNamespace, sizeof(target->registryNamespace));
+        }
+    }
+    
+    if (superviseMode) {
+        return superviseTargets();
+    }
+    
+    // Launch all apps without waiting on any of them
+    int launched = 0;
+    for (int i = 0; i < targetCount; i++) {
+        if (launchTarget(&targets[i])) {
+            launched++;
+        }
+    }
+    
+    if (launched == 0) {
         return 1;
     }
     
-    return 0;
+    printf("\n%d process%s running. Press Ctrl+C to exit.\n", launched, launched == 1 ? " is" : "es are");
+    return waitForTargets();
 }
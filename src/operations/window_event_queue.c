@@ -0,0 +1,132 @@
+// window_event_queue.c - Lock-free queue of CGS window notifications
+#include "window_event_queue.h"
+#include "../core/logging.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Keep producer and consumer cursors on separate cache lines
+#define EVENT_QUEUE_CACHE_LINE 64
+
+// Ring slot: sequence == position when free for that position,
+// position + 1 once an event for that position has been written
+typedef struct {
+    _Atomic size_t sequence;
+    window_event_t event;
+} event_slot_t;
+
+// Event queue structure
+struct window_event_queue {
+    event_slot_t* slots;           // Ring storage
+    size_t mask;                   // Capacity - 1 (capacity is a power of two)
+    _Alignas(EVENT_QUEUE_CACHE_LINE) _Atomic size_t enqueue_pos;  // Next position producers claim
+    _Alignas(EVENT_QUEUE_CACHE_LINE) _Atomic size_t dequeue_pos;  // Next position the consumer reads
+    _Alignas(EVENT_QUEUE_CACHE_LINE) _Atomic uint64_t dropped;    // Events dropped on overflow
+};
+
+// Create a queue
+window_event_queue_t* event_queue_create(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    
+    window_event_queue_t* queue = calloc(1, sizeof(window_event_queue_t));
+    if (!queue) {
+        WM_LOG_ERROR("[EventQueue] Failed to allocate queue: %s\n", strerror(errno));
+        return NULL;
+    }
+    
+    queue->slots = calloc(size, sizeof(event_slot_t));
+    if (!queue->slots) {
+        WM_LOG_ERROR("[EventQueue] Failed to allocate ring: %s\n", strerror(errno));
+        free(queue);
+        return NULL;
+    }
+    
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&queue->slots[i].sequence, i);
+    }
+    
+    queue->mask = size - 1;
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+    atomic_init(&queue->dropped, 0);
+    
+    return queue;
+}
+
+// Destroy a queue
+void event_queue_destroy(window_event_queue_t* queue) {
+    if (!queue) {
+        return;
+    }
+    
+    free(queue->slots);
+    free(queue);
+}
+
+// Add an event
+bool event_queue_push(window_event_queue_t* queue, const window_event_t* event) {
+    if (!queue || !event) {
+        return false;
+    }
+    
+    size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    
+    for (;;) {
+        event_slot_t* slot = &queue->slots[pos & queue->mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        
+        if (diff == 0) {
+            // Slot is free for this position, try to claim it
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->event = *event;
+                atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+                return true;
+            }
+            // CAS failure reloaded pos, retry with it
+        } else if (diff < 0) {
+            // Consumer hasn't freed this slot yet, the ring is full
+            atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            // Another producer claimed this position, catch up
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+}
+
+// Remove the oldest event
+bool event_queue_pop(window_event_queue_t* queue, window_event_t* out) {
+    if (!queue || !out) {
+        return false;
+    }
+    
+    size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    event_slot_t* slot = &queue->slots[pos & queue->mask];
+    size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    
+    // Empty, or a producer claimed the slot but hasn't finished writing it
+    if ((intptr_t)sequence - (intptr_t)(pos + 1) < 0) {
+        return false;
+    }
+    
+    *out = slot->event;
+    atomic_store_explicit(&slot->sequence, pos + queue->mask + 1, memory_order_release);
+    atomic_store_explicit(&queue->dequeue_pos, pos + 1, memory_order_relaxed);
+    
+    return true;
+}
+
+// Number of events dropped because the queue was full
+uint64_t event_queue_dropped(const window_event_queue_t* queue) {
+    if (!queue) {
+        return 0;
+    }
+    
+    return atomic_load_explicit(&((window_event_queue_t*)queue)->dropped, memory_order_relaxed);
+}
@@ -0,0 +1,41 @@
+// window_event_queue.h - Lock-free queue of CGS window notifications
+#ifndef WINDOW_EVENT_QUEUE_H
+#define WINDOW_EVENT_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../core/common_types.h"
+
+// This module is a bounded multi-producer / single-consumer ring buffer. The
+// CGS notification callback only pushes (type, windowID, timestamp) records;
+// the modifier queue drains them. Each slot carries a sequence number so
+// producers claim slots with a single CAS and never block (Vyukov's design).
+// Pushing onto a full queue drops the event and counts it.
+
+// Window event record
+typedef struct {
+    int type;                // kCGSWindow*Notification
+    CGSWindowID windowID;    // Window the event refers to
+    uint64_t timestamp;      // mach_absolute_time() when the event was received
+} window_event_t;
+
+// Event queue opaque type
+typedef struct window_event_queue window_event_queue_t;
+
+// Create a queue (capacity is rounded up to a power of two, returns NULL on failure)
+window_event_queue_t* event_queue_create(size_t capacity);
+
+// Destroy a queue (no producers or consumer may be active)
+void event_queue_destroy(window_event_queue_t* queue);
+
+// Add an event; safe from any thread, returns false if the queue was full
+bool event_queue_push(window_event_queue_t* queue, const window_event_t* event);
+
+// Remove the oldest event; only the single consumer may call this
+bool event_queue_pop(window_event_queue_t* queue, window_event_t* out);
+
+// Number of events dropped because the queue was full
+uint64_t event_queue_dropped(const window_event_queue_t* queue);
+
+#endif // WINDOW_EVENT_QUEUE_H
@@ -6,8 +6,22 @@
 #import "../tracker/window_registry.h"
 #include "../core/common_types.h"
 
-// Main thread function
-void* window_modifier_main(void* arg);
+// Eager mode: install the NSWindow swizzles and start the services immediately
+void window_modifier_eager_init(void);
+
+// Lazy mode: install the NSWindow swizzles only; services start on first window activity
+void window_modifier_lazy_init(void);
+
+// Start the services if they haven't been started yet (non-blocking)
+void ensureWindowModifierStarted(void);
+
+// Stop the event-driven scheduler
+void stopWindowModifier(void);
+
+// Reversible mode (WM_REVERSIBLE=1): put every modified window back to its
+// captured level, sharing state and tags in one update transaction.
+// Returns the number of windows restored; safe to call more than once.
+size_t restoreWindowModifications(void);
 
 // Handle window events
 void handleWindowEvent(int eventType, CGSWindowID windowID);
@@ -15,13 +29,29 @@ void handleWindowEvent(int eventType, CGSWindowID windowID);
 // Modify a window using CGS
 bool modifyWindowWithCGS(CGSWindowID windowID);
 
+// Modify several windows in one pass, grouped by owner connection (returns number modified)
+size_t modifyWindowsBatchWithCGS(const CGSWindowID *windowIDs, size_t count, WindowModificationOptions options);
+
+// Options used by the CGS modification paths
+WindowModificationOptions defaultWindowModificationOptions(void);
+
 // Modify a window using NSWindow
 bool modifyNSWindow(NSWindow *window);
 
-// Apply modifications to all visible windows
+// Remember an in-process NSWindow by window number (no-op until it has one)
+void registerNSWindow(NSWindow *window);
+
+// Apply modifications to visible windows that appeared since the previous sweep (call on the modifier queue)
 bool applyAllWindowModifications(void);
 
 // Check if application is fully initialized
 bool isApplicationInitialized(void);
 
+// Retry queue statistics
+size_t getRetryQueueDepth(void);
+uint64_t getRetryQueueDroppedCount(void);
+
+// Notification queue statistics
+uint64_t getEventQueueDroppedCount(void);
+
 #endif // WINDOW_MODIFIER_H
@@ -2,17 +2,26 @@
 #import "window_modifier.h"
 #import "../cgs/window_modifier_cgs.h"
 #import "../tracker/window_classifier.h"
+#import "../tracker/window_table.h"
+#import "../tracker/window_rules.h"
+#import "../tracker/window_stats.h"
+#import "../core/logging.h"
+#import "../core/trace.h"
+#import "../core/process_role.h"
+#import "window_retry_queue.h"
+#import "window_event_queue.h"
 #import <objc/runtime.h>
+#import <mach/mach_time.h>
+#import <stdatomic.h>
 #import <sys/time.h>
 #import <pthread.h>
+#import <signal.h>
 #import <unistd.h>
 
-// Access to CGS window states dictionary
-extern CFMutableDictionaryRef window_states;
-
 // Declare NSWindow private methods
 @interface NSWindow (PrivateMethods)
 - (void)_setPreventsActivation:(BOOL)preventsActivation;
+- (BOOL)_preventsActivation;
 @end
 
 // Global state
@@ -21,22 +30,98 @@ window_registry_t *window_registry = NULL;  // Updated to make it externally vis
 static bool is_cgs_monitor_active = false;
 static process_role_t current_process_role = PROCESS_ROLE_MAIN;
 static time_t process_start_time = 0;
-static int modified_window_count = 0;
+static _Atomic int modified_window_count = 0;
 // Application startup detection and protection times (for all macOS applications)
 static const int STARTUP_PROTECTION_SECONDS = 0; // Reduced protection period
 static const int MAX_PROTECTED_WINDOWS = 2; // Limit for protected windows
-static retry_window_t retry_windows[32];
-static int retry_window_count = 0;
+static window_retry_queue_t *retry_queue = NULL; // Owned by modifier_queue
+static const size_t RETRY_QUEUE_INITIAL_CAPACITY = 32;
+static const size_t RETRY_QUEUE_MAX_CAPACITY = 4096;
 static double retry_delays[] = {0.1, 0.3, 0.6, 1.0, 2.0}; // Progressive delays in seconds
 static const int max_retry_attempts = 5;
 
+// Event-driven scheduling. Notifications and retries run on modifier_queue at
+// user-interactive QoS so a newly shown window is modified right away; sweeps of
+// the whole screen are background work and run on sweep_queue at utility QoS.
+// Only NSWindow calls go to the main queue.
+static dispatch_queue_t modifier_queue = NULL;
+static dispatch_queue_t sweep_queue = NULL;
+static dispatch_source_t retry_timer = NULL;
+static char modifier_queue_key;    // Queue-specific key identifying modifier_queue
+static _Atomic bool sweep_pending = false; // A coalesced sweep is already scheduled
+static const double SWEEP_COALESCE_SECONDS = 0.25; // Burst window before a requested sweep runs
+#define SWEEP_INITIAL_CAPACITY 128   // On-screen windows fetched per sweep before growing
+#define SWEEP_MAX_CAPACITY 65536
+#define BATCH_STACK_WINDOWS 64       // Batches up to this size are filtered on the stack
+
+// Sweep snapshot (sweep_queue only): sorted on-screen IDs of the last sweep,
+// the list being fetched, and the newly appeared windows handed to the batch
+static CGSWindowID *sweep_current = NULL;
+static CGSWindowID *sweep_previous = NULL;
+static CGSWindowID *sweep_candidates = NULL;
+static size_t sweep_capacity = 0;
+static size_t sweep_previous_count = 0;
+static const uint64_t RETRY_TIMER_LEEWAY_NSEC = 1 * NSEC_PER_MSEC;
+
+// CGS notifications are queued by the callback and drained on modifier_queue
+static window_event_queue_t *event_queue = NULL;
+static dispatch_source_t event_source = NULL;
+static const size_t EVENT_QUEUE_CAPACITY = 1024;
+#define EVENT_DRAIN_BATCH 256        // Events coalesced per drain pass
+#define EVENT_COALESCE_SLOTS 512     // Per-pass window lookup slots (power of two, 2x batch)
+
+// Events for one window collapsed over a drain pass
+typedef struct {
+    CGSWindowID windowID;
+    uint32_t mask;          // 1 << notification type for each type seen
+    int lastVisibility;     // Last order-in / order-out seen (0 if none)
+    uint64_t firstTimestamp; // Arrival of the window's first event in this pass (mach ticks)
+} coalesced_window_t;
+
+// Time one CGS call into the stats histogram (and a signpost interval when
+// tracing), evaluating to its status
+#define TIMED_CGS_CALL(call) ({ \
+    wm_trace_id_t cgsCallSpan_ = wm_trace_make_id(); \
+    WM_TRACE_BEGIN(cgsCallSpan_, "CGSCall", "%{public}s", #call); \
+    uint64_t cgsCallStart_ = wm_stats_now(); \
+    OSStatus cgsCallStatus_ = (call); \
+    wm_stats_increment(WM_STAT_CGS_CALLS); \
+    wm_stats_record_since(WM_HIST_CGS_CALL, cgsCallStart_); \
+    WM_TRACE_END(cgsCallSpan_, "CGSCall", "status %d", (int)cgsCallStatus_); \
+    cgsCallStatus_; \
+})
+
+// Set once something has asked for the services to start (see ensureWindowModifierStarted)
+static _Atomic bool services_requested = false;
+
+// Reversible mode: original attributes are captured before the first modification
+// and restored in bulk on unload or on a terminating signal
+static const int restore_signals[] = {SIGTERM, SIGINT, SIGHUP};
+static dispatch_source_t restore_sources[sizeof(restore_signals) / sizeof(restore_signals[0])];
+
 // Thread-local storage for current window context
 static pthread_key_t current_window_key;
 static bool thread_keys_initialized = false;
 
 // Application initialization state tracking
-static app_init_state_t current_init_state = APP_INIT_NOT_STARTED;
-static int main_window_count = 0;
+static _Atomic app_init_state_t current_init_state = APP_INIT_NOT_STARTED;
+static CGSWindowID mainWindowID = 0;                 // Likely main window, once identified
+
+// Startup gate: modifications wait until the app looks initialized. Opening it
+// is decided in O(1) from the window table's running counts (or by a one-shot
+// timer for the time fallback); windows that show up before then wait here and
+// are modified in one batch when it opens.
+#define GATE_WAITER_CAPACITY 256
+static _Atomic bool init_gate_open = false;
+static dispatch_source_t init_gate_timer = NULL;     // Time fallback (modifier_queue only)
+static CGSWindowID gate_waiters[GATE_WAITER_CAPACITY];
+static size_t gate_waiter_count = 0;
+static bool gate_sweep_wanted = false;               // A sweep was deferred, or a waiter didn't fit
+static pthread_mutex_t gateMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// In-process windows by window number (weak values), kept current by the swizzles
+static NSMapTable *nsWindowsByID = nil;
+static pthread_mutex_t nsWindowsMutex = PTHREAD_MUTEX_INITIALIZER;
 
 // Import swizzling header
 #import "window_modifier_swizzle.h"
@@ -44,44 +129,47 @@ static int main_window_count = 0;
 // Forward declarations for internal functions
 static bool modifyWindowWithCGSInternal(CGSWindowID windowID, bool isRetry);
 static void addWindowToRetryQueue(CGSWindowID windowID);
+static void queueWindowRetry(CGSWindowID windowID);
+static void dropWindowRetry(CGSWindowID windowID);
+static bool onModifierQueue(void);
+static bool reversibleModeEnabled(void);
+static void captureOriginalState(CGSWindowID windowID, CGSConnectionID cid);
+static void captureNSWindowOriginalState(NSWindow *window);
+static window_class_t classifyNSWindow(NSWindow *window);
+static void installRestoreSignalHandlers(void);
+static double elapsedMilliseconds(uint64_t start);
 static void processRetryQueue(void);
+static void scheduleRetryTimer(void);
+static void requestWindowSweep(void);
 static void startWindowMonitoring(void);
 static void saveFrontmostApp(void);
 static void restoreFrontmostApp(void);
-static void updateWindowState(int eventType, CGSWindowID windowID);
+static void updateWindowState(int eventType, CGSWindowID windowID, uint64_t eventTicks);
 static void windowNotificationCallback(int type, void *data, uint32_t data_length, void *arg);
-static void countInitializedStandardWindows(const void *key, const void *value, void *context);
-static void countStandardWindows(const void *key, const void *value, void *context);
 static void updateInitializationState(int eventType, CGSWindowID windowID);
-static process_role_t detectProcessRole(void);
+static bool advanceInitState(app_init_state_t state);
+static bool evaluateInitGate(void);
+static void openInitGate(void);
+static void armInitGateTimer(void);
+static void cancelInitGateTimer(void);
+static void waitForInitGate(CGSWindowID windowID);
+static bool deferSweepToInitGate(void);
+static void releaseGateWaiters(void);
+static void forgetWindow(CGSWindowID windowID);
+static void drainWindowEvents(void);
+static void applyWindowEvents(const coalesced_window_t *pending);
+static void recordWindowModified(CGSWindowID windowID);
 static NSWindow* findNSWindowByID(CGSWindowID windowID);
+static void unregisterNSWindowID(CGSWindowID windowID);
 static bool modifyWindowWithNSWindow(CGSWindowID windowID);
 static void modifyWindowWhenSafe(CGSWindowID windowID);
 
-// Function to count initialized standard windows for the dictionary applier
-static void countInitializedStandardWindows(const void * __attribute__((unused)) key, const void *value, void *context) {
-    window_init_state_t *state = (window_init_state_t *)value;
-    if (state->window_class == WINDOW_CLASS_STANDARD && state->is_initialized) {
-        int *counter = (int *)context;
-        (*counter)++;
-    }
-}
-
-// Function to count all standard windows (initialized or not)
-static void countStandardWindows(const void * __attribute__((unused)) key, const void *value, void *context) {
-    window_init_state_t *state = (window_init_state_t *)value;
-    if (state->window_class == WINDOW_CLASS_STANDARD) {
-        int *counter = (int *)context;
-        (*counter)++;
-    }
-}
-
 // Save previous app
 static void __attribute__((unused)) saveFrontmostApp(void) {
     NSRunningApplication *frontApp = [[NSWorkspace sharedWorkspace] frontmostApplication];
     if (frontApp && ![frontApp.bundleIdentifier isEqualToString:[[NSBundle mainBundle] bundleIdentifier]]) {
         previousFrontmostApp = frontApp;
-        printf("[Modifier] Saved frontmost app: %s\n", [frontApp.localizedName UTF8String]);
+        WM_LOG_INFO("[Modifier] Saved frontmost app: %s\n", [frontApp.localizedName UTF8String]);
     }
 }
 
@@ -89,7 +177,7 @@ static void __attribute__((unused)) saveFrontmostApp(void) {
 static void __attribute__((unused)) restoreFrontmostApp(void) {
     if (previousFrontmostApp) {
         [previousFrontmostApp activateWithOptions:0];
-        printf("[Modifier] Restored focus to: %s\n", [previousFrontmostApp.localizedName UTF8String]);
+        WM_LOG_INFO("[Modifier] Restored focus to: %s\n", [previousFrontmostApp.localizedName UTF8String]);
     }
 }
 
@@ -106,17 +194,216 @@ bool isInStartupProtection(void) {
             (modified_window_count < MAX_PROTECTED_WINDOWS));
 }
 
+// Default modification options applied by the CGS paths
+WindowModificationOptions defaultWindowModificationOptions(void) {
+    WindowModificationOptions options = {
+        .keepAbove = true,
+        .nonActivating = true,
+        .ignoreExpose = false,
+        .allowsMoving = true,
+        .excludeFromCapture = true,
+        .level = kCGSWindowLevelForKey,
+        .opacity = 1.0f
+    };
+    return options;
+}
+
 // Modify a window using CGS (thread-safe public interface)
 bool modifyWindowWithCGS(CGSWindowID windowID) {
     // Just a wrapper that calls the internal function with retry=false
     return modifyWindowWithCGSInternal(windowID, false);
 }
 
+// Check if modifications should be reversible (WM_REVERSIBLE set by the injector)
+static bool reversibleModeEnabled(void) {
+    static dispatch_once_t onceToken;
+    static bool enabled = false;
+    dispatch_once(&onceToken, ^{
+        const char *value = getenv("WM_REVERSIBLE");
+        enabled = value && value[0] != '\0' && strcmp(value, "0") != 0;
+    });
+    return enabled;
+}
+
+// Record a window's level, sharing state and tags before we first touch it
+static void captureOriginalState(CGSWindowID windowID, CGSConnectionID cid) {
+    if (!reversibleModeEnabled() || window_table_has_original(windowID)) {
+        return;
+    }
+    
+    window_original_state_t original = {windowID, 0, kCGSWindowSharingReadOnlyValue, 0};
+    
+    if (CGSGetWindowLevel_ptr && 
+        TIMED_CGS_CALL(CGSGetWindowLevel_ptr(cid, windowID, &original.level)) == kCGErrorSuccess) {
+        original.flags |= WINDOW_ORIGINAL_HAS_LEVEL;
+    }
+    
+    if (CGSGetWindowSharingState_ptr && 
+        TIMED_CGS_CALL(CGSGetWindowSharingState_ptr(cid, windowID, &original.sharing_state)) == kCGErrorSuccess) {
+        original.flags |= WINDOW_ORIGINAL_HAS_SHARING;
+    }
+    
+    // The tag size is passed by value, in bits: two 32-bit words
+    int32_t tags[2] = {0, 0};
+    if (CGSGetWindowTags_ptr && 
+        TIMED_CGS_CALL(CGSGetWindowTags_ptr(cid, windowID, tags, 64)) == kCGErrorSuccess) {
+        original.flags |= WINDOW_ORIGINAL_HAS_TAGS;
+        if (tags[0] & kCGSPreventsActivationTagBit) {
+            original.flags |= WINDOW_ORIGINAL_PREVENTS_ACTIVATION;
+        }
+    }
+    
+    if (window_table_save_original(&original)) {
+        WM_LOG_DEBUG("[Modifier] Captured original state of window %d (level %d, sharing %d, flags 0x%x)\n", 
+                     windowID, original.level, original.sharing_state, original.flags);
+    }
+}
+
+// Record an AppKit window's original attributes from its own properties, so the
+// main thread makes no WindowServer calls. NSWindow levels and sharing types use
+// the same values as their CGS counterparts.
+static void captureNSWindowOriginalState(NSWindow *window) {
+    CGSWindowID windowID = (CGSWindowID)[window windowNumber];
+    if (window_table_has_original(windowID)) {
+        return;
+    }
+    
+    window_original_state_t original = {windowID, (int)window.level, kCGSWindowSharingReadOnlyValue, 
+                                        WINDOW_ORIGINAL_HAS_LEVEL};
+    
+    if ([window respondsToSelector:@selector(sharingType)]) {
+        original.sharing_state = (int)window.sharingType;
+        original.flags |= WINDOW_ORIGINAL_HAS_SHARING;
+    }
+    
+    if ([window respondsToSelector:@selector(_preventsActivation)]) {
+        original.flags |= WINDOW_ORIGINAL_HAS_TAGS;
+        if ([window _preventsActivation]) {
+            original.flags |= WINDOW_ORIGINAL_PREVENTS_ACTIVATION;
+        }
+    }
+    
+    if (window_table_save_original(&original)) {
+        WM_LOG_DEBUG("[Modifier] Captured original state of NSWindow %d (level %d, sharing %d, flags 0x%x)\n", 
+                     windowID, original.level, original.sharing_state, original.flags);
+    }
+}
+
+// Apply level, sharing state and tags to one window, trying the owner connection first.
+// Returns true if the level or the non-activating tag was applied.
+static bool applyCGSModifications(CGSWindowID windowID, CGSConnectionID cid, CGSConnectionID ownerCID,
+                                  WindowModificationOptions options, bool *tagSuccessOut) {
+    bool tagSuccess = false;
+    
+    captureOriginalState(windowID, cid);
+    
+    // Set window level to floating - try owner connection first if different
+    OSStatus levelStatus = kCGErrorFailure;
+    if (options.keepAbove) {
+        if (ownerCID != 0 && ownerCID != cid) {
+            levelStatus = TIMED_CGS_CALL(CGSSetWindowLevel_ptr(ownerCID, windowID, options.level));
+        }
+        
+        // If owner connection failed or is the same, try our connection
+        if (levelStatus != kCGErrorSuccess) {
+            levelStatus = TIMED_CGS_CALL(CGSSetWindowLevel_ptr(cid, windowID, options.level));
+        }
+        
+        if (levelStatus != kCGErrorSuccess) {
+            WM_LOG_WARN("[Modifier] Failed to set window level for %d (Error: %d)\n", windowID, (int)levelStatus);
+            // Don't fail completely, continue with other modifications
+        }
+    }
+    
+    // Enable screen recording bypass by setting window sharing to none
+    if (options.excludeFromCapture) {
+        OSStatus sharingStatus = kCGErrorFailure;
+        
+        // Try with owner connection if different
+        if (ownerCID != 0 && ownerCID != cid) {
+            sharingStatus = TIMED_CGS_CALL(CGSSetWindowSharingState_ptr(ownerCID, windowID, kCGSWindowSharingNoneValue));
+            if (sharingStatus == kCGErrorSuccess) {
+                WM_LOG_DEBUG("[Modifier] Successfully set screen recording bypass using owner connection\n");
+            }
+        }
+        
+        // If owner connection failed or is the same, try our connection
+        if (sharingStatus != kCGErrorSuccess) {
+            sharingStatus = TIMED_CGS_CALL(CGSSetWindowSharingState_ptr(cid, windowID, kCGSWindowSharingNoneValue));
+            if (sharingStatus == kCGErrorSuccess) {
+                WM_LOG_DEBUG("[Modifier] Successfully set screen recording bypass using our connection\n");
+            }
+        }
+        
+        // If both failed, try with default connection as last resort
+        if (sharingStatus != kCGErrorSuccess) {
+            CGSConnectionID defaultCID = CGSDefaultConnection_ptr();
+            if (defaultCID != cid && defaultCID != ownerCID) {
+                sharingStatus = TIMED_CGS_CALL(CGSSetWindowSharingState_ptr(defaultCID, windowID, kCGSWindowSharingNoneValue));
+                if (sharingStatus == kCGErrorSuccess) {
+                    WM_LOG_DEBUG("[Modifier] Successfully set screen recording bypass using default connection\n");
+                } else {
+                    WM_LOG_WARN("[Modifier] Failed to set screen recording bypass for %d (Error: %d)\n", 
+                                windowID, (int)sharingStatus);
+                }
+            }
+        }
+    }
+    
+    // Add prevents-activation tag
+    if (options.nonActivating) {
+        int tag = kCGSPreventsActivationTagBit;
+        
+        // First attempt: Try with owner connection if different
+        if (ownerCID != cid) {
+            OSStatus status = TIMED_CGS_CALL(CGSSetWindowTags_ptr(ownerCID, windowID, &tag, 1));
+            if (status == kCGErrorSuccess) {
+                WM_LOG_DEBUG("[Modifier] Successfully set tags using owner connection\n");
+                tagSuccess = true;
+            } else {
+                WM_LOG_DEBUG("[Modifier] Failed to set tags with owner connection (Error: %d)\n", (int)status);
+            }
+        }
+        
+        // Second attempt: Try with our connection if first failed
+        if (!tagSuccess) {
+            OSStatus status = TIMED_CGS_CALL(CGSSetWindowTags_ptr(cid, windowID, &tag, 1));
+            if (status == kCGErrorSuccess) {
+                WM_LOG_DEBUG("[Modifier] Successfully set tags using our connection\n");
+                tagSuccess = true;
+            } else {
+                WM_LOG_DEBUG("[Modifier] Failed to set tags with our connection (Error: %d)\n", (int)status);
+            }
+        }
+        
+        // Third attempt: Try with default connection as last resort
+        if (!tagSuccess) {
+            CGSConnectionID defaultCID = CGSDefaultConnection_ptr();
+            if (defaultCID != cid && defaultCID != ownerCID) {
+                OSStatus status = TIMED_CGS_CALL(CGSSetWindowTags_ptr(defaultCID, windowID, &tag, 1));
+                if (status == kCGErrorSuccess) {
+                    WM_LOG_DEBUG("[Modifier] Successfully set tags using default connection\n");
+                    tagSuccess = true;
+                } else {
+                    WM_LOG_WARN("[Modifier] Failed with all connection attempts for tag setting\n");
+                }
+            }
+        }
+    }
+    
+    if (tagSuccessOut) {
+        *tagSuccessOut = tagSuccess;
+    }
+    
+    // Even if tag setting fails, consider successful if we at least set the window level
+    return (levelStatus == kCGErrorSuccess || tagSuccess);
+}
+
 // Modify a window using CGS (internal implementation)
 static bool modifyWindowWithCGSInternal(CGSWindowID windowID, bool isRetry) {
     if (!CGSDefaultConnection_ptr || !CGSSetWindowLevel_ptr || 
         !CGSSetWindowSharingState_ptr || !CGSSetWindowTags_ptr) {
-        printf("[Modifier] Error: Required CGS functions not loaded\n");
+        WM_LOG_ERROR("[Modifier] Error: Required CGS functions not loaded\n");
         return false;
     }
     
@@ -125,21 +412,27 @@ static bool modifyWindowWithCGSInternal(CGSWindowID windowID, bool isRetry) {
         return false;
     }
     
+    // Windows already modified through their NSWindow need no CGS round trips
+    if (window_table_is_handled(windowID)) {
+        WM_LOG_DEBUG("[Modifier] Info: Window %d already modified (NSWindow)\n", windowID);
+        return true;
+    }
+    
     // Check if we've already modified this window via cross-process registry
     if (window_registry && registry_is_window_modified(window_registry, windowID)) {
-        printf("[Modifier] Info: Window %d already modified (registry)\n", windowID);
+        WM_LOG_DEBUG("[Modifier] Info: Window %d already modified (registry)\n", windowID);
         return true;
     }
     
     // Check if it's an utility window that we should skip
     if (isUtilityWindow(windowID)) {
-        printf("[Modifier] Skipping utility window: %d\n", windowID);
+        WM_LOG_DEBUG("[Modifier] Skipping utility window: %d\n", windowID);
         return false;
     }
     
     // Check if the window is ready for modification
     if (!isRetry && !isWindowReadyForModification(windowID)) {
-        printf("[Modifier] Window %d not ready, adding to retry queue\n", windowID);
+        WM_LOG_DEBUG("[Modifier] Window %d not ready, adding to retry queue\n", windowID);
         addWindowToRetryQueue(windowID);
         return false;
     }
@@ -147,20 +440,18 @@ static bool modifyWindowWithCGSInternal(CGSWindowID windowID, bool isRetry) {
     // Apply modifications
     CGSConnectionID cid = CGSDefaultConnection_ptr();
     CGSConnectionID ownerCID = 0;
-    bool success = true;
     bool tagSuccess = false;
     
-    // Get window owner information first
-    if (CGSGetWindowOwner_ptr) {
-        ownerCID = CGSGetWindowOwner_ptr(cid, windowID);
+    // Get window owner information first (cached after the first lookup)
+    if (getWindowOwnerCached(windowID, &ownerCID)) {
         if (ownerCID != cid) {
-            printf("[Modifier] Window %d is owned by a different connection (Owner: %d, Current: %d)\n", 
-                   windowID, ownerCID, cid);
+            WM_LOG_DEBUG("[Modifier] Window %d is owned by a different connection (Owner: %d, Current: %d)\n", 
+                         windowID, ownerCID, cid);
             
             // Special case: Owner ID 0 indicates a system window or special permission window
             // These windows should be completely avoided to prevent crashes
             if (ownerCID == 0) {
-                printf("[Modifier] Window %d has special ownership (ID 0), avoiding modification\n", windowID);
+                WM_LOG_DEBUG("[Modifier] Window %d has special ownership (ID 0), avoiding modification\n", windowID);
                 // Mark as modified in registry to avoid future attempts
                 if (window_registry) {
                     registry_mark_window_modified(window_registry, windowID);
@@ -170,147 +461,348 @@ static bool modifyWindowWithCGSInternal(CGSWindowID windowID, bool isRetry) {
         }
     }
     
-    // Set window level to floating - try owner connection first if different
-    OSStatus levelStatus = kCGErrorFailure;
-    if (ownerCID != 0 && ownerCID != cid) {
-        levelStatus = CGSSetWindowLevel_ptr(ownerCID, windowID, kCGSWindowLevelForKey);
+    wm_trace_id_t span = wm_trace_make_id();
+    WM_TRACE_BEGIN(span, "ModifyWindow", "window %d owner %d retry %d", windowID, ownerCID, isRetry);
+    bool success = applyCGSModifications(windowID, cid, ownerCID, 
+                                         defaultWindowModificationOptions(), &tagSuccess);
+    WM_TRACE_END(span, "ModifyWindow", "success %d", success);
+    
+    // Log comprehensive window details if tag setting failed
+    if (!tagSuccess) {
+        WM_LOG_WARN("[Modifier] WARNING: Unable to set non-activating tag for window %d\n", windowID);
+        
+        // The window info lookup is an IPC round trip, only pay for it when it will be logged
+        NSDictionary *windowInfo = (wm_log_level >= WM_LOG_LEVEL_DEBUG) ? getWindowInfoWithCGS(windowID) : nil;
+        if (windowInfo) {
+            // Log key window properties for debugging
+            NSString *windowName = windowInfo[@"kCGSWindowTitle"];
+            NSString *windowOwner = windowInfo[@"kCGSWindowOwnerName"];
+            NSNumber *alpha = windowInfo[@"kCGSWindowAlpha"];
+            NSNumber *width = windowInfo[@"kCGSWindowWidth"];
+            NSNumber *height = windowInfo[@"kCGSWindowHeight"];
+            NSString *windowLayer = windowInfo[@"kCGSWindowLayer"];
+            NSNumber *windowLevel = windowInfo[@"kCGSWindowLevel"];
+            
+            WM_LOG_DEBUG("[Modifier] Window Properties for ID %d:\n", windowID);
+            WM_LOG_DEBUG("  - Title: '%s', Owner: '%s'\n",
+                         windowName ? [windowName UTF8String] : "unknown",
+                         windowOwner ? [windowOwner UTF8String] : "unknown");
+            WM_LOG_DEBUG("  - Alpha: %f\n", alpha ? [alpha doubleValue] : -1);
+            WM_LOG_DEBUG("  - Size: %dx%d\n", width ? [width intValue] : -1, height ? [height intValue] : -1);
+            WM_LOG_DEBUG("  - Layer: %s\n", windowLayer ? [windowLayer UTF8String] : "unknown");
+            WM_LOG_DEBUG("  - Level: %d\n", windowLevel ? [windowLevel intValue] : -1);
+        }
     }
     
-    // If owner connection failed or is the same, try our connection
-    if (levelStatus != kCGErrorSuccess) {
-        levelStatus = CGSSetWindowLevel_ptr(cid, windowID, kCGSWindowLevelForKey);
+    if (success) {
+        WM_LOG_DEBUG("[Modifier] Successfully modified window: %d\n", windowID);
+        recordWindowModified(windowID);
+        
+        // Mark as modified in registry
+        if (window_registry) {
+            registry_mark_window_modified(window_registry, windowID);
+        }
+        
+        modified_window_count++;
+    } else {
+        wm_stats_increment(WM_STAT_MODIFY_FAILURES);
     }
     
-    if (levelStatus != kCGErrorSuccess) {
-        printf("[Modifier] Failed to set window level for %d (Error: %d)\n", windowID, (int)levelStatus);
-        // Don't fail completely, continue with other modifications
+    return success;
+}
+
+// Count a successful modification and its latency from the event that triggered it
+static void recordWindowModified(CGSWindowID windowID) {
+    wm_stats_increment(WM_STAT_WINDOWS_MODIFIED);
+    
+    uint64_t eventTicks = window_table_take_event(windowID);
+    if (eventTicks != 0) {
+        wm_stats_record_since(WM_HIST_EVENT_TO_MODIFIED, eventTicks);
+    }
+}
+
+// Window paired with its resolved owner connection for batch processing
+typedef struct {
+    CGSWindowID windowID;
+    CGSConnectionID ownerCID;
+} batch_window_t;
+
+// Order batch windows by owner connection so each connection is handled in one run
+static int compareBatchWindowsByOwner(const void *a, const void *b) {
+    const batch_window_t *wa = (const batch_window_t *)a;
+    const batch_window_t *wb = (const batch_window_t *)b;
+    if (wa->ownerCID != wb->ownerCID) {
+        return (wa->ownerCID < wb->ownerCID) ? -1 : 1;
+    }
+    return (wa->windowID < wb->windowID) ? -1 : (wa->windowID > wb->windowID);
+}
+
+// Modify several windows in one pass: filter, resolve owners once, group by connection,
+// and apply inside a WindowServer update transaction when available.
+// Returns the number of windows successfully modified.
+size_t modifyWindowsBatchWithCGS(const CGSWindowID *windowIDs, size_t count, WindowModificationOptions options) {
+    if (!windowIDs || count == 0) {
+        return 0;
     }
     
-    // Enable screen recording bypass by setting window sharing to none
-    OSStatus sharingStatus = kCGErrorFailure;
+    if (!CGSDefaultConnection_ptr || !CGSSetWindowLevel_ptr || 
+        !CGSSetWindowSharingState_ptr || !CGSSetWindowTags_ptr) {
+        WM_LOG_ERROR("[Modifier] Error: Required CGS functions not loaded\n");
+        return 0;
+    }
     
-    // Try with owner connection if different
-    if (ownerCID != 0 && ownerCID != cid) {
-        sharingStatus = CGSSetWindowSharingState_ptr(ownerCID, windowID, kCGSWindowSharingNoneValue);
-        if (sharingStatus == kCGErrorSuccess) {
-            printf("[Modifier] Successfully set screen recording bypass using owner connection\n");
-        }
+    // Event-driven batches are small; only large sweeps go to the heap
+    batch_window_t stackPending[BATCH_STACK_WINDOWS];
+    batch_window_t *pending = (count <= BATCH_STACK_WINDOWS) ? stackPending : malloc(count * sizeof(batch_window_t));
+    if (!pending) {
+        WM_LOG_ERROR("[Modifier] Error: Failed to allocate batch of %zu windows\n", count);
+        return 0;
     }
     
-    // If owner connection failed or is the same, try our connection
-    if (sharingStatus != kCGErrorSuccess) {
-        sharingStatus = CGSSetWindowSharingState_ptr(cid, windowID, kCGSWindowSharingNoneValue);
-        if (sharingStatus == kCGErrorSuccess) {
-            printf("[Modifier] Successfully set screen recording bypass using our connection\n");
+    CGSConnectionID cid = CGSDefaultConnection_ptr();
+    size_t pendingCount = 0;
+    
+    // Filter phase: same checks as the single-window path, owners resolved once per window
+    for (size_t i = 0; i < count; i++) {
+        CGSWindowID windowID = windowIDs[i];
+        
+        if (windowID <= 0 || window_table_is_handled(windowID)) {
+            continue;
+        }
+        
+        if (window_registry && registry_is_window_modified(window_registry, windowID)) {
+            continue;
+        }
+        
+        if (isUtilityWindow(windowID)) {
+            continue;
         }
+        
+        if (!isWindowReadyForModification(windowID)) {
+            addWindowToRetryQueue(windowID);
+            continue;
+        }
+        
+        CGSConnectionID ownerCID = cid;
+        if (getWindowOwnerCached(windowID, &ownerCID) && ownerCID == 0) {
+            // Owner ID 0 windows are never touched; remember them so they aren't re-evaluated
+            if (window_registry) {
+                registry_mark_window_modified(window_registry, windowID);
+            }
+            continue;
+        }
+        
+        pending[pendingCount].windowID = windowID;
+        pending[pendingCount].ownerCID = ownerCID;
+        pendingCount++;
     }
     
-    // If both failed, try with default connection as last resort
-    if (sharingStatus != kCGErrorSuccess) {
-        CGSConnectionID defaultCID = CGSDefaultConnection_ptr();
-        if (defaultCID != cid && defaultCID != ownerCID) {
-            sharingStatus = CGSSetWindowSharingState_ptr(defaultCID, windowID, kCGSWindowSharingNoneValue);
-            if (sharingStatus == kCGErrorSuccess) {
-                printf("[Modifier] Successfully set screen recording bypass using default connection\n");
-            } else {
-                printf("[Modifier] Failed to set screen recording bypass for %d (Error: %d)\n", 
-                       windowID, (int)sharingStatus);
-            }
+    if (pendingCount == 0) {
+        if (pending != stackPending) {
+            free(pending);
         }
+        return 0;
     }
     
-    // Get window info for context
-    NSDictionary *windowInfo = getWindowInfoWithCGS(windowID);
-    NSString *windowName = nil;
-    NSString *windowOwner = nil;
+    // Group by owner connection
+    qsort(pending, pendingCount, sizeof(batch_window_t), compareBatchWindowsByOwner);
     
-    if (windowInfo) {
-        windowName = windowInfo[@"kCGSWindowTitle"];
-        windowOwner = windowInfo[@"kCGSWindowOwnerName"];
-        printf("[Modifier] Window info: ID=%d, Title='%s', Owner='%s'\n", 
-               windowID,
-               windowName ? [windowName UTF8String] : "unknown",
-               windowOwner ? [windowOwner UTF8String] : "unknown");
-    }
+    // Hold screen updates so WindowServer applies the whole batch at once
+    bool updatesDisabled = (CGSDisableUpdate_ptr && CGSReenableUpdate_ptr &&
+                            CGSDisableUpdate_ptr(cid) == kCGErrorSuccess);
     
-    // Add prevents-activation tag - only for windows that don't have owner ID 0
-    int tag = kCGSPreventsActivationTagBit;
+    size_t successCount = 0;
+    size_t groupStart = 0;
     
-    // For normal (non-owner ID 0) windows only
-    {
-        // For normal windows, try all connection methods
+    while (groupStart < pendingCount) {
+        CGSConnectionID ownerCID = pending[groupStart].ownerCID;
+        size_t groupEnd = groupStart;
         
-        // First attempt: Try with owner connection if different
-        if (ownerCID != cid) {
-            OSStatus status = CGSSetWindowTags_ptr(ownerCID, windowID, &tag, 1);
-            if (status == kCGErrorSuccess) {
-                printf("[Modifier] Successfully set tags using owner connection\n");
-                tagSuccess = true;
-            } else {
-                printf("[Modifier] Failed to set tags with owner connection (Error: %d)\n", (int)status);
-            }
-        }
-        
-        // Second attempt: Try with our connection if first failed
-        if (!tagSuccess) {
-            OSStatus status = CGSSetWindowTags_ptr(cid, windowID, &tag, 1);
-            if (status == kCGErrorSuccess) {
-                printf("[Modifier] Successfully set tags using our connection\n");
-                tagSuccess = true;
+        while (groupEnd < pendingCount && pending[groupEnd].ownerCID == ownerCID) {
+            CGSWindowID windowID = pending[groupEnd].windowID;
+            
+            wm_trace_id_t span = wm_trace_make_id();
+            WM_TRACE_BEGIN(span, "ModifyWindow", "window %d owner %d batch", windowID, ownerCID);
+            bool applied = applyCGSModifications(windowID, cid, ownerCID, options, NULL);
+            WM_TRACE_END(span, "ModifyWindow", "success %d", applied);
+            
+            if (applied) {
+                if (window_registry) {
+                    registry_mark_window_modified(window_registry, windowID);
+                }
+                recordWindowModified(windowID);
+                modified_window_count++;
+                successCount++;
             } else {
-                printf("[Modifier] Failed to set tags with our connection (Error: %d)\n", (int)status);
+                // Sweeps only revisit new IDs, so a failed window has to come back by retry
+                wm_stats_increment(WM_STAT_MODIFY_FAILURES);
+                addWindowToRetryQueue(windowID);
             }
+            groupEnd++;
         }
         
-        // Third attempt: Try with default connection as last resort
-        if (!tagSuccess) {
-            CGSConnectionID defaultCID = CGSDefaultConnection_ptr();
-            if (defaultCID != cid && defaultCID != ownerCID) {
-                OSStatus status = CGSSetWindowTags_ptr(defaultCID, windowID, &tag, 1);
-                if (status == kCGErrorSuccess) {
-                    printf("[Modifier] Successfully set tags using default connection\n");
-                    tagSuccess = true;
-                } else {
-                    printf("[Modifier] Failed with all connection attempts for tag setting\n");
-                }
-            }
+        WM_LOG_DEBUG("[Modifier] Batch applied to %zu window(s) of connection %d\n", 
+                     groupEnd - groupStart, ownerCID);
+        groupStart = groupEnd;
+    }
+    
+    if (updatesDisabled) {
+        CGSReenableUpdate_ptr(cid);
+    }
+    
+    if (pending != stackPending) {
+        free(pending);
+    }
+    
+    WM_LOG_INFO("[Modifier] Batch modified %zu of %zu windows\n", successCount, count);
+    return successCount;
+}
+
+// Put one window back to its captured attributes, trying the owner connection first
+static bool restoreOriginalState(const window_original_state_t *original, CGSConnectionID cid) {
+    CGSWindowID windowID = original->window_id;
+    CGSConnectionID ownerCID = cid;
+    if (!getWindowOwnerCached(windowID, &ownerCID) || ownerCID == 0) {
+        ownerCID = cid;
+    }
+    
+    bool restored = true;
+    
+    if (original->flags & WINDOW_ORIGINAL_HAS_LEVEL) {
+        OSStatus status = CGSSetWindowLevel_ptr(ownerCID, windowID, original->level);
+        if (status != kCGErrorSuccess && ownerCID != cid) {
+            status = CGSSetWindowLevel_ptr(cid, windowID, original->level);
         }
+        restored &= (status == kCGErrorSuccess);
     }
     
-    // Even if tag setting fails, consider successful if we at least set the window level
-    success = (levelStatus == kCGErrorSuccess || tagSuccess);
+    if (original->flags & WINDOW_ORIGINAL_HAS_SHARING) {
+        OSStatus status = CGSSetWindowSharingState_ptr(ownerCID, windowID, original->sharing_state);
+        if (status != kCGErrorSuccess && ownerCID != cid) {
+            status = CGSSetWindowSharingState_ptr(cid, windowID, original->sharing_state);
+        }
+        restored &= (status == kCGErrorSuccess);
+    }
     
-    // Log comprehensive window details if tag setting failed
-    if (!tagSuccess) {
-        printf("[Modifier] WARNING: Unable to set non-activating tag for window %d\n", windowID);
-        if (windowInfo) {
-            // Log key window properties for debugging
-            printf("[Modifier] Window Properties for ID %d:\n", windowID);
-            NSNumber *alpha = windowInfo[@"kCGSWindowAlpha"];
-            NSNumber *width = windowInfo[@"kCGSWindowWidth"];
-            NSNumber *height = windowInfo[@"kCGSWindowHeight"];
-            NSString *windowLayer = windowInfo[@"kCGSWindowLayer"];
-            NSNumber *windowLevel = windowInfo[@"kCGSWindowLevel"];
-            
-            printf("  - Alpha: %f\n", alpha ? [alpha doubleValue] : -1);
-            printf("  - Size: %dx%d\n", width ? [width intValue] : -1, height ? [height intValue] : -1);
-            printf("  - Layer: %s\n", windowLayer ? [windowLayer UTF8String] : "unknown");
-            printf("  - Level: %d\n", windowLevel ? [windowLevel intValue] : -1);
+    // Only clear the tag if the window didn't have it before we set it
+    if ((original->flags & WINDOW_ORIGINAL_HAS_TAGS) && 
+        !(original->flags & WINDOW_ORIGINAL_PREVENTS_ACTIVATION) && CGSClearWindowTags_ptr) {
+        int tag = kCGSPreventsActivationTagBit;
+        OSStatus status = CGSClearWindowTags_ptr(ownerCID, windowID, &tag, 1);
+        if (status != kCGErrorSuccess && ownerCID != cid) {
+            status = CGSClearWindowTags_ptr(cid, windowID, &tag, 1);
         }
+        restored &= (status == kCGErrorSuccess);
     }
     
-    if (success) {
-        printf("[Modifier] Successfully modified window: %d\n", windowID);
+    return restored;
+}
+
+// Restore every captured window inside one update transaction
+size_t restoreWindowModifications(void) {
+    // Fixed storage so the restore never allocates, even from a signal-triggered exit
+    static window_original_state_t originals[WINDOW_TABLE_CAPACITY];
+    static pthread_mutex_t restoreMutex = PTHREAD_MUTEX_INITIALIZER;
+    
+    if (!CGSDefaultConnection_ptr || !CGSSetWindowLevel_ptr || !CGSSetWindowSharingState_ptr) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(&restoreMutex);
+    
+    size_t count = window_table_take_originals(originals, WINDOW_TABLE_CAPACITY);
+    if (count == 0) {
+        pthread_mutex_unlock(&restoreMutex);
+        return 0;
+    }
+    
+    uint64_t start = mach_absolute_time();
+    CGSConnectionID cid = CGSDefaultConnection_ptr();
+    
+    // WindowServer applies the whole restore at once, typically within a frame
+    bool updatesDisabled = (CGSDisableUpdate_ptr && CGSReenableUpdate_ptr &&
+                            CGSDisableUpdate_ptr(cid) == kCGErrorSuccess);
+    
+    size_t restoredCount = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (restoreOriginalState(&originals[i], cid)) {
+            restoredCount++;
+        }
         
-        // Mark as modified in registry
+        // Forget the registry mark so a reloaded library modifies the window again
         if (window_registry) {
-            registry_mark_window_modified(window_registry, windowID);
+            registry_forget_window(window_registry, originals[i].window_id);
         }
+    }
+    
+    if (updatesDisabled) {
+        CGSReenableUpdate_ptr(cid);
+    }
+    
+    pthread_mutex_unlock(&restoreMutex);
+    
+    WM_LOG_INFO("[Modifier] Restored %zu of %zu windows in %.3f ms\n", 
+                restoredCount, count, elapsedMilliseconds(start));
+    return restoredCount;
+}
+
+// Restore on SIGTERM / SIGINT / SIGHUP, then terminate with the same signal.
+// Signals the host application handles itself are left alone.
+static void installRestoreSignalHandlers(void) {
+    for (size_t i = 0; i < sizeof(restore_signals) / sizeof(restore_signals[0]); i++) {
+        int sig = restore_signals[i];
         
-        modified_window_count++;
+        struct sigaction current;
+        if (sigaction(sig, NULL, &current) != 0 || current.sa_handler != SIG_DFL) {
+            continue;
+        }
+        
+        // The dispatch source only sees the signal once the default action is off
+        signal(sig, SIG_IGN);
+        restore_sources[i] = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, (uintptr_t)sig, 0, modifier_queue);
+        dispatch_source_set_event_handler(restore_sources[i], ^{
+            WM_LOG_INFO("[Modifier] Signal %d received, restoring windows\n", sig);
+            restoreWindowModifications();
+            wm_log_flush();
+            
+            signal(sig, SIG_DFL);
+            raise(sig);
+        });
+        dispatch_resume(restore_sources[i]);
+    }
+}
+
+// Classify an AppKit window with the shared rules, from its own properties so
+// no WindowServer call is needed. AppKit style bits differ from the CGS ones the
+// rules test, so the ones with the same meaning are translated; panels count as
+// utility style whatever their mask.
+static window_class_t classifyNSWindow(NSWindow *window) {
+    const window_rule_set_t *rules = window_rules_active();
+    NSRect frame = window.frame;
+    NSWindowStyleMask style = window.styleMask;
+    
+    window_properties_t props = {0};
+    props.alpha = window.alphaValue;
+    props.width = (int)frame.size.width;
+    props.height = (int)frame.size.height;
+    props.level = (int)window.level;
+    props.present = WINDOW_PROP_HAS_ALPHA | WINDOW_PROP_HAS_SIZE | WINDOW_PROP_HAS_LEVEL | 
+                    WINDOW_PROP_HAS_STYLE_MASK;
+    
+    if (style & NSWindowStyleMaskTitled) {
+        props.style_mask |= rules->titled_style_mask;
+    }
+    if ((style & NSWindowStyleMaskUtilityWindow) || [window isKindOfClass:[NSPanel class]]) {
+        props.style_mask |= rules->utility_style_mask;
+    }
+    if ((style & NSWindowStyleMaskDocModalWindow) || window.isSheet) {
+        props.style_mask |= rules->sheet_style_mask;
+    }
+    if (window.parentWindow) {
+        props.present |= WINDOW_PROP_HAS_PARENT;
     }
     
-    return success;
+    return window_rules_classify(&props).window_class;
 }
 
 // Modify an NSWindow instance (for AppKit windows)
@@ -320,6 +812,14 @@ bool modifyNSWindow(NSWindow *window) {
     }
     
     @try {
+        // Capture the original attributes before AppKit changes them
+        if (reversibleModeEnabled() && [window windowNumber] > 0) {
+            captureNSWindowOriginalState(window);
+        }
+        
+        // Classify before the level changes, so the table and its counts stay truthful
+        window_class_t windowClass = classifyNSWindow(window);
+        
         // 1. Set window level to floating
         window.level = NSFloatingWindowLevel;
         
@@ -354,7 +854,7 @@ bool modifyNSWindow(NSWindow *window) {
                 dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1 * NSEC_PER_SEC)), 
                                dispatch_get_main_queue(), ^{
                     [NSApp setActivationPolicy:originalPolicy];
-                    printf("[Modifier] Restored original activation policy\n");
+                    WM_LOG_INFO("[Modifier] Restored original activation policy\n");
                 });
             }
         });
@@ -362,119 +862,280 @@ bool modifyNSWindow(NSWindow *window) {
         // Get the window ID
         CGSWindowID windowID = (CGSWindowID)[window windowNumber];
         
-        // Mark as modified in registry if we have a valid window ID
-        if (windowID > 0 && window_registry) {
-            registry_mark_window_modified(window_registry, windowID);
+        // Record the window so CGS events for it short-circuit, and mark it in registry
+        if (windowID > 0) {
+            registerNSWindow(window);
+            if (!window_table_is_handled(windowID)) {
+                window_table_mark_handled(windowID, windowClass);
+                recordWindowModified(windowID);
+            }
+            
+            // The registry may have to wait for a shard lock; keep that off the main thread
+            if (window_registry && modifier_queue) {
+                dispatch_async(modifier_queue, ^{
+                    registry_mark_window_modified(window_registry, windowID);
+                });
+            } else if (window_registry) {
+                registry_mark_window_modified(window_registry, windowID);
+            }
         }
         
-        printf("[Modifier] Modified NSWindow: %lu\n", (unsigned long)[window windowNumber]);
+        WM_LOG_DEBUG("[Modifier] Modified NSWindow: %lu\n", (unsigned long)[window windowNumber]);
         return true;
     }
     @catch (NSException *exception) {
-        printf("[Modifier] Exception modifying NSWindow: %s\n", 
-              [[exception description] UTF8String]);
+        WM_LOG_ERROR("[Modifier] Exception modifying NSWindow: %s\n", 
+                    [[exception description] UTF8String]);
         return false;
     }
 }
 
+// Check whether the caller is running on modifier_queue
+static bool onModifierQueue(void) {
+    return dispatch_get_specific(&modifier_queue_key) != NULL;
+}
+
 // Add a window to the retry queue
 static void addWindowToRetryQueue(CGSWindowID windowID) {
-    // Check if already in queue
-    for (int i = 0; i < retry_window_count; i++) {
-        if (retry_windows[i].windowID == windowID) {
-            return;
-        }
+    if (!modifier_queue) {
+        return;
     }
     
-    // Add to queue if space available
-    if (retry_window_count < (int)(sizeof(retry_windows) / sizeof(retry_windows[0]))) {
-        retry_windows[retry_window_count].windowID = windowID;
-        retry_windows[retry_window_count].attempts = 0;
-        retry_windows[retry_window_count].next_attempt_time = 
-            CFAbsoluteTimeGetCurrent() + retry_delays[0];
-        
-        retry_window_count++;
-        printf("[Modifier] Added window %d to retry queue (count: %d)\n", 
-               windowID, retry_window_count);
+    // Retry state is only touched on the modifier queue; event handling is
+    // already there, so only other callers pay for a block copy
+    if (onModifierQueue()) {
+        queueWindowRetry(windowID);
+        return;
+    }
+    
+    dispatch_async(modifier_queue, ^{
+        queueWindowRetry(windowID);
+    });
+}
+
+// Queue a window's first retry attempt (runs on modifier_queue)
+static void queueWindowRetry(CGSWindowID windowID) {
+    retry_window_t entry = {
+        .windowID = windowID,
+        .attempts = 0,
+        .next_attempt_time = CFAbsoluteTimeGetCurrent() + retry_delays[0]
+    };
+    
+    // Already queued windows keep their current schedule
+    if (retry_queue_contains(retry_queue, windowID)) {
+        return;
+    }
+    
+    if (!retry_queue_push(retry_queue, &entry)) {
+        WM_LOG_WARN("[Modifier] Retry queue full, dropped window %d (dropped: %llu)\n", 
+                    windowID, (unsigned long long)retry_queue_dropped(retry_queue));
+        return;
+    }
+    wm_stats_increment(WM_STAT_RETRIES_QUEUED);
+    
+    WM_LOG_DEBUG("[Modifier] Added window %d to retry queue (count: %zu)\n", 
+                 windowID, retry_queue_depth(retry_queue));
+    
+    scheduleRetryTimer();
+}
+
+// Arm the retry timer for the earliest pending attempt (runs on modifier_queue)
+static void scheduleRetryTimer(void) {
+    if (!retry_timer) {
+        return;
     }
+    
+    retry_window_t earliest;
+    if (!retry_queue_peek(retry_queue, &earliest)) {
+        // Nothing pending, no wakeups until a window is queued
+        dispatch_source_set_timer(retry_timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+        return;
+    }
+    
+    double delay = earliest.next_attempt_time - CFAbsoluteTimeGetCurrent();
+    if (delay < 0) {
+        delay = 0;
+    }
+    
+    dispatch_source_set_timer(retry_timer, 
+                              dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), 
+                              DISPATCH_TIME_FOREVER, 
+                              RETRY_TIMER_LEEWAY_NSEC);
 }
 
-// Process the window retry queue
+// Request a sweep of on-screen windows, coalescing bursts into one pass
+static void requestWindowSweep(void) {
+    if (!sweep_queue) {
+        return;
+    }
+    
+    // Only the first request of a burst schedules anything
+    if (atomic_load_explicit(&sweep_pending, memory_order_relaxed) ||
+        atomic_exchange(&sweep_pending, true)) {
+        return;
+    }
+    
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(SWEEP_COALESCE_SECONDS * NSEC_PER_SEC)), 
+                   sweep_queue, ^{
+        atomic_store(&sweep_pending, false);
+        
+        if (isApplicationInitialized() && !isInStartupProtection()) {
+            applyAllWindowModifications();
+        } else if (!deferSweepToInitGate()) {
+            // Gate open but still in startup protection, try again shortly
+            requestWindowSweep();
+        }
+    });
+}
+
+// Process the window retry queue (runs on modifier_queue)
 static void processRetryQueue(void) {
-    if (retry_window_count == 0) {
+    if (retry_queue_depth(retry_queue) == 0) {
         return;
     }
     
     CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
-    
-    // Track indices to remove
-    int indices_to_remove[32] = {0};
     int remove_count = 0;
+    WM_TRACE_BEGIN(OS_SIGNPOST_ID_EXCLUSIVE, "RetryPass", "depth %zu", retry_queue_depth(retry_queue));
     
-    // Process each window in the retry queue
-    for (int i = 0; i < retry_window_count; i++) {
-        if (now >= retry_windows[i].next_attempt_time) {
-            CGSWindowID windowID = retry_windows[i].windowID;
-            
-            printf("[Modifier] Retry attempt %d for window %d\n", 
-                   retry_windows[i].attempts + 1, windowID);
-            
-            // Try to modify the window
-            bool success = modifyWindowWithCGSInternal(windowID, true);
-            
-            if (success) {
-                // If successful, mark for removal
-                indices_to_remove[remove_count++] = i;
-                printf("[Modifier] Retry successful for window %d\n", windowID);
-            } else {
-                // Increment attempt count
-                retry_windows[i].attempts++;
-                
-                // If max retries reached, mark for removal
-                if (retry_windows[i].attempts >= max_retry_attempts) {
-                    indices_to_remove[remove_count++] = i;
-                    printf("[Modifier] Max retries reached for window %d\n", windowID);
-                } else {
-                    // Schedule next retry
-                    int delay_index = retry_windows[i].attempts;
-                    if (delay_index >= (int)(sizeof(retry_delays) / sizeof(retry_delays[0]))) {
-                        delay_index = sizeof(retry_delays) / sizeof(retry_delays[0]) - 1;
-                    }
-                    
-                    retry_windows[i].next_attempt_time = now + retry_delays[delay_index];
-                }
-            }
+    // Pop every entry that is due; rescheduled entries land in the future so the loop ends
+    retry_window_t entry;
+    while (retry_queue_peek(retry_queue, &entry) && entry.next_attempt_time <= now) {
+        retry_queue_pop(retry_queue, NULL);
+        CGSWindowID windowID = entry.windowID;
+        
+        WM_LOG_DEBUG("[Modifier] Retry attempt %d for window %d\n", entry.attempts + 1, windowID);
+        wm_stats_increment(WM_STAT_RETRY_ATTEMPTS);
+        
+        // Try to modify the window
+        if (modifyWindowWithCGSInternal(windowID, true)) {
+            remove_count++;
+            WM_LOG_DEBUG("[Modifier] Retry successful for window %d\n", windowID);
+            continue;
+        }
+        
+        // Increment attempt count
+        entry.attempts++;
+        
+        // If max retries reached, drop the window
+        if (entry.attempts >= max_retry_attempts) {
+            remove_count++;
+            WM_LOG_DEBUG("[Modifier] Max retries reached for window %d\n", windowID);
+            wm_stats_increment(WM_STAT_RETRIES_EXHAUSTED);
+            continue;
         }
+        
+        // Schedule next retry
+        int delay_index = entry.attempts;
+        if (delay_index >= (int)(sizeof(retry_delays) / sizeof(retry_delays[0]))) {
+            delay_index = sizeof(retry_delays) / sizeof(retry_delays[0]) - 1;
+        }
+        entry.next_attempt_time = now + retry_delays[delay_index];
+        
+        if (!retry_queue_push(retry_queue, &entry)) {
+            WM_LOG_WARN("[Modifier] Retry queue full, dropped window %d\n", windowID);
+        }
+    }
+    
+    if (remove_count > 0) {
+        WM_LOG_DEBUG("[Modifier] Removed %d windows from retry queue (remaining: %zu)\n", 
+                     remove_count, retry_queue_depth(retry_queue));
+    }
+    
+    WM_TRACE_END(OS_SIGNPOST_ID_EXCLUSIVE, "RetryPass", "removed %d", remove_count);
+}
+
+// Number of windows waiting for a retry
+size_t getRetryQueueDepth(void) {
+    return retry_queue_depth(retry_queue);
+}
+
+// Number of windows dropped because the retry queue was full
+uint64_t getRetryQueueDroppedCount(void) {
+    return retry_queue_dropped(retry_queue);
+}
+
+// Number of notifications dropped because the event queue was full
+uint64_t getEventQueueDroppedCount(void) {
+    return event_queue_dropped(event_queue);
+}
+
+// Order window IDs ascending for the sweep snapshot
+static int compareWindowIDs(const void *a, const void *b) {
+    CGSWindowID wa = *(const CGSWindowID *)a;
+    CGSWindowID wb = *(const CGSWindowID *)b;
+    return (wa > wb) - (wa < wb);
+}
+
+// Grow the sweep buffers to hold at least capacity windows (runs on modifier_queue)
+static bool ensureSweepCapacity(size_t capacity) {
+    if (capacity <= sweep_capacity) {
+        return true;
+    }
+    
+    CGSWindowID *current = realloc(sweep_current, capacity * sizeof(CGSWindowID));
+    if (current) {
+        sweep_current = current;
+    }
+    CGSWindowID *previous = realloc(sweep_previous, capacity * sizeof(CGSWindowID));
+    if (previous) {
+        sweep_previous = previous;
+    }
+    CGSWindowID *candidates = realloc(sweep_candidates, capacity * sizeof(CGSWindowID));
+    if (candidates) {
+        sweep_candidates = candidates;
+    }
+    
+    if (!current || !previous || !candidates) {
+        WM_LOG_ERROR("[Modifier] Error: Failed to grow sweep buffers to %zu windows\n", capacity);
+        return false;
+    }
+    
+    sweep_capacity = capacity;
+    return true;
+}
+
+// Fetch every on-screen window into sweep_current, growing the buffer when the list fills it
+static bool fetchOnScreenWindows(CGSConnectionID cid, size_t *countOut) {
+    if (!ensureSweepCapacity(SWEEP_INITIAL_CAPACITY)) {
+        return false;
     }
     
-    // Remove processed entries from highest index to lowest
-    for (int i = remove_count - 1; i >= 0; i--) {
-        int index = indices_to_remove[i];
+    for (;;) {
+        int windowCount = 0;
+        OSStatus status = CGSGetOnScreenWindowList_ptr(cid, cid, (int)sweep_capacity, sweep_current, &windowCount);
+        if (status != kCGErrorSuccess || windowCount < 0) {
+            WM_LOG_WARN("[Modifier] Failed to get on-screen window list (Error: %d)\n", (int)status);
+            return false;
+        }
         
-        // Shift all elements after this one down
-        for (int j = index; j < retry_window_count - 1; j++) {
-            retry_windows[j] = retry_windows[j + 1];
+        // A full buffer may have cut the list short, fetch again with more room
+        if ((size_t)windowCount >= sweep_capacity && sweep_capacity < SWEEP_MAX_CAPACITY) {
+            if (!ensureSweepCapacity(sweep_capacity * 2)) {
+                return false;
+            }
+            continue;
         }
         
-        retry_window_count--;
-    }
-    
-    if (remove_count > 0) {
-        printf("[Modifier] Removed %d windows from retry queue (remaining: %d)\n", 
-               remove_count, retry_window_count);
+        *countOut = (size_t)windowCount;
+        return true;
     }
 }
 
-// Apply modifications to all windows
+// Apply modifications to windows that appeared since the previous sweep (runs on sweep_queue).
+// The on-screen list is kept sorted between sweeps, so an unchanged screen costs one fetch
+// and one memcmp, and only IDs missing from the previous list are evaluated.
 bool applyAllWindowModifications(void) {
     if (!CGSDefaultConnection_ptr || !CGSGetOnScreenWindowList_ptr) {
-        printf("[Modifier] Error: Required CGS functions not loaded\n");
+        WM_LOG_ERROR("[Modifier] Error: Required CGS functions not loaded\n");
         return false;
     }
     
-    // Create local array for safe windows only
-    CGSWindowID safeWindows[128];
-    int safeWindowCount = 0;
+    uint64_t sweepStart = wm_stats_now();
+    wm_stats_increment(WM_STAT_SWEEPS);
+    WM_TRACE_BEGIN(OS_SIGNPOST_ID_EXCLUSIVE, "WindowSweep");
+    
+    size_t candidateCount = 0;
     int success_count = 0;
     
     @try {
@@ -482,19 +1143,44 @@ bool applyAllWindowModifications(void) {
         // This avoids passing the full window array to functions that might
         // crash when accessing certain windows
         CGSConnectionID cid = CGSDefaultConnection_ptr();
-        CGSWindowID allWindows[128];
-        int windowCount = 0;
+        size_t windowCount = 0;
         
         @try {
-            CGSGetOnScreenWindowList_ptr(cid, cid, 128, allWindows, &windowCount);
-            printf("[Modifier] Found %d on-screen windows\n", windowCount);
+            if (!fetchOnScreenWindows(cid, &windowCount)) {
+                wm_stats_record_since(WM_HIST_SWEEP, sweepStart);
+                WM_TRACE_END(OS_SIGNPOST_ID_EXCLUSIVE, "WindowSweep", "failed");
+                return false;
+            }
+            
+            qsort(sweep_current, windowCount, sizeof(CGSWindowID), compareWindowIDs);
+            
+            // Nothing appeared or disappeared since the last sweep
+            if (windowCount == sweep_previous_count && 
+                memcmp(sweep_current, sweep_previous, windowCount * sizeof(CGSWindowID)) == 0) {
+                WM_LOG_DEBUG("[Modifier] On-screen windows unchanged (%zu)\n", windowCount);
+                wm_stats_record_since(WM_HIST_SWEEP, sweepStart);
+                WM_TRACE_END(OS_SIGNPOST_ID_EXCLUSIVE, "WindowSweep", "unchanged");
+                return false;
+            }
             
-            // Pre-scan phase: Check each window for safety before doing anything else
-            for (int i = 0; i < windowCount; i++) {
-                CGSWindowID windowID = allWindows[i];
+            WM_LOG_INFO("[Modifier] Found %zu on-screen windows\n", windowCount);
+            
+            // Pre-scan phase: check each newly appeared window for safety before doing anything else
+            size_t previousIndex = 0;
+            for (size_t i = 0; i < windowCount; i++) {
+                CGSWindowID windowID = sweep_current[i];
+                
+                // Merge walk over both sorted lists; windows seen last sweep were already evaluated
+                while (previousIndex < sweep_previous_count && sweep_previous[previousIndex] < windowID) {
+                    previousIndex++;
+                }
+                if (previousIndex < sweep_previous_count && sweep_previous[previousIndex] == windowID) {
+                    continue;
+                }
                 
-                // Skip windows already marked in registry
-                if (window_registry && registry_is_window_modified(window_registry, windowID)) {
+                // Skip windows already modified in-process or marked in registry
+                if (window_table_is_handled(windowID) ||
+                    (window_registry && registry_is_window_modified(window_registry, windowID))) {
                     continue;
                 }
                 
@@ -505,185 +1191,279 @@ bool applyAllWindowModifications(void) {
                     // Mark as modified in registry to prevent future attempts
                     if (window_registry) {
                         registry_mark_window_modified(window_registry, windowID);
-                        printf("[Modifier] Pre-filtered unsafe window %d\n", windowID);
+                        WM_LOG_DEBUG("[Modifier] Pre-filtered unsafe window %d\n", windowID);
                     }
                 } else {
-                    // This window seems safe, add to our safe list
-                    if (safeWindowCount < 128) {
-                        safeWindows[safeWindowCount++] = windowID;
-                    }
+                    // This window seems safe, add to our candidate list
+                    sweep_candidates[candidateCount++] = windowID;
                 }
             }
+            
+            // The new list becomes the baseline for the next sweep
+            CGSWindowID *swap = sweep_previous;
+            sweep_previous = sweep_current;
+            sweep_current = swap;
+            sweep_previous_count = windowCount;
         }
         @catch (NSException *exception) {
-            printf("[Modifier] Exception during window list retrieval: %s\n", 
-                  [[exception description] UTF8String]);
+            WM_LOG_ERROR("[Modifier] Exception during window list retrieval: %s\n", 
+                        [[exception description] UTF8String]);
+            wm_stats_record_since(WM_HIST_SWEEP, sweepStart);
+            WM_TRACE_END(OS_SIGNPOST_ID_EXCLUSIVE, "WindowSweep", "failed");
             return false;
         }
         
-        // Second phase: Only operate on windows we've verified are safe
-        for (int i = 0; i < safeWindowCount; i++) {
-            if (modifyWindowWithCGS(safeWindows[i])) {
-                success_count++;
-            }
-        }
+        // Second phase: Only operate on windows we've verified are safe, as one batch
+        success_count = (int)modifyWindowsBatchWithCGS(sweep_candidates, candidateCount, 
+                                                       defaultWindowModificationOptions());
     }
     @catch (NSException *exception) {
-        printf("[Modifier] Top-level exception during window modifications: %s\n", 
-              [[exception description] UTF8String]);
+        WM_LOG_ERROR("[Modifier] Top-level exception during window modifications: %s\n", 
+                    [[exception description] UTF8String]);
     }
     
-    printf("[Modifier] Successfully modified %d windows\n", success_count);
+    wm_stats_record_since(WM_HIST_SWEEP, sweepStart);
+    WM_TRACE_END(OS_SIGNPOST_ID_EXCLUSIVE, "WindowSweep", "modified %d of %zu new", success_count, candidateCount);
+    WM_LOG_INFO("[Modifier] Successfully modified %d of %zu new windows\n", success_count, candidateCount);
     return (success_count > 0);
 }
 
-// Check if the application is fully initialized
+// Check if the application is fully initialized (the startup gate is open)
 bool isApplicationInitialized(void) {
-    // Get current time for timeout calculations
-    time_t now = time(NULL);
+    return evaluateInitGate();
+}
+
+// Move the state machine forward (never back), returning true if it moved
+static bool advanceInitState(app_init_state_t state) {
+    app_init_state_t current = atomic_load(&current_init_state);
+    while (current < state) {
+        if (atomic_compare_exchange_weak(&current_init_state, &current, state)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Open the gate once the state machine, the window counts or the elapsed time
+// say the app is up. Every check is O(1), so this is cheap on every event.
+static bool evaluateInitGate(void) {
+    if (atomic_load_explicit(&init_gate_open, memory_order_acquire)) {
+        return true;
+    }
     
     // Layer 1: State machine - most accurate when working correctly
-    if (current_init_state >= APP_INIT_FIRST_WINDOW_COMPLETE) {
+    if (atomic_load(&current_init_state) >= APP_INIT_FIRST_WINDOW_COMPLETE) {
+        openInitGate();
         return true;
     }
     
-    // Layer 2: Window count heuristic - apps with multiple standard windows are likely initialized
+    // Layer 2: Window count heuristic, from the table's running counts
     int standard_window_count = 0;
     int initialized_window_count = 0;
+    window_table_count_standard(&standard_window_count, &initialized_window_count);
     
-    if (window_states) {
-        // Count standard and initialized windows
-        CFDictionaryApplyFunction(window_states, countInitializedStandardWindows, &initialized_window_count);
-        
-        // Count all standard windows (initialized or not)
-        CFDictionaryApplyFunction(window_states, countStandardWindows, &standard_window_count);
-        
-        // Update global counter for other functions to use
-        main_window_count = initialized_window_count;
-        
-        // Heuristic based on window counts
-        if (initialized_window_count >= 1) {
-            // We have at least one fully initialized standard window
-            printf("[Modifier] App considered initialized: %d initialized standard window(s)\n", 
-                  initialized_window_count);
-                  
-            // Update state machine to match reality
-            if (current_init_state < APP_INIT_FIRST_WINDOW_COMPLETE) {
-                current_init_state = APP_INIT_FIRST_WINDOW_COMPLETE;
-            }
-            
-            return true;
-        }
-        
-        if (standard_window_count >= 3) {
-            // Multiple standard windows usually indicate the app is up and running
-            printf("[Modifier] App considered initialized: multiple standard windows detected (%d)\n", 
-                  standard_window_count);
-                  
-            // Update state machine to match reality
-            if (current_init_state < APP_INIT_FIRST_WINDOW_COMPLETE) {
-                current_init_state = APP_INIT_FIRST_WINDOW_COMPLETE;
-            }
-            
-            return true;
-        }
+    if (initialized_window_count >= 1) {
+        WM_LOG_DEBUG("[Modifier] App considered initialized: %d initialized standard window(s)\n", 
+                    initialized_window_count);
+        openInitGate();
+        return true;
+    }
+    
+    if (standard_window_count >= 3) {
+        // Multiple standard windows usually indicate the app is up and running
+        WM_LOG_DEBUG("[Modifier] App considered initialized: multiple standard windows detected (%d)\n", 
+                    standard_window_count);
+        openInitGate();
+        return true;
     }
     
-    // Layer 3: Time-based fallback - if enough time has passed, assume the app is initialized
+    // Layer 3: Time-based fallback (armInitGateTimer makes sure this is checked in time)
+    time_t elapsed = time(NULL) - process_start_time;
     int time_threshold = (current_process_role == PROCESS_ROLE_UI) ? 3 : 2;
     
-    if ((now - process_start_time) > time_threshold) {
-        printf("[Modifier] App considered initialized by time threshold (%d seconds elapsed)\n", 
-              (int)(now - process_start_time));
-              
-        // Update state machine to match reality
-        if (current_init_state < APP_INIT_FIRST_WINDOW_COMPLETE) {
-            current_init_state = APP_INIT_FIRST_WINDOW_COMPLETE;
-        }
-        
+    if (process_start_time != 0 && elapsed > time_threshold) {
+        WM_LOG_DEBUG("[Modifier] App considered initialized by time threshold (%d seconds elapsed)\n", 
+                    (int)elapsed);
+        openInitGate();
         return true;
     }
     
     return false;
 }
 
-// Update the state of a window based on events
-static void updateWindowState(int eventType, CGSWindowID windowID) {
-    if (!window_states) {
-        // Create window states dictionary if it doesn't exist yet
-        window_states = CFDictionaryCreateMutable(
-            kCFAllocatorDefault, 
-            128, 
-            &kCFTypeDictionaryKeyCallBacks, 
-            NULL); // Custom value callbacks not needed
-    }
-    
-    NSNumber *key = @(windowID);
-    window_init_state_t *state = NULL;
-    
-    // Get existing state or create new one
-    if (CFDictionaryContainsKey(window_states, (__bridge CFNumberRef)key)) {
-        state = (window_init_state_t *)CFDictionaryGetValue(window_states, (__bridge CFNumberRef)key);
+// Open the gate (once) and hand everything that waited to the modifier queue
+static void openInitGate(void) {
+    if (atomic_load(&init_gate_open) || atomic_exchange(&init_gate_open, true)) {
+        return;
+    }
+    
+    advanceInitState(APP_INIT_FIRST_WINDOW_COMPLETE);
+    
+    // The timer only exists on modifier_queue, so there is nothing to cancel without it
+    if (modifier_queue) {
+        dispatch_async(modifier_queue, ^{
+            cancelInitGateTimer();
+            releaseGateWaiters();
+        });
     } else {
-        // Create new state
-        state = malloc(sizeof(window_init_state_t));
-        if (!state) {
-            return; // Out of memory
+        releaseGateWaiters();
+    }
+}
+
+// Fire the time fallback exactly when it's due, instead of polling for it
+static void armInitGateTimer(void) {
+    if (!modifier_queue) {
+        return;
+    }
+    
+    // Armed on modifier_queue, where openInitGate cancels it: a gate that opens
+    // first is seen here, one that opens later queues its cancel behind this
+    dispatch_async(modifier_queue, ^{
+        if (init_gate_timer || evaluateInitGate()) {
+            return;
         }
         
-        // Initialize state
-        state->window_id = windowID;
-        state->window_state = 0;
-        state->is_initialized = false;
-        state->first_seen = time(NULL);
+        // Whole seconds past the threshold, matching the elapsed-time check
+        int time_threshold = (current_process_role == PROCESS_ROLE_UI) ? 3 : 2;
+        int64_t delay = (int64_t)(time_threshold + 1) * NSEC_PER_SEC;
         
-        // Get window info to determine class
-        NSDictionary *windowInfo = getWindowInfoWithCGS(windowID);
-        state->window_class = determineWindowClass(windowID, windowInfo);
+        init_gate_timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, modifier_queue);
+        dispatch_source_set_event_handler(init_gate_timer, ^{
+            evaluateInitGate();
+        });
+        dispatch_source_set_timer(init_gate_timer, dispatch_time(DISPATCH_TIME_NOW, delay), 
+                                  DISPATCH_TIME_FOREVER, 10 * NSEC_PER_MSEC);
+        dispatch_resume(init_gate_timer);
+    });
+}
+
+// Stop the time fallback (runs on modifier_queue)
+static void cancelInitGateTimer(void) {
+    if (init_gate_timer) {
+        dispatch_source_cancel(init_gate_timer);
+        init_gate_timer = NULL;
+    }
+}
+
+// Hold a window until the gate opens (modifies it right away if it just did)
+static void waitForInitGate(CGSWindowID windowID) {
+    pthread_mutex_lock(&gateMutex);
+    bool open = atomic_load(&init_gate_open);
+    if (!open) {
+        if (gate_waiter_count < GATE_WAITER_CAPACITY) {
+            gate_waiters[gate_waiter_count++] = windowID;
+        } else {
+            gate_sweep_wanted = true; // Overflow is picked up by a sweep instead
+        }
+    }
+    pthread_mutex_unlock(&gateMutex);
+    
+    if (open && !isInStartupProtection()) {
+        modifyWindowWithCGS(windowID);
+    }
+}
+
+// Run a sweep once the gate opens; returns false if it is already open
+static bool deferSweepToInitGate(void) {
+    pthread_mutex_lock(&gateMutex);
+    bool closed = !atomic_load(&init_gate_open);
+    if (closed) {
+        gate_sweep_wanted = true;
+    }
+    pthread_mutex_unlock(&gateMutex);
+    
+    return closed;
+}
+
+// Modify everything that waited for the gate in one batch (runs on modifier_queue)
+static void releaseGateWaiters(void) {
+    CGSWindowID waiting[GATE_WAITER_CAPACITY];
+    
+    pthread_mutex_lock(&gateMutex);
+    size_t count = gate_waiter_count;
+    memcpy(waiting, gate_waiters, count * sizeof(CGSWindowID));
+    bool sweep = gate_sweep_wanted;
+    gate_waiter_count = 0;
+    gate_sweep_wanted = false;
+    pthread_mutex_unlock(&gateMutex);
+    
+    WM_LOG_INFO("[Modifier] Startup gate open: %zu waiting window(s)%s\n", 
+                count, sweep ? ", sweep requested" : "");
+    
+    if (count > 0) {
+        modifyWindowsBatchWithCGS(waiting, count, defaultWindowModificationOptions());
+    }
+    if (sweep) {
+        requestWindowSweep();
+    }
+}
+
+// Update the state of a window based on events
+static void updateWindowState(int eventType, CGSWindowID windowID, uint64_t eventTicks) {
+    // Start tracking on first sight; classification needs window properties,
+    // so it is computed outside the table lock. Windows first recorded by a
+    // reversible-mode capture are still unclassified and get classified here.
+    if (window_table_get_class(windowID) == WINDOW_CLASS_UNKNOWN) {
+        window_verdict_t verdict = {WINDOW_CLASS_UNKNOWN, false};
+        classifyWindowWithCGS(windowID, &verdict);
+        window_class_t windowClass = verdict.window_class;
         
-        // Add to dictionary
-        CFDictionarySetValue(window_states, (__bridge CFNumberRef)key, state);
+        bool created = false;
+        if (!window_table_track(windowID, windowClass, &created)) {
+            return; // Table full
+        }
         
-        printf("[Modifier] Created tracking for window %d (class: %d)\n", 
-               windowID, state->window_class);
+        if (created) {
+            WM_LOG_DEBUG("[Modifier] Created tracking for window %d (class: %d)\n", 
+                         windowID, windowClass);
+        } else if (windowClass != WINDOW_CLASS_UNKNOWN) {
+            window_table_set_class(windowID, windowClass);
+        }
+    }
+    
+    // Events that can lead to a modification start the event->modified clock
+    if ((eventType == kCGSWindowDidCreateNotification || eventType == kCGSWindowDidOrderInNotification) &&
+        !window_table_is_handled(windowID)) {
+        window_table_note_event(windowID, eventTicks);
     }
     
     // Update state based on event type
+    int stateBits = 0;
     switch (eventType) {
         case kCGSWindowDidCreateNotification:
-            state->window_state |= WINDOW_STATE_CREATED;
+            stateBits = WINDOW_STATE_CREATED;
             break;
             
         case kCGSWindowDidOrderInNotification:
-            state->window_state |= WINDOW_STATE_VISIBLE;
+            stateBits = WINDOW_STATE_VISIBLE;
             break;
             
         case kCGSWindowDidResizeNotification:
-            state->window_state |= WINDOW_STATE_SIZED;
+            stateBits = WINDOW_STATE_SIZED;
             break;
             
         case kCGSWindowDidUpdateNotification:
-            state->window_state |= WINDOW_STATE_CONTENT_READY;
+            stateBits = WINDOW_STATE_CONTENT_READY;
             break;
     }
     
-    // Check if window is fully initialized
-    bool was_initialized = state->is_initialized;
-    state->is_initialized = ((state->window_state & WINDOW_STATE_FULLY_INITIALIZED) == 
-                            WINDOW_STATE_FULLY_INITIALIZED);
+    // Record the event; the table reports when the window became fully initialized
+    bool becameInitialized = false;
+    int windowState = window_table_add_state(windowID, stateBits, &becameInitialized);
     
     // If initialization status changed, log it
-    if (!was_initialized && state->is_initialized) {
-        printf("[Modifier] Window %d now fully initialized (state: 0x%x, class: %d)\n", 
-               windowID, state->window_state, state->window_class);
-               
-                // If this is a standard window, try to modify it
-                if (state->window_class == WINDOW_CLASS_STANDARD && 
-                    isApplicationInitialized() && 
-                    !isInStartupProtection()) {
+    if (windowState >= 0 && becameInitialized) {
+        window_class_t windowClass = window_table_get_class(windowID);
+        WM_LOG_DEBUG("[Modifier] Window %d now fully initialized (state: 0x%x, class: %d)\n", 
+                     windowID, windowState, windowClass);
+        
+        // If this is a standard window, try to modify it
+        if (windowClass == WINDOW_CLASS_STANDARD && 
+            isApplicationInitialized() && 
+            !isInStartupProtection()) {
             
-                    modifyWindowWithCGS(windowID);
-                }
+            modifyWindowWithCGS(windowID);
+        }
     }
     
     // Update application initialization state
@@ -691,24 +1471,166 @@ static void updateWindowState(int eventType, CGSWindowID windowID) {
 }
 
 // CGS window notification callback
+// Runs on the WindowServer callback thread, so it only records the event
 static void windowNotificationCallback(int type, void *data, uint32_t data_length, void * __attribute__((unused)) arg) {
     if (!data || data_length < sizeof(uint32_t)) {
         return;
     }
     
     CGSWindowID windowID = *(uint32_t *)data;
+    if (windowID == 0) {
+        return;
+    }
+    
+    wm_hot_path_enter();
+    wm_stats_increment(WM_STAT_EVENTS_RECEIVED);
     
-    // Update window state tracking
-    if (windowID > 0) {
-        updateWindowState(type, windowID);
+    // Scheduler not running, handle the event inline
+    if (!event_queue || !event_source) {
+        coalesced_window_t pending = {windowID, 1u << type, 0, wm_stats_now()};
+        if (type == kCGSWindowDidOrderInNotification || type == kCGSWindowDidOrderOutNotification) {
+            pending.lastVisibility = type;
+        }
+        applyWindowEvents(&pending);
+        wm_hot_path_exit();
+        return;
     }
     
-    // Perform window modification if conditions are met
-    if ((type == kCGSWindowDidCreateNotification || type == kCGSWindowDidOrderInNotification) && 
-        isApplicationInitialized() && 
-        !isInStartupProtection()) {
+    window_event_t event = {type, windowID, mach_absolute_time()};
+    if (event_queue_push(event_queue, &event)) {
+        dispatch_source_merge_data(event_source, 1);
+    } else {
+        wm_stats_increment(WM_STAT_EVENTS_DROPPED);
+    }
+    wm_hot_path_exit();
+}
+
+// Drain queued notifications, collapsing each burst into one evaluation per window
+static void drainWindowEvents(void) {
+    coalesced_window_t pending[EVENT_DRAIN_BATCH];
+    int16_t lookup[EVENT_COALESCE_SLOTS];
+    window_event_t event;
+    bool more = true;
+    
+    while (more) {
+        int count = 0;
+        memset(lookup, -1, sizeof(lookup));
         
-        modifyWindowWithCGS(windowID);
+        while (count < EVENT_DRAIN_BATCH) {
+            if (!event_queue_pop(event_queue, &event)) {
+                more = false;
+                break;
+            }
+            
+            // Find or add this window's pending record
+            uint32_t pos = (event.windowID * 2654435761u) & (EVENT_COALESCE_SLOTS - 1);
+            while (lookup[pos] >= 0 && pending[lookup[pos]].windowID != event.windowID) {
+                pos = (pos + 1) & (EVENT_COALESCE_SLOTS - 1);
+            }
+            if (lookup[pos] < 0) {
+                lookup[pos] = (int16_t)count;
+                pending[count].windowID = event.windowID;
+                pending[count].mask = 0;
+                pending[count].lastVisibility = 0;
+                pending[count].firstTimestamp = event.timestamp;
+                count++;
+            }
+            
+            coalesced_window_t *entry = &pending[lookup[pos]];
+            entry->mask |= 1u << event.type;
+            if (event.type == kCGSWindowDidOrderInNotification || 
+                event.type == kCGSWindowDidOrderOutNotification) {
+                entry->lastVisibility = event.type;
+            }
+        }
+        
+        // Apply in arrival order of each window's first event
+        for (int i = 0; i < count; i++) {
+            applyWindowEvents(&pending[i]);
+        }
+    }
+}
+
+// Apply a window's coalesced events
+static void applyWindowEvents(const coalesced_window_t *pending) {
+    CGSWindowID windowID = pending->windowID;
+    uint32_t mask = pending->mask;
+    
+    // Destroyed windows are evicted from every cache and the shared registry
+    if (mask & (1u << kCGSWindowDidDestroyNotification)) {
+        forgetWindow(windowID);
+        return;
+    }
+    
+    // Geometry or content changed, cached properties are stale
+    if (mask & ((1u << kCGSWindowDidResizeNotification) | (1u << kCGSWindowDidUpdateNotification))) {
+        invalidateWindowProperties(windowID);
+    }
+    
+    // Update window state tracking once per event type seen
+    static const int stateEvents[] = {
+        kCGSWindowDidCreateNotification,
+        kCGSWindowDidOrderInNotification,
+        kCGSWindowDidResizeNotification,
+        kCGSWindowDidUpdateNotification
+    };
+    for (size_t i = 0; i < sizeof(stateEvents) / sizeof(stateEvents[0]); i++) {
+        if (mask & (1u << stateEvents[i])) {
+            updateWindowState(stateEvents[i], windowID, pending->firstTimestamp);
+        }
+    }
+    
+    // Hidden windows are no longer visible but keep the rest of their state
+    if (pending->lastVisibility == kCGSWindowDidOrderOutNotification) {
+        window_table_clear_state(windowID, WINDOW_STATE_VISIBLE);
+    }
+    
+    // Perform window modification if conditions are met (in-process NSWindow modifications
+    // already covered this window)
+    if ((mask & ((1u << kCGSWindowDidCreateNotification) | (1u << kCGSWindowDidOrderInNotification))) &&
+        !window_table_is_handled(windowID)) {
+        if (isApplicationInitialized() && !isInStartupProtection()) {
+            modifyWindowWithCGS(windowID);
+        } else {
+            // Window arrived before the startup gate opened, modify it when it does
+            waitForInitGate(windowID);
+        }
+    }
+}
+
+// Drop all per-window state once a window is destroyed
+static void forgetWindow(CGSWindowID windowID) {
+    if (windowID == 0) {
+        return;
+    }
+    
+    invalidateWindowOwner(windowID);
+    invalidateWindowProperties(windowID);
+    window_table_remove(windowID);
+    unregisterNSWindowID(windowID);
+    
+    if (windowID == mainWindowID) {
+        mainWindowID = 0;
+    }
+    
+    if (window_registry) {
+        registry_forget_window(window_registry, windowID);
+    }
+    
+    // The retry queue is owned by modifier_queue
+    if (modifier_queue && onModifierQueue()) {
+        dropWindowRetry(windowID);
+    } else if (modifier_queue) {
+        dispatch_async(modifier_queue, ^{
+            dropWindowRetry(windowID);
+        });
+    }
+}
+
+// Remove a destroyed window's pending retry (runs on modifier_queue)
+static void dropWindowRetry(CGSWindowID windowID) {
+    if (retry_queue && retry_queue_remove(retry_queue, windowID)) {
+        WM_LOG_DEBUG("[Modifier] Dropped pending retry for destroyed window %d\n", windowID);
     }
 }
 
@@ -718,8 +1640,13 @@ void handleWindowEvent(int eventType, CGSWindowID windowID) {
         return;
     }
     
+    if (eventType == kCGSWindowDidDestroyNotification) {
+        forgetWindow(windowID);
+        return;
+    }
+    
     // Just pass through to the internal function
-    updateWindowState(eventType, windowID);
+    updateWindowState(eventType, windowID, wm_stats_now());
     
     // Conditionally try to modify the window
     if ((eventType == kCGSWindowDidCreateNotification || eventType == kCGSWindowDidOrderInNotification) && 
@@ -741,9 +1668,11 @@ static void startWindowMonitoring(void) {
     CGSRegisterNotifyProc_ptr(windowNotificationCallback, kCGSWindowDidOrderInNotification, NULL);
     CGSRegisterNotifyProc_ptr(windowNotificationCallback, kCGSWindowDidResizeNotification, NULL);
     CGSRegisterNotifyProc_ptr(windowNotificationCallback, kCGSWindowDidUpdateNotification, NULL);
+    CGSRegisterNotifyProc_ptr(windowNotificationCallback, kCGSWindowDidOrderOutNotification, NULL);
+    CGSRegisterNotifyProc_ptr(windowNotificationCallback, kCGSWindowDidDestroyNotification, NULL);
     
     is_cgs_monitor_active = true;
-    printf("[Modifier] Window monitoring started\n");
+    WM_LOG_INFO("[Modifier] Window monitoring started\n");
 }
 
 // Initialize thread resources
@@ -754,56 +1683,103 @@ static void initThreadResources(void) {
     }
 }
 
-// Main loop for window modifier
+// Milliseconds elapsed since a mach_absolute_time() reading
+static double elapsedMilliseconds(uint64_t start) {
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    
+    uint64_t elapsed = mach_absolute_time() - start;
+    return (double)elapsed * timebase.numer / timebase.denom / 1e6;
+}
+
+// Set up the event-driven scheduler for retries and sweeps
 static void runWindowModifier(void) {
-    int iteration_count = 0;
+    dispatch_queue_attr_t interactive = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, 
+                                                                               QOS_CLASS_USER_INTERACTIVE, 0);
+    dispatch_queue_attr_t utility = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, 
+                                                                           QOS_CLASS_UTILITY, 0);
+    modifier_queue = dispatch_queue_create("com.windowmodifier.modifier", interactive);
+    sweep_queue = dispatch_queue_create("com.windowmodifier.sweep", utility);
+    dispatch_queue_set_specific(modifier_queue, &modifier_queue_key, &modifier_queue_key, NULL);
+    
+    retry_queue = retry_queue_create(RETRY_QUEUE_INITIAL_CAPACITY, RETRY_QUEUE_MAX_CAPACITY);
+    if (!retry_queue) {
+        WM_LOG_WARN("[Modifier] Warning: Failed to create retry queue, retries disabled\n");
+    }
     
-    while (true) {
-        // Process retry queue
+    // Retries fire at their exact next attempt time instead of on a polling tick
+    retry_timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, modifier_queue);
+    dispatch_source_set_event_handler(retry_timer, ^{
+        wm_hot_path_enter();
         processRetryQueue();
-        
-        // Apply modifications to new windows if app is initialized and not in startup protection
-        if (isApplicationInitialized() && !isInStartupProtection() && (iteration_count % 50 == 0)) {
-            applyAllWindowModifications();
-        }
-        
-        // Increment iteration counter
-        iteration_count++;
-        
-        // Sleep
-        usleep(100000); // 100ms
+        scheduleRetryTimer();
+        wm_hot_path_exit();
+    });
+    dispatch_source_set_timer(retry_timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+    dispatch_resume(retry_timer);
+    
+    // Notifications are drained here; merged signals collapse into one handler run
+    event_queue = event_queue_create(EVENT_QUEUE_CAPACITY);
+    if (event_queue) {
+        event_source = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_ADD, 0, 0, modifier_queue);
+        dispatch_source_set_event_handler(event_source, ^{
+            wm_hot_path_enter();
+            drainWindowEvents();
+            wm_hot_path_exit();
+        });
+        dispatch_resume(event_source);
+    } else {
+        WM_LOG_WARN("[Modifier] Warning: Failed to create event queue, handling notifications inline\n");
     }
+    
+    WM_LOG_INFO("[Modifier] Event-driven scheduler started\n");
 }
 
-// Update application initialization state based on window events
-static void updateInitializationState(int eventType, CGSWindowID windowID) {
-    // Get window info and class
-    NSDictionary *windowInfo = getWindowInfoWithCGS(windowID);
-    window_class_t windowClass = determineWindowClass(windowID, windowInfo);
-    
-    // For phase 4, we're adding tracking of important windows - store the window ID for later reference
-    static CGSWindowID mainWindowID = 0;
-    static NSMutableArray *standardWindowIDs = nil;
-    
-    // Initialize the array if needed
-    if (!standardWindowIDs) {
-        standardWindowIDs = [[NSMutableArray alloc] init];
+// Stop the scheduler (called during injection cleanup)
+void stopWindowModifier(void) {
+    if (event_source) {
+        dispatch_source_cancel(event_source);
+        event_source = NULL;
+    }
+    if (retry_timer) {
+        dispatch_source_cancel(retry_timer);
+        retry_timer = NULL;
+    }
+    // Synchronous, so the timer can't fire after the library is unloaded
+    if (modifier_queue && onModifierQueue()) {
+        cancelInitGateTimer();
+    } else if (modifier_queue) {
+        dispatch_sync(modifier_queue, ^{
+            cancelInitGateTimer();
+        });
     }
     
-    // Check if this is a standard window and add it to our tracking if not already there
-    if (windowClass == WINDOW_CLASS_STANDARD && 
-        ![standardWindowIDs containsObject:@(windowID)]) {
-        [standardWindowIDs addObject:@(windowID)];
-        printf("[Modifier] Added standard window %d to tracking (total: %lu)\n", 
-              windowID, (unsigned long)[standardWindowIDs count]);
+    // Give the signals back their default action
+    for (size_t i = 0; i < sizeof(restore_signals) / sizeof(restore_signals[0]); i++) {
+        if (restore_sources[i]) {
+            dispatch_source_cancel(restore_sources[i]);
+            restore_sources[i] = NULL;
+            signal(restore_signals[i], SIG_DFL);
+        }
     }
+}
+
+// Update application initialization state based on window events. Each event
+// is one O(1) step: the class and initialization come from the window table,
+// the standard window counts from its running counters.
+static void updateInitializationState(int eventType, CGSWindowID windowID) {
+    window_class_t windowClass = window_table_get_class(windowID);
+    int initialized_count = 0;
     
     // Update state machine based on current state, event, and window properties
-    switch (current_init_state) {
+    switch (atomic_load(&current_init_state)) {
         case APP_INIT_NOT_STARTED:
             // Any window event moves us to the first state
-            current_init_state = APP_INIT_FIRST_WINDOW_CREATING;
-            printf("[Modifier] App initialization started (first window event detected)\n");
+            if (advanceInitState(APP_INIT_FIRST_WINDOW_CREATING)) {
+                WM_LOG_INFO("[Modifier] App initialization started (first window event detected)\n");
+            }
             break;
             
         case APP_INIT_FIRST_WINDOW_CREATING:
@@ -812,23 +1788,14 @@ static void updateInitializationState(int eventType, CGSWindowID windowID) {
                 bool initialized = isWindowInitialized(windowID);
                 
                 // Enhanced logging
-                printf("[Modifier] Standard window %d detected during initial phase (initialized: %s)\n", 
-                       windowID, initialized ? "yes" : "no");
+                WM_LOG_DEBUG("[Modifier] Standard window %d detected during initial phase (initialized: %s)\n", 
+                             windowID, initialized ? "yes" : "no");
                 
-                if (initialized) {
-                    // Count all initialized standard windows
-                    main_window_count = 0;
-                for (NSNumber *winIDObj in standardWindowIDs) {
-                    CGSWindowID trackedWinID = [winIDObj unsignedIntValue];
-                    if (isWindowInitialized(trackedWinID)) {
-                        main_window_count++;
-                    }
-                    }
-                    
-                    // Now we have at least one initialized window
-                    current_init_state = APP_INIT_FIRST_WINDOW_COMPLETE;
-                    printf("[Modifier] First window phase complete (initialized standard windows: %d)\n", 
-                           main_window_count);
+                if (initialized && advanceInitState(APP_INIT_FIRST_WINDOW_COMPLETE)) {
+                    window_table_count_standard(NULL, &initialized_count);
+                    WM_LOG_INFO("[Modifier] First window phase complete (initialized standard windows: %d)\n", 
+                                initialized_count);
+                    openInitGate();
                 }
             }
             break;
@@ -842,19 +1809,17 @@ static void updateInitializationState(int eventType, CGSWindowID windowID) {
                  eventType == kCGSWindowDidOrderInNotification) && 
                 windowClass == WINDOW_CLASS_STANDARD) {
                 
-                // Get size information - main window is typically larger
-                NSNumber *width = windowInfo[@"kCGSWindowWidth"];
-                NSNumber *height = windowInfo[@"kCGSWindowHeight"];
-                
-                // Check if this looks like a main window - use more lenient size requirements
-                // Many macOS apps have smaller main windows
-                if (width && height && 
-                    [width intValue] >= 200 && [height intValue] >= 100) {
+                // Check if this looks like a main window (typically larger) - use more
+                // lenient size requirements, many macOS apps have smaller main windows.
+                // The properties were just fetched for this event, so this hits the cache.
+                window_properties_t props;
+                if (getWindowPropertiesWithCGS(windowID, &props) && (props.present & WINDOW_PROP_HAS_SIZE) && 
+                    props.width >= 200 && props.height >= 100 &&
+                    advanceInitState(APP_INIT_MAIN_WINDOW_CREATING)) {
                     
                     mainWindowID = windowID;
-                    current_init_state = APP_INIT_MAIN_WINDOW_CREATING;
-                    printf("[Modifier] Potential main window (%d) detected (%d x %d)\n", 
-                          windowID, [width intValue], [height intValue]);
+                    WM_LOG_DEBUG("[Modifier] Potential main window (%d) detected (%d x %d)\n", 
+                                windowID, props.width, props.height);
                 }
             }
             break;
@@ -863,153 +1828,42 @@ static void updateInitializationState(int eventType, CGSWindowID windowID) {
             // The main window is considered ready when it's updated, has content, and is initialized
             
             // Track updates to the main window we identified
-            if (windowID == mainWindowID) {
-                // General update events are a good sign the window is getting ready
-                if (eventType == kCGSWindowDidUpdateNotification || 
-                    eventType == kCGSWindowDidResizeNotification) {
-                    
-                    // Check if it's fully initialized
-                    if (isWindowInitialized(windowID)) {
-                        current_init_state = APP_INIT_COMPLETE;
-                        printf("[Modifier] Application fully initialized (main window ready)\n");
-                    } else {
-                        printf("[Modifier] Main window progressing but not yet fully initialized\n");
-                    }
+            if (windowID == mainWindowID && 
+                (eventType == kCGSWindowDidUpdateNotification || eventType == kCGSWindowDidResizeNotification)) {
+                
+                // Check if it's fully initialized
+                if (!isWindowInitialized(windowID)) {
+                    WM_LOG_DEBUG("[Modifier] Main window progressing but not yet fully initialized\n");
+                } else if (advanceInitState(APP_INIT_COMPLETE)) {
+                    WM_LOG_INFO("[Modifier] Application fully initialized (main window ready)\n");
                 }
+                break;
             }
             
             // If we have multiple initialized standard windows, that's also a good
             // indication the app is ready even if we haven't positively ID'd the main window
-            if (main_window_count >= 2) {
-                current_init_state = APP_INIT_COMPLETE;
-                printf("[Modifier] Application considered initialized (multiple standard windows ready)\n");
+            window_table_count_standard(NULL, &initialized_count);
+            if (initialized_count >= 2 && advanceInitState(APP_INIT_COMPLETE)) {
+                WM_LOG_INFO("[Modifier] Application considered initialized (multiple standard windows ready)\n");
             }
             break;
             
         case APP_INIT_COMPLETE: {
             // No state changes needed, but we'll continue tracking windows
             
-            // For diagnostics, count initialized windows periodically
+            // For diagnostics, report initialized windows periodically
             static time_t last_count_time = 0;
             time_t now = time(NULL);
             
             if (now - last_count_time >= 5) { // Every 5 seconds
-                main_window_count = 0;
-                for (NSNumber *winIDObj in standardWindowIDs) {
-                    CGSWindowID trackedWinID = [winIDObj unsignedIntValue];
-                    if (isWindowInitialized(trackedWinID)) {
-                        main_window_count++;
-                    }
-                }
+                window_table_count_standard(NULL, &initialized_count);
                 
-                printf("[Modifier] Application status: %d initialized standard windows\n", main_window_count);
+                WM_LOG_DEBUG("[Modifier] Application status: %d initialized standard windows\n", initialized_count);
                 last_count_time = now;
             }
             break;
         }
     }
-    
-    // Clean up closed or invalid windows from our tracking array
-    NSMutableIndexSet *indicesToRemove = [NSMutableIndexSet indexSet];
-    [standardWindowIDs enumerateObjectsUsingBlock:^(NSNumber *winIDObj, NSUInteger idx, BOOL * __attribute__((unused)) stop) {
-        CGSWindowID trackedWinID = [winIDObj unsignedIntValue];
-        
-        // If we can't get window info, it's likely gone
-        if (!getWindowInfoWithCGS(trackedWinID)) {
-            [indicesToRemove addIndex:idx];
-            printf("[Modifier] Removing window %d from tracking (no longer exists)\n", trackedWinID);
-        }
-    }];
-    
-    // Remove all marked indices
-    if ([indicesToRemove count] > 0) {
-        [standardWindowIDs removeObjectsAtIndexes:indicesToRemove];
-    }
-}
-
-// Process name patterns for classification
-typedef struct {
-    const char* pattern;
-    process_role_t role;
-} process_pattern_t;
-
-// Common patterns in macOS process architecture
-static const process_pattern_t process_patterns[] = {
-    // UI/Rendering processes - common patterns across frameworks
-    {"Renderer", PROCESS_ROLE_UI},
-    {"WebProcess", PROCESS_ROLE_UI},
-    {"WebContent", PROCESS_ROLE_UI},
-    {"UIProcess", PROCESS_ROLE_UI},
-    {"ViewService", PROCESS_ROLE_UI},
-    {"RenderProcess", PROCESS_ROLE_UI},
-    
-    // Utility/Helper processes - common across macOS applications
-    {"GPU", PROCESS_ROLE_UTILITY},
-    {"Helper", PROCESS_ROLE_UTILITY},
-    {"Plugin", PROCESS_ROLE_UTILITY},
-    {"Utility", PROCESS_ROLE_UTILITY},
-    {"Service", PROCESS_ROLE_UTILITY},
-    {"Agent", PROCESS_ROLE_UTILITY},
-    {"XPC", PROCESS_ROLE_UTILITY},
-    {"Network", PROCESS_ROLE_UTILITY},
-    {"Storage", PROCESS_ROLE_UTILITY},
-    
-    // End marker
-    {NULL, PROCESS_ROLE_MAIN}
-};
-
-// Detect process role based on executable path - generalized for all macOS applications
-static process_role_t detectProcessRole(void) {
-    const char* processPath = getprogname();
-    if (!processPath) {
-        return PROCESS_ROLE_MAIN;
-    }
-    
-    // Extract process name from path
-    const char* processName = strrchr(processPath, '/');
-    if (processName) {
-        processName++; // Skip '/'
-    } else {
-        processName = processPath;
-    }
-    
-    // Check for position in application bundle
-    bool isMainBundle = false;
-    if (strstr(processPath, ".app/Contents/MacOS/")) {
-        // This is likely the main application executable
-        isMainBundle = true;
-    }
-    
-    // Helper processes often contain these patterns
-    for (int i = 0; process_patterns[i].pattern != NULL; i++) {
-        if (strcasestr(processName, process_patterns[i].pattern) != NULL) {
-            // If this is in the main bundle path but has a pattern match,
-            // it could be a specially named main executable, so do extra checks
-            if (isMainBundle) {
-                // Is the pattern the entire name? If so, it's probably a helper
-                size_t patternLen = strlen(process_patterns[i].pattern);
-                size_t nameLen = strlen(processName);
-                
-                // If the pattern is a significant portion of the name, it's likely matching correctly
-                if (patternLen > 3 && patternLen >= nameLen / 2) {
-                    return process_patterns[i].role;
-                }
-                
-                // Otherwise, continue checking other patterns
-            } else {
-                // Not in main bundle, so pattern match is reliable
-                return process_patterns[i].role;
-            }
-        }
-    }
-    
-    // If we reach here and it's the main bundle, it's the main process
-    if (isMainBundle) {
-        return PROCESS_ROLE_MAIN;
-    }
-    
-    // If we couldn't determine, default to standard
-    return PROCESS_ROLE_MAIN;
 }
 
 // Find a NSWindow instance that corresponds to a CGSWindowID
@@ -1018,32 +1872,51 @@ static NSWindow* findNSWindowByID(CGSWindowID windowID) {
         return nil;
     }
     
-    // Get all the windows in the application
-    NSArray *windows = [NSApp windows];
+    pthread_mutex_lock(&nsWindowsMutex);
+    NSWindow *window = [nsWindowsByID objectForKey:(__bridge id)(void *)(uintptr_t)windowID];
+    pthread_mutex_unlock(&nsWindowsMutex);
+    if (window) {
+        return window;
+    }
     
-    // Iterate through the windows and find the one with matching window number
-    for (NSWindow *window in windows) {
-        if ((CGSWindowID)[window windowNumber] == windowID) {
-            return window;
+    // Windows that existed before the swizzles were installed are picked up once here.
+    // Windows of other applications never have an NSWindow in this process.
+    if (![NSThread isMainThread]) {
+        return nil;
+    }
+    for (NSWindow *candidate in [NSApp windows]) {
+        registerNSWindow(candidate);
+        if ((CGSWindowID)[candidate windowNumber] == windowID) {
+            window = candidate;
         }
     }
     
-    // Try to find the window even if it belongs to a different application
-    // This is useful for windows with owner ID 0
-    CFArrayRef windowList = CGWindowListCopyWindowInfo(kCGWindowListOptionOnScreenOnly, kCGNullWindowID);
-    if (windowList) {
-        NSArray *windows = CFBridgingRelease(windowList);
-        for (NSDictionary *windowInfo in windows) {
-            NSNumber *winIDNum = windowInfo[(id)kCGWindowNumber];
-            if (winIDNum && [winIDNum unsignedIntValue] == windowID) {
-                // Found the window info, but we can't get an NSWindow directly for other apps
-                // Just return nil as we can't modify it via NSWindow methods
-                return nil;
-            }
-        }
+    return window;
+}
+
+// Remember an in-process NSWindow by window number
+void registerNSWindow(NSWindow *window) {
+    NSInteger windowNumber = [window windowNumber];
+    if (windowNumber <= 0) {
+        return; // Deferred windows get a number when first ordered in
     }
     
-    return nil;
+    pthread_mutex_lock(&nsWindowsMutex);
+    if (!nsWindowsByID) {
+        // Integer keys avoid boxing; weak values drop entries when windows deallocate
+        nsWindowsByID = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsOpaqueMemory | 
+                                                           NSPointerFunctionsIntegerPersonality
+                                              valueOptions:NSPointerFunctionsWeakMemory];
+    }
+    [nsWindowsByID setObject:window forKey:(__bridge id)(void *)(uintptr_t)windowNumber];
+    pthread_mutex_unlock(&nsWindowsMutex);
+}
+
+// Forget a destroyed window's NSWindow entry
+static void unregisterNSWindowID(CGSWindowID windowID) {
+    pthread_mutex_lock(&nsWindowsMutex);
+    [nsWindowsByID removeObjectForKey:(__bridge id)(void *)(uintptr_t)windowID];
+    pthread_mutex_unlock(&nsWindowsMutex);
 }
 
 // Modify a window using the AppKit NSWindow approach
@@ -1054,7 +1927,7 @@ static bool modifyWindowWithNSWindow(CGSWindowID windowID) {
     }
     
     // If we can't find the window, return false
-    printf("[Modifier] Could not find NSWindow for window ID %d\n", windowID);
+    WM_LOG_DEBUG("[Modifier] Could not find NSWindow for window ID %d\n", windowID);
     return false;
 }
 
@@ -1077,45 +1950,90 @@ static void __attribute__((unused)) modifyWindowWhenSafe(CGSWindowID windowID) {
     });
 }
 
-// Main entry point for window modifier thread
-void* window_modifier_main(void* __attribute__((unused)) arg) {
-    // Set up thread resources
-    initThreadResources();
-    
-    // Record start time
-    process_start_time = time(NULL);
-    
-    // Detect process role
-    current_process_role = detectProcessRole();
+// Bring up the registry, CGS functions, scheduler and monitoring (runs once)
+static void startWindowModifierServices(void) {
+    static dispatch_once_t onceToken;
     
-    // Initialize registry
-    if (!window_registry) {
-        window_registry = registry_init();
+    dispatch_once(&onceToken, ^{
+        uint64_t start = mach_absolute_time();
+        
+        // Set up thread resources
+        initThreadResources();
+        wm_alloc_tracking_init();
+        
+        // Record start time
+        process_start_time = time(NULL);
+        
+        // Detect process role
+        current_process_role = process_role_detect();
+        
+        // Initialize registry
         if (!window_registry) {
-            printf("[Modifier] Warning: Failed to initialize window registry\n");
+            window_registry = registry_init();
+            if (!window_registry) {
+                WM_LOG_WARN("[Modifier] Warning: Failed to initialize window registry\n");
+            }
+        }
+        
+        // Load CGS functions
+        if (!loadCGSFunctions()) {
+            WM_LOG_ERROR("[Modifier] Error: Failed to load CGS functions\n");
+            return;
         }
+        
+        // Set up the scheduler before anything can queue retries
+        runWindowModifier();
+        armInitGateTimer();
+        
+        // Start monitoring windows
+        startWindowMonitoring();
+        
+        if (reversibleModeEnabled()) {
+            installRestoreSignalHandlers();
+            WM_LOG_INFO("[Modifier] Reversible mode: windows are restored on exit\n");
+        }
+        
+        // Apply initial modifications on the sweep queue; later sweeps are event-driven
+        dispatch_async(sweep_queue, ^{
+            applyAllWindowModifications();
+        });
+        
+        WM_LOG_INFO("[Modifier] Services started in %.3f ms (%s, role: %s)\n", 
+                    elapsedMilliseconds(start), getprogname(), process_role_name(current_process_role));
+    });
+}
+
+// Start the services on first use (lazy mode), without blocking the caller
+void ensureWindowModifierStarted(void) {
+    if (atomic_load_explicit(&services_requested, memory_order_relaxed) ||
+        atomic_exchange(&services_requested, true)) {
+        return;
     }
     
-    // Load CGS functions
-    if (!loadCGSFunctions()) {
-        printf("[Modifier] Error: Failed to load CGS functions\n");
-        return NULL;
-    }
+    WM_LOG_INFO("[Modifier] First window activity, starting services\n");
+    
+    // The window that triggered this is waiting on the services, so don't start them at background QoS
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        startWindowModifierServices();
+    });
+}
+
+// Lazy mode: only install the swizzles; they start everything else on first use
+void window_modifier_lazy_init(void) {
+    initializeWindowSwizzling();
+}
+
+// Eager mode: install the swizzles now and start the services without blocking the constructor
+void window_modifier_eager_init(void) {
+    atomic_store(&services_requested, true);
     
     // Initialize method swizzling for direct NSWindow modifications
     // This helps catch windows as they're being created, especially 
     // important for windows with owner ID 0
     initializeWindowSwizzling();
-    printf("[Modifier] Window method swizzling initialized\n");
+    WM_LOG_INFO("[Modifier] Window method swizzling initialized\n");
     
-    // Start monitoring windows
-    startWindowMonitoring();
-    
-    // Apply initial modifications
-    applyAllWindowModifications();
-    
-    // Run the window modifier loop
-    runWindowModifier();
-    
-    return NULL;
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        startWindowModifierServices();
+    });
 }
@@ -2,6 +2,8 @@
 #import "window_modifier_swizzle.h"
 #import "window_modifier.h"
 #import "../tracker/window_registry.h"
+#import "../tracker/window_table.h"
+#import "../core/logging.h"
 #import <objc/runtime.h>
 
 // External function to register a window as modified
@@ -14,6 +16,7 @@ extern window_registry_t *window_registry;
                               backing:(NSBackingStoreType)backingStoreType 
                                 defer:(BOOL)flag;
 - (void)wm_makeKeyAndOrderFront:(id)sender;
+- (void)wm_applyModificationsOnShow;
 @end
 
 // Implementation of the swizzled methods
@@ -23,12 +26,18 @@ extern window_registry_t *window_registry;
                             styleMask:(NSWindowStyleMask)style 
                               backing:(NSBackingStoreType)backingStoreType 
                                 defer:(BOOL)flag {
+    // First window in a lazily initialized process brings up the services
+    ensureWindowModifierStarted();
+    
     // Call original implementation first
     NSWindow *window = [self wm_initWithContentRect:contentRect 
                                          styleMask:style 
                                            backing:backingStoreType 
                                              defer:flag];
     
+    // Non-deferred windows already have a number, remember them for lookups
+    registerNSWindow(window);
+    
     // Don't apply modifications to utility, sheet, or panel windows
     if (style & NSWindowStyleMaskUtilityWindow || 
         style & NSWindowStyleMaskDocModalWindow || 
@@ -41,7 +50,8 @@ extern window_registry_t *window_registry;
         return window;
     }
 
-    // Schedule the modification for after window creation is complete
+    // Subclass initializers may still configure the window after this returns, so the
+    // modification waits for the next main queue turn; showing it first modifies it sooner
     dispatch_async(dispatch_get_main_queue(), ^{
         // Modify the window
         modifyNSWindow(window);
@@ -51,11 +61,14 @@ extern window_registry_t *window_registry;
 }
 
 - (void)wm_makeKeyAndOrderFront:(id)sender {
+    ensureWindowModifierStarted();
+    
     // Call the original implementation first
     [self wm_makeKeyAndOrderFront:sender];
     
     // Get the window number to check in registry
     CGSWindowID windowID = (CGSWindowID)[self windowNumber];
+    registerNSWindow(self);
     
     // Don't modify windows that are too small (likely helper/utility windows)
     if (self.frame.size.width < 100 || self.frame.size.height < 50) {
@@ -63,34 +76,42 @@ extern window_registry_t *window_registry;
     }
     
     // Check if this window needs modification
-    if (windowID > 0 && window_registry && !registry_is_window_modified(window_registry, windowID)) {
-        dispatch_async(dispatch_get_main_queue(), ^{
-            // Modify the window
-            modifyNSWindow(self);
+    if (windowID > 0 && !window_table_is_handled(windowID) && 
+        window_registry && !registry_is_window_modified(window_registry, windowID)) {
+        // The window is fully built by now, so modify it right away instead of
+        // queueing behind whatever else the host has scheduled on the main queue
+        if ([NSThread isMainThread]) {
+            [self wm_applyModificationsOnShow];
+        } else {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self wm_applyModificationsOnShow];
+            });
+        }
+    }
+}
+
+- (void)wm_applyModificationsOnShow {
+    // Modify the window (records it in the window table and registry)
+    modifyNSWindow(self);
+    
+    // Temporarily set app to regular mode for Mission Control display
+    // This helps with maintaining visibility in Mission Control
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        if (NSApp && [NSApp respondsToSelector:@selector(setActivationPolicy:)]) {
+            // Store original activation policy
+            NSApplicationActivationPolicy originalPolicy = [NSApp activationPolicy];
             
-            // Mark as modified in registry
-            registry_mark_window_modified(window_registry, windowID);
+            // Briefly switch to regular mode
+            [NSApp setActivationPolicy:NSApplicationActivationPolicyRegular];
             
-            // Temporarily set app to regular mode for Mission Control display
-            // This helps with maintaining visibility in Mission Control
-            static dispatch_once_t onceToken;
-            dispatch_once(&onceToken, ^{
-                if (NSApp && [NSApp respondsToSelector:@selector(setActivationPolicy:)]) {
-                    // Store original activation policy
-                    NSApplicationActivationPolicy originalPolicy = [NSApp activationPolicy];
-                    
-                    // Briefly switch to regular mode
-                    [NSApp setActivationPolicy:NSApplicationActivationPolicyRegular];
-                    
-                    // Return to original policy after a short delay
-                    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1 * NSEC_PER_SEC)), 
-                                   dispatch_get_main_queue(), ^{
-                        [NSApp setActivationPolicy:originalPolicy];
-                    });
-                }
+            // Return to original policy after a short delay
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1 * NSEC_PER_SEC)), 
+                           dispatch_get_main_queue(), ^{
+                [NSApp setActivationPolicy:originalPolicy];
             });
-        });
-    }
+        }
+    });
 }
 
 @end
@@ -136,6 +157,6 @@ void initializeWindowSwizzling(void) {
             method_exchangeImplementations(originalShowMethod, swizzledShowMethod);
         }
         
-        NSLog(@"[WindowModifier] Successfully initialized method swizzling for NSWindow");
+        WM_LOG_INFO("[WindowModifier] Successfully initialized method swizzling for NSWindow\n");
     });
 }
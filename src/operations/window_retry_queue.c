@@ -0,0 +1,348 @@
+// window_retry_queue.c - Priority queue of windows awaiting a modification retry
+#include "window_retry_queue.h"
+#include "../core/logging.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// Empty marker in the ID index (window ID 0 is never valid)
+#define RETRY_INDEX_EMPTY 0
+
+// Retry queue structure
+struct window_retry_queue {
+    retry_window_t* heap;          // Binary min-heap ordered by next_attempt_time
+    size_t count;                  // Number of entries in the heap
+    size_t capacity;               // Allocated heap slots
+    size_t max_capacity;           // Hard limit on queued windows
+    CGSWindowID* index_ids;        // Open-addressing index: window ID
+    size_t* index_pos;             // Open-addressing index: heap position
+    size_t index_capacity;         // Index slots (power of two, at least 2x capacity)
+    _Atomic size_t depth;          // Published count for readers on other threads
+    _Atomic uint64_t dropped;      // Windows dropped on overflow
+};
+
+// Forward declarations
+static bool retry_queue_grow(window_retry_queue_t* queue);
+static bool retry_index_alloc(window_retry_queue_t* queue, size_t index_capacity);
+static size_t retry_index_home(const window_retry_queue_t* queue, CGSWindowID windowID);
+static long retry_index_find(const window_retry_queue_t* queue, CGSWindowID windowID);
+static void retry_index_set(window_retry_queue_t* queue, CGSWindowID windowID, size_t pos);
+static void retry_index_erase(window_retry_queue_t* queue, CGSWindowID windowID);
+static void retry_heap_place(window_retry_queue_t* queue, size_t pos, const retry_window_t* entry);
+static void retry_heap_sift_up(window_retry_queue_t* queue, size_t pos);
+static void retry_heap_sift_down(window_retry_queue_t* queue, size_t pos);
+static void retry_heap_remove_at(window_retry_queue_t* queue, size_t pos);
+
+// Create a queue
+window_retry_queue_t* retry_queue_create(size_t initial_capacity, size_t max_capacity) {
+    if (initial_capacity == 0) {
+        initial_capacity = 1;
+    }
+    if (max_capacity < initial_capacity) {
+        max_capacity = initial_capacity;
+    }
+    
+    window_retry_queue_t* queue = calloc(1, sizeof(window_retry_queue_t));
+    if (!queue) {
+        WM_LOG_ERROR("[RetryQueue] Failed to allocate queue: %s\n", strerror(errno));
+        return NULL;
+    }
+    
+    queue->heap = malloc(initial_capacity * sizeof(retry_window_t));
+    if (!queue->heap) {
+        WM_LOG_ERROR("[RetryQueue] Failed to allocate heap: %s\n", strerror(errno));
+        free(queue);
+        return NULL;
+    }
+    
+    queue->capacity = initial_capacity;
+    queue->max_capacity = max_capacity;
+    
+    // Index is at least twice the heap capacity to keep probe chains short
+    size_t index_capacity = 1;
+    while (index_capacity < initial_capacity * 2) {
+        index_capacity <<= 1;
+    }
+    
+    if (!retry_index_alloc(queue, index_capacity)) {
+        free(queue->heap);
+        free(queue);
+        return NULL;
+    }
+    
+    atomic_init(&queue->depth, 0);
+    atomic_init(&queue->dropped, 0);
+    
+    return queue;
+}
+
+// Destroy a queue
+void retry_queue_destroy(window_retry_queue_t* queue) {
+    if (!queue) {
+        return;
+    }
+    
+    free(queue->heap);
+    free(queue->index_ids);
+    free(queue->index_pos);
+    free(queue);
+}
+
+// Add a window to the queue
+bool retry_queue_push(window_retry_queue_t* queue, const retry_window_t* entry) {
+    if (!queue || !entry || entry->windowID == 0) {
+        return false;
+    }
+    
+    // De-duplicate by window ID
+    if (retry_index_find(queue, entry->windowID) >= 0) {
+        return true;
+    }
+    
+    if (queue->count == queue->capacity && !retry_queue_grow(queue)) {
+        atomic_fetch_add_explicit(&queue->dropped, 1, memory_order_relaxed);
+        return false;
+    }
+    
+    size_t pos = queue->count++;
+    retry_heap_place(queue, pos, entry);
+    retry_heap_sift_up(queue, pos);
+    
+    atomic_store_explicit(&queue->depth, queue->count, memory_order_relaxed);
+    return true;
+}
+
+// Get the earliest entry
+bool retry_queue_peek(const window_retry_queue_t* queue, retry_window_t* out) {
+    if (!queue || queue->count == 0) {
+        return false;
+    }
+    
+    if (out) {
+        *out = queue->heap[0];
+    }
+    return true;
+}
+
+// Remove and return the earliest entry
+bool retry_queue_pop(window_retry_queue_t* queue, retry_window_t* out) {
+    if (!queue || queue->count == 0) {
+        return false;
+    }
+    
+    if (out) {
+        *out = queue->heap[0];
+    }
+    retry_heap_remove_at(queue, 0);
+    return true;
+}
+
+// Remove a specific window
+bool retry_queue_remove(window_retry_queue_t* queue, CGSWindowID windowID) {
+    if (!queue) {
+        return false;
+    }
+    
+    long slot = retry_index_find(queue, windowID);
+    if (slot < 0) {
+        return false;
+    }
+    
+    retry_heap_remove_at(queue, queue->index_pos[slot]);
+    return true;
+}
+
+// Check if a window is queued
+bool retry_queue_contains(const window_retry_queue_t* queue, CGSWindowID windowID) {
+    return queue && retry_index_find(queue, windowID) >= 0;
+}
+
+// Number of queued windows
+size_t retry_queue_depth(const window_retry_queue_t* queue) {
+    return queue ? atomic_load_explicit(&queue->depth, memory_order_relaxed) : 0;
+}
+
+// Number of dropped windows
+uint64_t retry_queue_dropped(const window_retry_queue_t* queue) {
+    return queue ? atomic_load_explicit(&queue->dropped, memory_order_relaxed) : 0;
+}
+
+// Double the heap (bounded by max_capacity) and rebuild the index
+static bool retry_queue_grow(window_retry_queue_t* queue) {
+    if (queue->capacity >= queue->max_capacity) {
+        return false;
+    }
+    
+    size_t new_capacity = queue->capacity * 2;
+    if (new_capacity > queue->max_capacity) {
+        new_capacity = queue->max_capacity;
+    }
+    
+    retry_window_t* heap = realloc(queue->heap, new_capacity * sizeof(retry_window_t));
+    if (!heap) {
+        WM_LOG_ERROR("[RetryQueue] Failed to grow heap: %s\n", strerror(errno));
+        return false;
+    }
+    queue->heap = heap;
+    queue->capacity = new_capacity;
+    
+    if (queue->index_capacity < new_capacity * 2) {
+        CGSWindowID* old_ids = queue->index_ids;
+        size_t* old_pos = queue->index_pos;
+        size_t old_capacity = queue->index_capacity;
+        
+        if (!retry_index_alloc(queue, queue->index_capacity * 2)) {
+            queue->index_ids = old_ids;
+            queue->index_pos = old_pos;
+            queue->index_capacity = old_capacity;
+            return false;
+        }
+        
+        // Re-insert from the heap, which is the source of truth for positions
+        for (size_t i = 0; i < queue->count; i++) {
+            retry_index_set(queue, queue->heap[i].windowID, i);
+        }
+        
+        free(old_ids);
+        free(old_pos);
+    }
+    
+    return true;
+}
+
+// Allocate an empty index
+static bool retry_index_alloc(window_retry_queue_t* queue, size_t index_capacity) {
+    CGSWindowID* ids = calloc(index_capacity, sizeof(CGSWindowID));
+    size_t* pos = malloc(index_capacity * sizeof(size_t));
+    
+    if (!ids || !pos) {
+        WM_LOG_ERROR("[RetryQueue] Failed to allocate index: %s\n", strerror(errno));
+        free(ids);
+        free(pos);
+        return false;
+    }
+    
+    queue->index_ids = ids;
+    queue->index_pos = pos;
+    queue->index_capacity = index_capacity;
+    return true;
+}
+
+// Home slot of a window ID (Fibonacci hashing)
+static size_t retry_index_home(const window_retry_queue_t* queue, CGSWindowID windowID) {
+    return (size_t)(windowID * 2654435761u) & (queue->index_capacity - 1);
+}
+
+// Find the index slot of a window ID, or -1
+static long retry_index_find(const window_retry_queue_t* queue, CGSWindowID windowID) {
+    size_t mask = queue->index_capacity - 1;
+    size_t slot = retry_index_home(queue, windowID);
+    
+    while (queue->index_ids[slot] != RETRY_INDEX_EMPTY) {
+        if (queue->index_ids[slot] == windowID) {
+            return (long)slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    
+    return -1;
+}
+
+// Insert or update the heap position of a window ID
+static void retry_index_set(window_retry_queue_t* queue, CGSWindowID windowID, size_t pos) {
+    size_t mask = queue->index_capacity - 1;
+    size_t slot = retry_index_home(queue, windowID);
+    
+    while (queue->index_ids[slot] != RETRY_INDEX_EMPTY && queue->index_ids[slot] != windowID) {
+        slot = (slot + 1) & mask;
+    }
+    
+    queue->index_ids[slot] = windowID;
+    queue->index_pos[slot] = pos;
+}
+
+// Remove a window ID using backward-shift deletion (no tombstones)
+static void retry_index_erase(window_retry_queue_t* queue, CGSWindowID windowID) {
+    long found = retry_index_find(queue, windowID);
+    if (found < 0) {
+        return;
+    }
+    
+    size_t mask = queue->index_capacity - 1;
+    size_t hole = (size_t)found;
+    size_t next = (hole + 1) & mask;
+    
+    while (queue->index_ids[next] != RETRY_INDEX_EMPTY) {
+        size_t home = retry_index_home(queue, queue->index_ids[next]);
+        
+        // Move the entry back if the hole lies on its probe path
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            queue->index_ids[hole] = queue->index_ids[next];
+            queue->index_pos[hole] = queue->index_pos[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    
+    queue->index_ids[hole] = RETRY_INDEX_EMPTY;
+}
+
+// Store an entry at a heap position and record it in the index
+static void retry_heap_place(window_retry_queue_t* queue, size_t pos, const retry_window_t* entry) {
+    queue->heap[pos] = *entry;
+    retry_index_set(queue, entry->windowID, pos);
+}
+
+// Restore heap order upwards from pos
+static void retry_heap_sift_up(window_retry_queue_t* queue, size_t pos) {
+    retry_window_t entry = queue->heap[pos];
+    
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (queue->heap[parent].next_attempt_time <= entry.next_attempt_time) {
+            break;
+        }
+        retry_heap_place(queue, pos, &queue->heap[parent]);
+        pos = parent;
+    }
+    
+    retry_heap_place(queue, pos, &entry);
+}
+
+// Restore heap order downwards from pos
+static void retry_heap_sift_down(window_retry_queue_t* queue, size_t pos) {
+    retry_window_t entry = queue->heap[pos];
+    
+    while (true) {
+        size_t child = pos * 2 + 1;
+        if (child >= queue->count) {
+            break;
+        }
+        if (child + 1 < queue->count && 
+            queue->heap[child + 1].next_attempt_time < queue->heap[child].next_attempt_time) {
+            child++;
+        }
+        if (entry.next_attempt_time <= queue->heap[child].next_attempt_time) {
+            break;
+        }
+        retry_heap_place(queue, pos, &queue->heap[child]);
+        pos = child;
+    }
+    
+    retry_heap_place(queue, pos, &entry);
+}
+
+// Remove the entry at a heap position
+static void retry_heap_remove_at(window_retry_queue_t* queue, size_t pos) {
+    retry_index_erase(queue, queue->heap[pos].windowID);
+    
+    size_t last = --queue->count;
+    if (pos != last) {
+        retry_heap_place(queue, pos, &queue->heap[last]);
+        retry_heap_sift_down(queue, pos);
+        retry_heap_sift_up(queue, pos);
+    }
+    
+    atomic_store_explicit(&queue->depth, queue->count, memory_order_relaxed);
+}
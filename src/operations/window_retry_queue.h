@@ -0,0 +1,45 @@
+// window_retry_queue.h - Priority queue of windows awaiting a modification retry
+#ifndef WINDOW_RETRY_QUEUE_H
+#define WINDOW_RETRY_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../core/common_types.h"
+
+// This module keeps pending retries in a growable binary min-heap ordered by
+// next_attempt_time, with a hash index for de-duplication by window ID.
+// It is not thread-safe; the owner must serialize access (the modifier queue).
+// Only the depth and dropped counters may be read from other threads.
+
+// Retry queue opaque type
+typedef struct window_retry_queue window_retry_queue_t;
+
+// Create a queue (returns NULL on failure); pushes beyond max_capacity are dropped
+window_retry_queue_t* retry_queue_create(size_t initial_capacity, size_t max_capacity);
+
+// Destroy a queue
+void retry_queue_destroy(window_retry_queue_t* queue);
+
+// Add a window; returns false if it had to be dropped. Already queued windows are left as-is.
+bool retry_queue_push(window_retry_queue_t* queue, const retry_window_t* entry);
+
+// Get the entry with the earliest next_attempt_time without removing it
+bool retry_queue_peek(const window_retry_queue_t* queue, retry_window_t* out);
+
+// Remove and return the entry with the earliest next_attempt_time
+bool retry_queue_pop(window_retry_queue_t* queue, retry_window_t* out);
+
+// Remove a specific window from the queue
+bool retry_queue_remove(window_retry_queue_t* queue, CGSWindowID windowID);
+
+// Check if a window is queued
+bool retry_queue_contains(const window_retry_queue_t* queue, CGSWindowID windowID);
+
+// Number of queued windows
+size_t retry_queue_depth(const window_retry_queue_t* queue);
+
+// Number of windows dropped because the queue was at max_capacity or out of memory
+uint64_t retry_queue_dropped(const window_retry_queue_t* queue);
+
+#endif // WINDOW_RETRY_QUEUE_H
@@ -2,31 +2,22 @@
 #import "window_classifier.h"
 #import "../cgs/window_modifier_cgs.h"
 #import "../core/common_types.h"
+#import "window_table.h"
+#import "window_rules.h"
 #import <objc/runtime.h>
 
-// Global state for classifier
-static NSMutableDictionary *windowClassCache = nil;
-static NSMutableDictionary *windowInitStateCache = nil;
-
 // Forward declarations
-static window_class_t classifyWindowWithInfo(CGSWindowID windowID, NSDictionary *windowInfo);
-static void updateWindowInitState(CGSWindowID windowID, int eventType);
-static bool is_window_classified(CGSWindowID windowID);
+static int windowStateBitsForEvent(int eventType);
 
 // Initialize the window classifier
 bool init_window_classifier(void) {
-    // Create caches
-    windowClassCache = [[NSMutableDictionary alloc] init];
-    windowInitStateCache = [[NSMutableDictionary alloc] init];
-    
-    return (windowClassCache != nil && windowInitStateCache != nil);
+    // Classification and init state live in the shared window table
+    return window_table_init();
 }
 
 // Clean up the window classifier
 void cleanup_window_classifier(void) {
-    // Release caches
-    windowClassCache = nil;
-    windowInitStateCache = nil;
+    window_table_cleanup();
 }
 
 // Track window event
@@ -35,162 +26,68 @@ void track_window_event(CGSWindowID windowID, int eventType) {
         return;
     }
     
+    // Start tracking the window if this is the first event we see
+    if (!window_table_track(windowID, WINDOW_CLASS_UNKNOWN, NULL)) {
+        return;
+    }
+    
     // Update window initialization state
-    updateWindowInitState(windowID, eventType);
+    window_table_add_state(windowID, windowStateBitsForEvent(eventType), NULL);
     
     // Trigger classification if needed
-    if (!is_window_classified(windowID)) {
-        // Get window info
-        NSDictionary *windowInfo = getWindowInfoWithCGS(windowID);
-        if (windowInfo) {
-            // Classify window
-            window_class_t classification = classifyWindowWithInfo(windowID, windowInfo);
-            
-            // Cache classification
-            NSNumber *key = @(windowID);
-            NSNumber *value = @(classification);
-            [windowClassCache setObject:value forKey:key];
+    if (window_table_get_class(windowID) == WINDOW_CLASS_UNKNOWN) {
+        // Classify window and store the result
+        window_verdict_t verdict;
+        if (classifyWindowWithCGS(windowID, &verdict)) {
+            window_table_set_class(windowID, verdict.window_class);
         }
     }
 }
 
-// Check if window is classified
-static bool is_window_classified(CGSWindowID windowID) {
-    NSNumber *key = @(windowID);
-    return [windowClassCache objectForKey:key] != nil;
-}
-
 // Check if window is standard
 bool is_window_standard(CGSWindowID windowID) {
-    NSNumber *key = @(windowID);
-    NSNumber *currentClass = [windowClassCache objectForKey:key];
+    window_class_t currentClass = window_table_get_class(windowID);
     
-    if (currentClass) {
-        return [currentClass intValue] == WINDOW_CLASS_STANDARD;
+    if (currentClass != WINDOW_CLASS_UNKNOWN) {
+        return currentClass == WINDOW_CLASS_STANDARD;
     }
     
     // If not classified yet, classify it now
-    NSDictionary *windowInfo = getWindowInfoWithCGS(windowID);
-    if (!windowInfo) {
+    window_verdict_t verdict;
+    if (!classifyWindowWithCGS(windowID, &verdict)) {
         return false;
     }
     
-    window_class_t classification = classifyWindowWithInfo(windowID, windowInfo);
+    window_class_t classification = verdict.window_class;
     
     // Cache the result
-    [windowClassCache setObject:@(classification) forKey:key];
+    if (window_table_track(windowID, classification, NULL)) {
+        window_table_set_class(windowID, classification);
+    }
     
     return classification == WINDOW_CLASS_STANDARD;
 }
 
 // Check if window is fully initialized
 bool is_window_initialized(CGSWindowID windowID) {
-    NSNumber *key = @(windowID);
-    NSDictionary *stateDict = [windowInitStateCache objectForKey:key];
-    
-    if (stateDict) {
-        NSNumber *stateNum = stateDict[@"state"];
-        return (([stateNum unsignedIntValue] & WINDOW_STATE_FULLY_INITIALIZED) == 
-                WINDOW_STATE_FULLY_INITIALIZED);
-    }
-    
-    return false;
+    return window_table_is_initialized(windowID);
 }
 
-// Update window initialization state
-static void updateWindowInitState(CGSWindowID windowID, int eventType) {
-    NSNumber *key = @(windowID);
-    NSMutableDictionary *stateDict = [windowInitStateCache objectForKey:key];
-    
-    if (!stateDict) {
-        // Create new state
-        stateDict = [NSMutableDictionary dictionary];
-        [stateDict setObject:@(0) forKey:@"state"];
-        [stateDict setObject:@(time(NULL)) forKey:@"firstSeen"];
-        
-        [windowInitStateCache setObject:stateDict forKey:key];
-    }
-    
-    // Get current state
-    NSNumber *stateNum = stateDict[@"state"];
-    uint32_t state = [stateNum unsignedIntValue];
-    
-    // Update state based on event type
+// Map a window event to the state bit it sets
+static int windowStateBitsForEvent(int eventType) {
     switch (eventType) {
         case kCGSWindowDidCreateNotification:
-            state |= WINDOW_STATE_CREATED;
-            break;
+            return WINDOW_STATE_CREATED;
             
         case kCGSWindowDidOrderInNotification:
-            state |= WINDOW_STATE_VISIBLE;
-            break;
+            return WINDOW_STATE_VISIBLE;
             
         case kCGSWindowDidResizeNotification:
-            state |= WINDOW_STATE_SIZED;
-            break;
+            return WINDOW_STATE_SIZED;
             
         case kCGSWindowDidUpdateNotification:
-            state |= WINDOW_STATE_CONTENT_READY;
-            break;
-    }
-    
-    // Update state in dictionary
-    [stateDict setObject:@(state) forKey:@"state"];
-}
-
-// Classify window based on CGS properties
-static window_class_t classifyWindowWithInfo(CGSWindowID __attribute__((unused)) windowID, NSDictionary *windowInfo) {
-    if (!windowInfo) {
-        return WINDOW_CLASS_UNKNOWN;
-    }
-    
-    // Get window level - important for classification
-    NSNumber *level = windowInfo[@"kCGSWindowLevel"];
-    int windowLevel = level ? [level intValue] : 0;
-    
-    // Get window tags
-    NSNumber * __attribute__((unused)) tagsNum = windowInfo[@"kCGSWindowTags"];
-    // Tags could be used for additional classification if needed in the future
-    // Currently unused but preserved for future expansion
-    
-    // Get window alpha
-    NSNumber *alpha = windowInfo[@"kCGSWindowAlpha"];
-    float windowAlpha = alpha ? [alpha floatValue] : 1.0;
-    
-    // Get sharing state
-    NSNumber * __attribute__((unused)) sharingState = windowInfo[@"kCGSWindowSharingState"];
-    // Sharing state could be used for privacy features in the future
-    // Currently unused but preserved for future expansion
-    
-    // Get window title - could be used for more specific classification
-    // Currently unused but preserved for future expansion
-    
-    // Check for utility window (helper, panel, etc.)
-    if (windowLevel >= 19 && windowLevel <= 23) {
-        return WINDOW_CLASS_PANEL;
-    }
-    
-    // Check for sheet (attached to parent window)
-    if (windowInfo[@"kCGSWindowParentID"] != nil) {
-        return WINDOW_CLASS_SHEET;
-    }
-    
-    // Check for system windows
-    if (windowLevel < 0 || windowLevel > 25) {
-        return WINDOW_CLASS_SYSTEM;
-    }
-    
-    // Check for transparent or invisible windows
-    if (windowAlpha < 0.1) {
-        return WINDOW_CLASS_HELPER;
-    }
-    
-    // Check for standard application window
-    if (windowLevel == 0 || windowLevel == 1 || windowLevel == 4) {
-        // Standard window
-        return WINDOW_CLASS_STANDARD;
+            return WINDOW_STATE_CONTENT_READY;
     }
     
-    // Default to standard if nothing else matched
-    return WINDOW_CLASS_STANDARD;
+    return 0;
 }
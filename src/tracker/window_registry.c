@@ -1,160 +1,262 @@
 // window_registry.c - Cross-process window modification registry
 #include "window_registry.h"
+#include "window_stats.h"
+#include "../core/logging.h"
+#include "../core/trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/sysctl.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <signal.h>
 #include <time.h>
+#include <stdatomic.h>
+
+// The registry is one fixed header segment (process leases, statistics and one
+// descriptor per shard) plus one entry segment per shard. Windows are spread over
+// the shards by hash, and each shard has its own lock and seqlock, so processes
+// working on different windows never contend. A full shard grows by copying its
+// live entries into a new segment of twice the size and bumping the shard version
+// in the header; other processes notice the new version and remap.
+//
+// Processes launched for one application share a namespace (WM_REGISTRY_NAMESPACE,
+// set by the injector) and with it a private set of segments, so unrelated apps
+// never touch each other's locks. Namespaced registries list themselves in a small
+// global index that readers such as --stats use to find every namespace.
 
 // Registry shared memory structure
-#define MAX_REGISTRY_ENTRIES 2048
-#define REGISTRY_SHM_NAME "/window_modifier_registry"
-#define REGISTRY_LOCK_NAME "/window_modifier_registry_lock"
-#define MAX_PROCESS_AGE_SECONDS 3600 // 1 hour
+#define REGISTRY_SHARD_BITS 4
+#define REGISTRY_SHARD_COUNT (1 << REGISTRY_SHARD_BITS)
+#define REGISTRY_SHARD_INITIAL_CAPACITY 128   // Entries in a shard's first segment
+#define REGISTRY_SHARD_MAX_CAPACITY 65536     // Growth stops here (1M entries overall)
+#define REGISTRY_HASH_EMPTY 0        // Index slot never used
+#define REGISTRY_HASH_TOMBSTONE -1   // Index slot whose entry was removed
+#define REGISTRY_READ_RETRIES 4      // Lock-free read attempts before falling back to the lock
+#define REGISTRY_MAP_RETRIES 4       // Attempts to map a shard that keeps growing underneath us
+#define REGISTRY_LOCAL_CACHE_SIZE 512 // Per-process cache of known-modified windows (power of two)
+#define REGISTRY_LOCAL_CACHE_MASK (REGISTRY_LOCAL_CACHE_SIZE - 1)
+#define REGISTRY_LOCAL_CACHE_PROBES 8 // Slots examined per cache lookup
+#define REGISTRY_MAX_LEASES 1024     // Processes attached at once
+#define REGISTRY_LEASE_PROBE_SECONDS 5 // Leases not seen alive for this long get a liveness probe
+#define REGISTRY_LOCK_SPINS 64       // Lock attempts before backing off with sleeps
+#define REGISTRY_LOCK_MAX_SLEEP_USEC 1000 // Backoff ceiling while waiting for the lock
+#define REGISTRY_LOCK_TIMEOUT_USEC 500000 // Give up waiting for the lock after this long
+#define REGISTRY_INIT_WAIT_USEC 100000 // How long a joiner waits for the creator to initialize
+#define REGISTRY_MAGIC 0x574d5247    // "WMRG", set once the header is initialized
+#define REGISTRY_LAYOUT_VERSION 5    // Bumped whenever the shared layout changes
+#define REGISTRY_SHM_NAME "/window_modifier_registry" // Header of the default namespace
+#define REGISTRY_SHARD_SHM_PREFIX "/wmreg"  // Segments: prefix[.<namespace>][.<shard>.<version>] (31 chars max)
+#define REGISTRY_SHM_NAME_MAX 32
+#define REGISTRY_INDEX_SHM_NAME "/window_modifier_index" // Global list of namespaces
+#define REGISTRY_INDEX_SLOTS 64      // Namespaces listed in the global index
+#define REGISTRY_NAMESPACE_ENV "WM_REGISTRY_NAMESPACE"
+
+// Lease owner words pack (epoch << 32 | pid); the epoch changes on every claim
+#define REGISTRY_LEASE_PID(owner) ((pid_t)(uint32_t)(owner))
+#define REGISTRY_LEASE_EPOCH(owner) ((uint32_t)((owner) >> 32))
+
+// Shard lock words pack (lease epoch << 32 | lease slot + 1), so a holder is checked
+// against the lease table rather than trusted by PID alone
+#define REGISTRY_LOCK_LEASE(word) ((int)(uint32_t)(word) - 1)
+
+// Per-process lease. Entries record the lease slot and owner word they were marked
+// under, so releasing or reclaiming a lease retires all of its entries at once.
+typedef struct {
+    _Atomic uint64_t owner;       // Epoch and PID of the holder (PID 0 if free)
+    _Atomic uint64_t identity;    // Epoch and low 32 bits of the holder's start time (usec)
+    _Atomic time_t heartbeat;     // Last time the holder was known to be alive
+} registry_lease_t;
 
 // Entry in the registry
+// Fields read by the lock-free lookup path are atomic; writers still hold the lock
 typedef struct {
-    CGSWindowID windowID;        // Window ID
-    pid_t processID;             // Process that modified the window
-    time_t timestamp;            // When the window was modified
-    bool valid;                  // Whether the entry is valid
+    _Atomic CGSWindowID windowID; // Window ID
+    _Atomic uint64_t owner;       // Lease owner word of the process that modified the window
+    _Atomic uint16_t lease;       // Lease slot of that process
+    _Atomic time_t timestamp;     // When the window was modified
+    _Atomic bool valid;           // Whether the entry is valid
 } registry_entry_t;
 
-// Shared memory structure
+// Per-shard descriptor in the header. The lock and seqlock live here rather than in
+// the shard segment so they stay put when the segment is replaced.
+typedef struct {
+    _Atomic uint64_t lock_owner;  // Lock word of the lease holding the write lock (0 if free)
+    _Atomic uint32_t sequence;    // Seqlock counter (odd while the shard's index is rebuilt)
+    _Atomic uint32_t version;     // Segment version, bumped on growth (0 = no segment yet)
+    _Atomic uint32_t capacity;    // Entry capacity of the current segment
+} registry_shard_info_t;
+
+// Header segment
 typedef struct {
-    int entry_count;                          // Current number of entries
-    registry_entry_t entries[MAX_REGISTRY_ENTRIES]; // Entries
-    pid_t active_processes[256];              // Active processes
-    int process_count;                        // Number of active processes
-    time_t last_cleanup;                      // Last cleanup time
+    _Atomic uint32_t magic;                   // REGISTRY_MAGIC once initialized
+    uint32_t layout_version;                  // REGISTRY_LAYOUT_VERSION of the creator
+    uint32_t shard_count;                     // REGISTRY_SHARD_COUNT of the creator
+    _Atomic uint32_t generation;              // Bumped when leases are reclaimed or entries compacted
+    registry_shard_info_t shards[REGISTRY_SHARD_COUNT]; // Shard descriptors
+    registry_lease_t leases[REGISTRY_MAX_LEASES]; // Attached processes
+    wm_stats_slot_t stats[WM_STATS_MAX_SLOTS]; // Per-process performance statistics
 } registry_shared_t;
 
+// Global index: one slot per namespace in use, holding its hash (0 = free)
+typedef struct {
+    _Atomic uint32_t namespaces[REGISTRY_INDEX_SLOTS];
+} registry_index_t;
+
+// Shard segment: entries[capacity] followed by an index of 2 * capacity slots
+typedef struct {
+    uint32_t capacity;            // Entry slots
+    uint32_t index_mask;          // Index size - 1
+    _Atomic int entry_count;      // Current number of entries
+    int tombstone_count;          // Index slots left behind by removed windows
+    registry_entry_t entries[];   // Entries
+} registry_segment_t;
+
+// This process's mapping of one shard segment. Views are never unmapped while the
+// registry is open, since lock-free readers may still be using a replaced one.
+typedef struct registry_shard_view {
+    uint32_t version;                     // Shard version the segment belongs to
+    registry_segment_t* segment;          // Mapped segment
+    size_t size;                          // Mapping size
+    struct registry_shard_view* retired;  // Next replaced view (retired list)
+} registry_shard_view_t;
+
 // Registry structure
 struct window_registry {
     int shm_fd;                  // Shared memory file descriptor
-    registry_shared_t* shared;   // Pointer to shared memory
-    pthread_mutex_t* lock;       // Inter-process mutex
-    int lock_fd;                 // Lock file descriptor
+    uint32_t namespace_id;       // Hash of the registry namespace (0 = default namespace)
+    registry_shared_t* shared;   // Pointer to the header segment
     bool initialized;            // Whether initialization succeeded
     pid_t process_id;            // Current process ID
+    int lease;                   // This process's lease slot (-1 if none)
+    uint64_t lease_owner;        // Owner word this process holds the lease under
+    uint64_t lock_word;          // Shard lock word for that lease
+    wm_stats_slot_t* stats;      // This process's statistics slot
+    registry_shard_view_t* _Atomic views[REGISTRY_SHARD_COUNT]; // Current mapping per shard
+    registry_shard_view_t* retired_views; // Replaced mappings, unmapped at cleanup
+    pthread_mutex_t map_mutex;   // Serializes remapping within the process
+    wm_trace_id_t lock_span[REGISTRY_SHARD_COUNT]; // Signpost interval of each shard lock hold
+    // Process-local cache of modified windows, each slot packs (generation << 32 | windowID).
+    // A slot only counts as a hit while its generation matches the shared one.
+    _Atomic uint64_t local_cache[REGISTRY_LOCAL_CACHE_SIZE];
 };
 
 // Forward declarations
-static bool registry_create_lock(window_registry_t* registry);
-static void registry_cleanup_stale(window_registry_t* registry);
-static bool registry_register_process(window_registry_t* registry);
-static void registry_unregister_process(window_registry_t* registry);
-static bool registry_perform_cleanup(window_registry_t* registry);
-static bool registry_acquire_lock(window_registry_t* registry, bool block);
-static void registry_release_lock(window_registry_t* registry);
+static bool registry_open_shared(window_registry_t* registry, bool* created);
+static bool registry_claim_lease(window_registry_t* registry);
+static void registry_release_lease(window_registry_t* registry);
+static int registry_reclaim_leases(window_registry_t* registry, bool force);
+static int registry_live_leases(registry_shared_t* shared);
+static bool registry_entry_live(registry_shared_t* shared, registry_entry_t* entry);
+static uint32_t registry_namespace_from_env(void);
+static void registry_header_name(char* name, uint32_t namespaceID);
+static void registry_shard_name(char* name, uint32_t namespaceID, int shard, uint32_t version);
+static registry_index_t* registry_index_map(bool create);
+static void registry_index_register(uint32_t namespaceID);
+static void registry_index_unregister(uint32_t namespaceID);
+static int registry_read_namespace_stats(uint32_t namespaceID, wm_stats_slot_t* slots, int max_slots);
+static size_t registry_segment_size(uint32_t capacity);
+static _Atomic int32_t* registry_segment_index(registry_segment_t* segment);
+static registry_segment_t* registry_shard_segment(window_registry_t* registry, int shard);
+static registry_segment_t* registry_map_shard(window_registry_t* registry, int shard);
+static void registry_install_view(window_registry_t* registry, int shard, uint32_t version,
+                                  registry_segment_t* segment, size_t size);
+static registry_segment_t* registry_make_room(window_registry_t* registry, int shard, registry_segment_t* segment);
+static registry_segment_t* registry_grow_shard(window_registry_t* registry, int shard, registry_segment_t* segment);
+static bool registry_compact(window_registry_t* registry, int shard, registry_segment_t* segment);
+static bool registry_acquire_lock(window_registry_t* registry, int shard, bool block);
+static bool registry_try_lock(window_registry_t* registry, int shard);
+static bool registry_steal_dead_lock(window_registry_t* registry, int shard);
+static void registry_recover_lock(window_registry_t* registry, int shard);
+static void registry_release_lock(window_registry_t* registry, int shard);
+static void registry_trace_lock_held(window_registry_t* registry, int shard);
+static bool registry_process_dead(pid_t pid);
+static uint32_t registry_process_start_stamp(pid_t pid);
+static bool registry_lease_holder_dead(registry_lease_t* lease, uint64_t owner);
+static bool registry_lock_holder_dead(registry_shared_t* shared, uint64_t word);
+static uint32_t registry_hash(CGSWindowID windowID);
+static int registry_shard_of(CGSWindowID windowID);
+static int registry_find_entry(registry_shared_t* shared, registry_segment_t* segment, CGSWindowID windowID);
+static bool registry_lookup_lockfree(window_registry_t* registry, int shard, CGSWindowID windowID,
+                                     int* entryIndex, registry_segment_t** segmentOut);
+static void registry_index_insert(registry_segment_t* segment, CGSWindowID windowID, int entryIndex);
+static int registry_index_position(registry_segment_t* segment, CGSWindowID windowID, int entryIndex);
+static void registry_rebuild_index(registry_shared_t* shared, registry_segment_t* segment);
+static bool registry_local_cache_contains(window_registry_t* registry, CGSWindowID windowID, uint32_t generation);
+static void registry_local_cache_insert(window_registry_t* registry, CGSWindowID windowID, uint32_t generation);
+static void registry_local_cache_evict(window_registry_t* registry, CGSWindowID windowID, uint32_t generation);
 
 // Initialize the registry
 window_registry_t* registry_init(void) {
     // Allocate registry structure
     window_registry_t* registry = malloc(sizeof(window_registry_t));
     if (!registry) {
-        perror("[Registry] Failed to allocate registry");
+        WM_LOG_ERROR("[Registry] Failed to allocate registry: %s\n", strerror(errno));
         return NULL;
     }
     
     // Initialize registry
     registry->shm_fd = -1;
+    registry->namespace_id = registry_namespace_from_env();
     registry->shared = NULL;
-    registry->lock = NULL;
-    registry->lock_fd = -1;
     registry->initialized = false;
     registry->process_id = getpid();
-    
-    // Try to open existing shared memory
-    registry->shm_fd = shm_open(REGISTRY_SHM_NAME, O_RDWR, 0666);
-    bool created = false;
-    
-    if (registry->shm_fd == -1) {
-        // Create new shared memory
-        registry->shm_fd = shm_open(REGISTRY_SHM_NAME, O_RDWR | O_CREAT, 0666);
-        if (registry->shm_fd == -1) {
-            perror("[Registry] Failed to create shared memory");
-            free(registry);
-            return NULL;
-        }
-        
-        // Set size
-        if (ftruncate(registry->shm_fd, sizeof(registry_shared_t)) == -1) {
-            perror("[Registry] Failed to set shared memory size");
-            close(registry->shm_fd);
-            shm_unlink(REGISTRY_SHM_NAME);
-            free(registry);
-            return NULL;
-        }
-        
-        created = true;
+    registry->lease = -1;
+    registry->lease_owner = 0;
+    registry->lock_word = 0;
+    registry->stats = NULL;
+    registry->retired_views = NULL;
+    pthread_mutex_init(&registry->map_mutex, NULL);
+    for (int i = 0; i < REGISTRY_SHARD_COUNT; i++) {
+        atomic_init(&registry->views[i], NULL);
+        registry->lock_span[i] = OS_SIGNPOST_ID_NULL;
+    }
+    for (int i = 0; i < REGISTRY_LOCAL_CACHE_SIZE; i++) {
+        atomic_init(&registry->local_cache[i], 0);
     }
     
-    // Map shared memory
-    registry->shared = mmap(NULL, sizeof(registry_shared_t), PROT_READ | PROT_WRITE, 
-                            MAP_SHARED, registry->shm_fd, 0);
-    
-    if (registry->shared == MAP_FAILED) {
-        perror("[Registry] Failed to map shared memory");
-        close(registry->shm_fd);
-        if (created) {
-            shm_unlink(REGISTRY_SHM_NAME);
-        }
+    bool created = false;
+    if (!registry_open_shared(registry, &created)) {
+        pthread_mutex_destroy(&registry->map_mutex);
         free(registry);
         return NULL;
     }
     
-    // Initialize shared memory if we created it
-    if (created) {
-        memset(registry->shared, 0, sizeof(registry_shared_t));
-        registry->shared->entry_count = 0;
-        registry->shared->process_count = 0;
-        registry->shared->last_cleanup = time(NULL);
-    }
-    
-    // Create lock
-    if (!registry_create_lock(registry)) {
+    // Retire leases of processes that died without cleaning up, then take one
+    registry_reclaim_leases(registry, false);
+    if (!registry_claim_lease(registry)) {
+        WM_LOG_ERROR("[Registry] No free process lease (%d processes attached)\n", REGISTRY_MAX_LEASES);
         munmap(registry->shared, sizeof(registry_shared_t));
         close(registry->shm_fd);
-        if (created) {
-            shm_unlink(REGISTRY_SHM_NAME);
-        }
+        pthread_mutex_destroy(&registry->map_mutex);
         free(registry);
         return NULL;
     }
     
-    // Register this process
-    if (!registry_register_process(registry)) {
-        perror("[Registry] Failed to register process");
-        munmap(registry->shared, sizeof(registry_shared_t));
-        close(registry->shm_fd);
-        if (registry->lock) {
-            pthread_mutex_destroy(registry->lock);
-            if (registry->lock_fd != -1) {
-                close(registry->lock_fd);
-            }
-            shm_unlink(REGISTRY_LOCK_NAME);
-        }
-        if (created) {
-            shm_unlink(REGISTRY_SHM_NAME);
-        }
-        free(registry);
-        return NULL;
+    // Claim a statistics slot (slots are owned by pid, no lock needed)
+    registry->stats = wm_stats_claim_slot(registry->shared->stats, WM_STATS_MAX_SLOTS);
+    if (registry->stats) {
+        wm_stats_attach(registry->stats);
+    } else {
+        WM_LOG_WARN("[Registry] No free statistics slot, stats disabled for this process\n");
     }
     
-    // Clean up stale entries
-    registry_cleanup_stale(registry);
+    // Make the namespace visible to readers that don't know its name
+    if (registry->namespace_id != 0) {
+        registry_index_register(registry->namespace_id);
+    }
     
     registry->initialized = true;
-    printf("[Registry] Initialized (mode: %s, entries: %d, processes: %d)\n", 
-           created ? "created" : "joined", 
-           registry->shared->entry_count, 
-           registry->shared->process_count);
+    WM_LOG_INFO("[Registry] Initialized (mode: %s, namespace: %08x, shards: %d, processes: %d)\n",
+                created ? "created" : "joined",
+                registry->namespace_id,
+                REGISTRY_SHARD_COUNT,
+                registry_live_leases(registry->shared));
     
     return registry;
 }
@@ -165,11 +267,43 @@ void registry_cleanup(window_registry_t* registry) {
         return;
     }
     
-    // Final cleanup
-    registry_cleanup_stale(registry);
+    // Releasing the lease retires every entry this process recorded
+    registry_release_lease(registry);
+    
+    // Give up the statistics slot
+    wm_stats_release_slot(registry->stats);
+    registry->stats = NULL;
+    
+    // Check for other attached processes before the mapping goes away
+    bool last_process = (registry->shared && registry->shared != MAP_FAILED &&
+                         registry_live_leases(registry->shared) == 0);
+    
+    // Unlink the current shard segments if nobody else is attached
+    if (last_process) {
+        char name[REGISTRY_SHM_NAME_MAX];
+        for (int shard = 0; shard < REGISTRY_SHARD_COUNT; shard++) {
+            uint32_t version = atomic_load(&registry->shared->shards[shard].version);
+            if (version != 0) {
+                registry_shard_name(name, registry->namespace_id, shard, version);
+                shm_unlink(name);
+            }
+        }
+    }
     
-    // Unregister this process
-    registry_unregister_process(registry);
+    // Unmap shard segments, including replaced ones
+    for (int shard = 0; shard < REGISTRY_SHARD_COUNT; shard++) {
+        registry_shard_view_t* view = atomic_load(&registry->views[shard]);
+        if (view) {
+            view->retired = registry->retired_views;
+            registry->retired_views = view;
+        }
+    }
+    while (registry->retired_views) {
+        registry_shard_view_t* view = registry->retired_views;
+        registry->retired_views = view->retired;
+        munmap(view->segment, view->size);
+        free(view);
+    }
     
     // Unmap shared memory
     if (registry->shared != MAP_FAILED && registry->shared != NULL) {
@@ -181,20 +315,17 @@ void registry_cleanup(window_registry_t* registry) {
         close(registry->shm_fd);
     }
     
-    // Clean up lock
-    if (registry->lock) {
-        pthread_mutex_destroy(registry->lock);
-        if (registry->lock_fd != -1) {
-            close(registry->lock_fd);
+    // If this was the last process, unlink shared memory and leave the index
+    if (last_process) {
+        char name[REGISTRY_SHM_NAME_MAX];
+        registry_header_name(name, registry->namespace_id);
+        shm_unlink(name);
+        if (registry->namespace_id != 0) {
+            registry_index_unregister(registry->namespace_id);
         }
-        shm_unlink(REGISTRY_LOCK_NAME);
-    }
-    
-    // If this was the last process, unlink shared memory
-    if (registry->shared && registry->shared->process_count == 0) {
-        shm_unlink(REGISTRY_SHM_NAME);
     }
     
+    pthread_mutex_destroy(&registry->map_mutex);
     registry->initialized = false;
     free(registry);
 }
@@ -205,84 +336,74 @@ bool registry_mark_window_modified(window_registry_t* registry, CGSWindowID wind
         return false;
     }
     
-    bool success = false;
+    registry_shared_t* shared = registry->shared;
+    int shard = registry_shard_of(windowID);
+    
+    // Read the generation before the shared lookup so a concurrent removal can't be cached
+    uint32_t generation = atomic_load_explicit(&shared->generation, memory_order_acquire);
+    
+    // This process already knows the window is registered
+    if (registry_local_cache_contains(registry, windowID, generation)) {
+        return true;
+    }
+    
+    time_t now = time(NULL);
+    atomic_store_explicit(&shared->leases[registry->lease].heartbeat, now, memory_order_relaxed);
+    
+    // Fast path: window already registered, refresh its timestamp without the lock
+    int existing = -1;
+    registry_segment_t* found = NULL;
+    if (registry_lookup_lockfree(registry, shard, windowID, &existing, &found) && existing >= 0) {
+        atomic_store_explicit(&found->entries[existing].timestamp, now, memory_order_relaxed);
+        registry_local_cache_insert(registry, windowID, generation);
+        return true;
+    }
     
-    // Acquire lock
-    if (!registry_acquire_lock(registry, true)) {
+    // Acquire the shard lock for insertion
+    if (!registry_acquire_lock(registry, shard, true)) {
         return false;
     }
     
-    // Check if window is already in registry
-    bool found = false;
-    for (int i = 0; i < registry->shared->entry_count; i++) {
-        if (registry->shared->entries[i].valid && 
-            registry->shared->entries[i].windowID == windowID) {
-            // Update timestamp
-            registry->shared->entries[i].timestamp = time(NULL);
-            found = true;
-            success = true;
-            break;
-        }
+    // Check again now that we hold the lock (another process may have inserted it)
+    registry_segment_t* segment = registry_shard_segment(registry, shard);
+    int slot = segment ? registry_find_entry(shared, segment, windowID) : -1;
+    if (slot >= 0) {
+        atomic_store_explicit(&segment->entries[slot].timestamp, now, memory_order_relaxed);
+        registry_release_lock(registry, shard);
+        registry_local_cache_insert(registry, windowID, generation);
+        return true;
     }
     
-    // Add new entry if not found
-    if (!found) {
-        // Find empty slot
-        int slot = -1;
-        for (int i = 0; i < registry->shared->entry_count; i++) {
-            if (!registry->shared->entries[i].valid) {
-                slot = i;
-                break;
-            }
-        }
-        
-        // If no empty slot, add at end
-        if (slot == -1) {
-            if (registry->shared->entry_count >= MAX_REGISTRY_ENTRIES) {
-                // Registry full, try to clean up
-                if (!registry_perform_cleanup(registry)) {
-                    registry_release_lock(registry);
-                    return false;
-                }
-                
-                // Try again
-                for (int i = 0; i < registry->shared->entry_count; i++) {
-                    if (!registry->shared->entries[i].valid) {
-                        slot = i;
-                        break;
-                    }
-                }
-                
-                // Still full
-                if (slot == -1) {
-                    registry_release_lock(registry);
-                    return false;
-                }
-            } else {
-                // Add at end
-                slot = registry->shared->entry_count;
-                registry->shared->entry_count++;
-            }
+    // Entries are kept compacted, so new entries are always appended
+    if (!segment || atomic_load_explicit(&segment->entry_count, memory_order_relaxed) >= (int)segment->capacity) {
+        segment = registry_make_room(registry, shard, segment);
+        if (!segment) {
+            registry_release_lock(registry, shard);
+            return false;
         }
-        
-        // Add entry
-        registry->shared->entries[slot].windowID = windowID;
-        registry->shared->entries[slot].processID = registry->process_id;
-        registry->shared->entries[slot].timestamp = time(NULL);
-        registry->shared->entries[slot].valid = true;
-        
-        success = true;
-    }
     
-    // Periodic cleanup (every ~10 operations)
-    if (rand() % 10 == 0) {
-        registry_cleanup_stale(registry);
+        // Making room may have retired entries, cache under the new generation
+        generation = atomic_load_explicit(&shared->generation, memory_order_acquire);
     }
+    int count = atomic_load_explicit(&segment->entry_count, memory_order_relaxed);
+    
+    // Fill in the entry before publishing it through the index
+    registry_entry_t* entry = &segment->entries[count];
+    atomic_store_explicit(&entry->windowID, windowID, memory_order_relaxed);
+    atomic_store_explicit(&entry->owner, registry->lease_owner, memory_order_relaxed);
+    atomic_store_explicit(&entry->lease, (uint16_t)registry->lease, memory_order_relaxed);
+    atomic_store_explicit(&entry->timestamp, now, memory_order_relaxed);
+    atomic_store_explicit(&entry->valid, true, memory_order_relaxed);
+    atomic_store_explicit(&segment->entry_count, count + 1, memory_order_release);
+    
+    registry_index_insert(segment, windowID, count);
     
     // Release lock
-    registry_release_lock(registry);
+    registry_release_lock(registry, shard);
     
-    return success;
+    registry_local_cache_insert(registry, windowID, generation);
+    
+    return true;
 }
 
 // Check if a window has been modified
@@ -291,28 +412,129 @@ bool registry_is_window_modified(window_registry_t* registry, CGSWindowID window
         return false;
     }
     
-    bool found = false;
+    int shard = registry_shard_of(windowID);
     
-    // Acquire lock
-    if (!registry_acquire_lock(registry, true)) {
-        return false;
+    // Read the generation before the shared lookup so a concurrent removal can't be cached
+    uint32_t generation = atomic_load_explicit(&registry->shared->generation, memory_order_acquire);
+    
+    // Common case: answered from this process's cache
+    if (registry_local_cache_contains(registry, windowID, generation)) {
+        return true;
     }
     
-    // Search registry
-    for (int i = 0; i < registry->shared->entry_count; i++) {
-        if (registry->shared->entries[i].valid && 
-            registry->shared->entries[i].windowID == windowID) {
-            found = true;
-            break;
+    int entryIndex = -1;
+    if (registry_lookup_lockfree(registry, shard, windowID, &entryIndex, NULL)) {
+        if (entryIndex >= 0) {
+            registry_local_cache_insert(registry, windowID, generation);
+            return true;
         }
+        return false;
     }
     
+    // Writers kept rebuilding the index; take the lock as a last resort
+    if (!registry_acquire_lock(registry, shard, true)) {
+        return false;
+    }
+    
+    registry_segment_t* segment = registry_shard_segment(registry, shard);
+    bool found = segment && (registry_find_entry(registry->shared, segment, windowID) >= 0);
+    
     // Release lock
-    registry_release_lock(registry);
+    registry_release_lock(registry, shard);
+    
+    if (found) {
+        registry_local_cache_insert(registry, windowID, generation);
+    }
     
     return found;
 }
 
+// Remove a destroyed window from the registry
+bool registry_forget_window(window_registry_t* registry, CGSWindowID windowID) {
+    if (!registry || !registry->initialized || !registry->shared) {
+        return false;
+    }
+    
+    registry_shared_t* shared = registry->shared;
+    int shard = registry_shard_of(windowID);
+    registry_shard_info_t* info = &shared->shards[shard];
+    
+    // Window IDs are never reused, so other processes' cached hits for a destroyed
+    // window are harmless; only this process's entry goes, and no generation bump
+    // flushes everyone else's cache
+    registry_local_cache_evict(registry, windowID,
+                               atomic_load_explicit(&shared->generation, memory_order_acquire));
+    
+    // Most destroyed windows were never modified, skip the lock for those
+    int existing = -1;
+    if (registry_lookup_lockfree(registry, shard, windowID, &existing, NULL) && existing < 0) {
+        return false;
+    }
+    
+    if (!registry_acquire_lock(registry, shard, true)) {
+        return false;
+    }
+    
+    registry_segment_t* segment = registry_shard_segment(registry, shard);
+    int slot = segment ? registry_find_entry(shared, segment, windowID) : -1;
+    if (slot < 0) {
+        registry_release_lock(registry, shard);
+        return false;
+    }
+    
+    _Atomic int32_t* index = registry_segment_index(segment);
+    
+    // Readers retry while the sequence is odd, since the last entry moves into the hole
+    atomic_fetch_add_explicit(&info->sequence, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    int pos = registry_index_position(segment, windowID, slot);
+    if (pos >= 0) {
+        atomic_store_explicit(&index[pos], REGISTRY_HASH_TOMBSTONE, memory_order_relaxed);
+        segment->tombstone_count++;
+    }
+    
+    // Keep entries compacted by moving the last entry into the freed slot
+    int last = atomic_load_explicit(&segment->entry_count, memory_order_relaxed) - 1;
+    if (slot != last) {
+        registry_entry_t* src = &segment->entries[last];
+        registry_entry_t* dst = &segment->entries[slot];
+        CGSWindowID movedID = atomic_load_explicit(&src->windowID, memory_order_relaxed);
+    
+        atomic_store_explicit(&dst->windowID, movedID, memory_order_relaxed);
+        atomic_store_explicit(&dst->owner,
+                              atomic_load_explicit(&src->owner, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_store_explicit(&dst->lease,
+                              atomic_load_explicit(&src->lease, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_store_explicit(&dst->timestamp,
+                              atomic_load_explicit(&src->timestamp, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_store_explicit(&dst->valid,
+                              atomic_load_explicit(&src->valid, memory_order_relaxed),
+                              memory_order_relaxed);
+    
+        int movedPos = registry_index_position(segment, movedID, last);
+        if (movedPos >= 0) {
+            atomic_store_explicit(&index[movedPos], slot + 1, memory_order_relaxed);
+        }
+    }
+    atomic_store_explicit(&segment->entries[last].valid, false, memory_order_relaxed);
+    atomic_store_explicit(&segment->entry_count, last, memory_order_relaxed);
+    
+    // Tombstones lengthen every miss, rebuild once they pile up
+    if (segment->tombstone_count > (int)(segment->index_mask + 1) / 4) {
+        registry_rebuild_index(shared, segment);
+    }
+    
+    atomic_fetch_add_explicit(&info->sequence, 1, memory_order_release);
+    
+    registry_release_lock(registry, shard);
+    
+    return true;
+}
+
 // Get modified window count
 int registry_get_modified_count(window_registry_t* registry) {
     if (!registry || !registry->initialized || !registry->shared) {
@@ -321,301 +543,1083 @@ int registry_get_modified_count(window_registry_t* registry) {
     
     int count = 0;
     
-    // Acquire lock
-    if (!registry_acquire_lock(registry, true)) {
+    // Shards are counted one at a time, so the total is a snapshot per shard
+    for (int shard = 0; shard < REGISTRY_SHARD_COUNT; shard++) {
+        if (!registry_acquire_lock(registry, shard, true)) {
+            continue;
+        }
+    
+        // Count entries whose process is still attached
+        registry_segment_t* segment = registry_shard_segment(registry, shard);
+        int entry_count = segment ? atomic_load_explicit(&segment->entry_count, memory_order_relaxed) : 0;
+        for (int i = 0; i < entry_count; i++) {
+            if (registry_entry_live(registry->shared, &segment->entries[i])) {
+                count++;
+            }
+        }
+    
+        registry_release_lock(registry, shard);
+    }
+    
+    return count;
+}
+
+// Copy the statistics of every live process in every namespace (works without joining)
+int registry_read_stats(wm_stats_slot_t* slots, int max_slots) {
+    if (!slots || max_slots <= 0) {
         return 0;
     }
     
-    // Count valid entries
-    for (int i = 0; i < registry->shared->entry_count; i++) {
-        if (registry->shared->entries[i].valid) {
-            count++;
-        }
+    int count = registry_read_namespace_stats(0, slots, max_slots);
+    
+    registry_index_t* index = registry_index_map(false);
+    if (!index) {
+        return count;
     }
     
-    // Release lock
-    registry_release_lock(registry);
+    for (int i = 0; i < REGISTRY_INDEX_SLOTS && count < max_slots; i++) {
+        uint32_t namespaceID = atomic_load_explicit(&index->namespaces[i], memory_order_acquire);
+        if (namespaceID != 0) {
+            count += registry_read_namespace_stats(namespaceID, slots + count, max_slots - count);
+        }
+    }
     
+    munmap(index, sizeof(registry_index_t));
     return count;
 }
 
-// Create inter-process lock
-static bool registry_create_lock(window_registry_t* registry) {
-    // Open shared memory for lock - first unlink any existing one to ensure clean state
-    shm_unlink(REGISTRY_LOCK_NAME); // Ignore errors - may not exist
-    
-    // Open shared memory for lock
-    registry->lock_fd = shm_open(REGISTRY_LOCK_NAME, O_RDWR | O_CREAT | O_EXCL, 0666);
-    if (registry->lock_fd == -1) {
-        // If it failed with EEXIST, try to open existing
-        if (errno == EEXIST) {
-            registry->lock_fd = shm_open(REGISTRY_LOCK_NAME, O_RDWR, 0666);
-            if (registry->lock_fd == -1) {
-                perror("[Registry] Failed to open existing lock shared memory");
-                return false;
+// Copy the statistics of the live processes of one namespace
+static int registry_read_namespace_stats(uint32_t namespaceID, wm_stats_slot_t* slots, int max_slots) {
+    char name[REGISTRY_SHM_NAME_MAX];
+    registry_header_name(name, namespaceID);
+    
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd == -1) {
+        return 0;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(registry_shared_t)) {
+        close(fd);
+        return 0;
+    }
+    
+    registry_shared_t* shared = mmap(NULL, sizeof(registry_shared_t), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shared == MAP_FAILED) {
+        return 0;
+    }
+    
+    int count = 0;
+    if (atomic_load_explicit(&shared->magic, memory_order_acquire) == REGISTRY_MAGIC &&
+        shared->layout_version == REGISTRY_LAYOUT_VERSION) {
+        for (int i = 0; i < WM_STATS_MAX_SLOTS && count < max_slots; i++) {
+            pid_t pid = atomic_load(&shared->stats[i].pid);
+            if (pid == 0 || registry_process_dead(pid)) {
+                continue;
             }
-        } else {
-            perror("[Registry] Failed to create lock shared memory");
-            return false;
+    
+            // Counters are monotonic so a torn snapshot is off by at most a few samples
+            memcpy(&slots[count], &shared->stats[i], sizeof(wm_stats_slot_t));
+            count++;
         }
     }
     
-    // Get size of pthread_mutex_t on this system
-    size_t mutex_size = sizeof(pthread_mutex_t);
-    // Round up to page size to ensure compatibility
-    long page_size = sysconf(_SC_PAGESIZE);
-    if (page_size < 0) page_size = 4096; // Default to 4K if sysconf fails
+    munmap(shared, sizeof(registry_shared_t));
+    return count;
+}
+
+// Create or join the header segment. Only the process whose O_EXCL create succeeds
+// initializes it; joiners wait until the creator has published the magic.
+static bool registry_open_shared(window_registry_t* registry, bool* created) {
+    *created = false;
+    
+    char name[REGISTRY_SHM_NAME_MAX];
+    registry_header_name(name, registry->namespace_id);
     
-    size_t shm_size = ((mutex_size + page_size - 1) / page_size) * page_size;
+    registry->shm_fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (registry->shm_fd != -1) {
+        if (ftruncate(registry->shm_fd, sizeof(registry_shared_t)) == -1) {
+            WM_LOG_ERROR("[Registry] Failed to set shared memory size: %s\n", strerror(errno));
+            close(registry->shm_fd);
+            shm_unlink(name);
+            return false;
+        }
+        *created = true;
+    } else if (errno == EEXIST) {
+        registry->shm_fd = shm_open(name, O_RDWR, 0666);
+    }
     
-    // Set size - ensure it's at least one page
-    if (ftruncate(registry->lock_fd, shm_size) == -1) {
-        perror("[Registry] Failed to set lock shared memory size");
-        close(registry->lock_fd);
-        shm_unlink(REGISTRY_LOCK_NAME);
+    if (registry->shm_fd == -1) {
+        WM_LOG_ERROR("[Registry] Failed to open shared memory: %s\n", strerror(errno));
         return false;
     }
     
+    // A joiner may race the creator's ftruncate; mapping past the end would fault later
+    struct stat st;
+    int waited = 0;
+    while (!*created && (fstat(registry->shm_fd, &st) == -1 || (size_t)st.st_size < sizeof(registry_shared_t))) {
+        if (waited >= REGISTRY_INIT_WAIT_USEC) {
+            WM_LOG_ERROR("[Registry] Shared memory has unexpected size, not joining\n");
+            close(registry->shm_fd);
+            return false;
+        }
+        usleep(1000);
+        waited += 1000;
+    }
+    
     // Map shared memory
-    registry->lock = mmap(NULL, sizeof(pthread_mutex_t), PROT_READ | PROT_WRITE, 
-                         MAP_SHARED, registry->lock_fd, 0);
+    registry->shared = mmap(NULL, sizeof(registry_shared_t), PROT_READ | PROT_WRITE,
+                            MAP_SHARED, registry->shm_fd, 0);
     
-    if (registry->lock == MAP_FAILED) {
-        perror("[Registry] Failed to map lock shared memory");
-        close(registry->lock_fd);
-        shm_unlink(REGISTRY_LOCK_NAME);
+    if (registry->shared == MAP_FAILED) {
+        WM_LOG_ERROR("[Registry] Failed to map shared memory: %s\n", strerror(errno));
+        close(registry->shm_fd);
+        if (*created) {
+            shm_unlink(name);
+        }
         return false;
     }
     
-    // Initialize mutex with process-shared attribute
-    pthread_mutexattr_t attr;
-    if (pthread_mutexattr_init(&attr) != 0) {
-        perror("[Registry] Failed to initialize mutex attributes");
-        munmap(registry->lock, sizeof(pthread_mutex_t));
-        close(registry->lock_fd);
-        shm_unlink(REGISTRY_LOCK_NAME);
-        return false;
+    // Fresh segments are zero-filled, which is the empty state; publish the layout
+    if (*created) {
+        registry->shared->layout_version = REGISTRY_LAYOUT_VERSION;
+        registry->shared->shard_count = REGISTRY_SHARD_COUNT;
+        atomic_store_explicit(&registry->shared->magic, REGISTRY_MAGIC, memory_order_release);
+        return true;
     }
     
-    if (pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) != 0) {
-        perror("[Registry] Failed to set mutex as process-shared");
-        pthread_mutexattr_destroy(&attr);
-        munmap(registry->lock, sizeof(pthread_mutex_t));
-        close(registry->lock_fd);
-        shm_unlink(REGISTRY_LOCK_NAME);
-        return false;
+    while (atomic_load_explicit(&registry->shared->magic, memory_order_acquire) != REGISTRY_MAGIC) {
+        if (waited >= REGISTRY_INIT_WAIT_USEC) {
+            WM_LOG_ERROR("[Registry] Shared memory was never initialized, not joining\n");
+            munmap(registry->shared, sizeof(registry_shared_t));
+            close(registry->shm_fd);
+            return false;
+        }
+        usleep(1000);
+        waited += 1000;
     }
     
-    if (pthread_mutex_init(registry->lock, &attr) != 0) {
-        perror("[Registry] Failed to initialize mutex");
-        pthread_mutexattr_destroy(&attr);
-        munmap(registry->lock, sizeof(pthread_mutex_t));
-        close(registry->lock_fd);
-        shm_unlink(REGISTRY_LOCK_NAME);
+    // A segment left by a build with another layout can't be shared
+    if (registry->shared->layout_version != REGISTRY_LAYOUT_VERSION ||
+        registry->shared->shard_count != REGISTRY_SHARD_COUNT) {
+        WM_LOG_ERROR("[Registry] Shared memory layout %u/%u doesn't match %u/%u, not joining\n",
+                     registry->shared->layout_version, registry->shared->shard_count,
+                     REGISTRY_LAYOUT_VERSION, REGISTRY_SHARD_COUNT);
+        munmap(registry->shared, sizeof(registry_shared_t));
+        close(registry->shm_fd);
         return false;
     }
     
-    pthread_mutexattr_destroy(&attr);
     return true;
 }
 
-// Register this process in the registry
-static bool registry_register_process(window_registry_t* registry) {
-    if (!registry || !registry->shared) {
-        return false;
+// Take a free lease; the new epoch retires whatever a previous holder left behind
+static bool registry_claim_lease(window_registry_t* registry) {
+    registry_shared_t* shared = registry->shared;
+    uint32_t start_stamp = registry_process_start_stamp(registry->process_id);
+    
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < REGISTRY_MAX_LEASES; i++) {
+            uint64_t owner = atomic_load_explicit(&shared->leases[i].owner, memory_order_acquire);
+            if (REGISTRY_LEASE_PID(owner) != 0) {
+                continue;
+            }
+    
+            uint64_t claimed = ((uint64_t)(REGISTRY_LEASE_EPOCH(owner) + 1) << 32) |
+                               (uint32_t)registry->process_id;
+            if (atomic_compare_exchange_strong_explicit(&shared->leases[i].owner, &owner, claimed,
+                                                        memory_order_acq_rel, memory_order_relaxed)) {
+                atomic_store_explicit(&shared->leases[i].heartbeat, time(NULL), memory_order_relaxed);
+    
+                // Tagged with the epoch, so a reader never pairs it with another claim
+                if (start_stamp != 0) {
+                    atomic_store_explicit(&shared->leases[i].identity,
+                                          (claimed & ~(uint64_t)UINT32_MAX) | start_stamp,
+                                          memory_order_release);
+                }
+                registry->lease = i;
+                registry->lease_owner = claimed;
+                registry->lock_word = (claimed & ~(uint64_t)UINT32_MAX) | (uint32_t)(i + 1);
+                return true;
+            }
+        }
+    
+        // Every lease is held, probe all holders rather than only idle ones
+        if (registry_reclaim_leases(registry, true) == 0) {
+            break;
+        }
     }
     
-    // Acquire lock
-    if (!registry_acquire_lock(registry, true)) {
-        return false;
+    return false;
+}
+
+// Give up this process's lease, retiring its entries without touching them
+static void registry_release_lease(window_registry_t* registry) {
+    if (!registry->shared || registry->lease < 0) {
+        return;
     }
     
-    // Check if process is already registered
-    for (int i = 0; i < registry->shared->process_count; i++) {
-        if (registry->shared->active_processes[i] == registry->process_id) {
-            // Already registered
-            registry_release_lock(registry);
-            return true;
-        }
+    registry_shared_t* shared = registry->shared;
+    uint64_t owner = registry->lease_owner;
+    uint64_t released = owner & ~(uint64_t)UINT32_MAX;
+    
+    if (atomic_compare_exchange_strong_explicit(&shared->leases[registry->lease].owner, &owner, released,
+                                                memory_order_acq_rel, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&shared->generation, 1, memory_order_release);
     }
     
-    // Add process
-    if (registry->shared->process_count >= 256) {
-        // Registry full, try to clean up
-        if (!registry_perform_cleanup(registry)) {
-            registry_release_lock(registry);
-            return false;
+    registry->lease = -1;
+    registry->lease_owner = 0;
+    registry->lock_word = 0;
+}
+
+// Free the leases of processes that exited without cleaning up (no lock needed).
+// Each reclaimed lease retires all of that process's entries in O(1); the entry
+// slots themselves are recycled by the next compaction. Unless forced, only leases
+// not seen alive for a while are probed. Returns the number reclaimed.
+static int registry_reclaim_leases(window_registry_t* registry, bool force) {
+    registry_shared_t* shared = registry->shared;
+    time_t now = time(NULL);
+    int reclaimed = 0;
+    
+    for (int i = 0; i < REGISTRY_MAX_LEASES; i++) {
+        registry_lease_t* lease = &shared->leases[i];
+        uint64_t owner = atomic_load_explicit(&lease->owner, memory_order_acquire);
+        pid_t pid = REGISTRY_LEASE_PID(owner);
+        if (pid == 0 || i == registry->lease) {
+            continue;
         }
-        
-        // Check again
-        if (registry->shared->process_count >= 256) {
-            registry_release_lock(registry);
-            return false;
+    
+        if (!force && now - atomic_load_explicit(&lease->heartbeat, memory_order_relaxed) <
+                      REGISTRY_LEASE_PROBE_SECONDS) {
+            continue;
+        }
+    
+        if (!registry_lease_holder_dead(lease, owner)) {
+            atomic_store_explicit(&lease->heartbeat, now, memory_order_relaxed);
+            continue;
+        }
+    
+        uint64_t released = owner & ~(uint64_t)UINT32_MAX;
+        if (atomic_compare_exchange_strong_explicit(&lease->owner, &owner, released,
+                                                    memory_order_acq_rel, memory_order_relaxed)) {
+            WM_LOG_INFO("[Registry] Reclaimed lease %d of exited process %d\n", i, pid);
+            reclaimed++;
+        }
+    }
+    
+    // Cached hits for the retired entries must be dropped
+    if (reclaimed > 0) {
+        atomic_fetch_add_explicit(&shared->generation, 1, memory_order_release);
+    }
+    
+    return reclaimed;
+}
+
+// Count attached processes
+static int registry_live_leases(registry_shared_t* shared) {
+    int count = 0;
+    for (int i = 0; i < REGISTRY_MAX_LEASES; i++) {
+        if (REGISTRY_LEASE_PID(atomic_load_explicit(&shared->leases[i].owner, memory_order_relaxed)) != 0) {
+            count++;
         }
     }
     
-    // Add process
-    registry->shared->active_processes[registry->shared->process_count] = registry->process_id;
-    registry->shared->process_count++;
+    return count;
+}
+
+// Check that an entry is valid and still held under its process's current lease
+static bool registry_entry_live(registry_shared_t* shared, registry_entry_t* entry) {
+    if (!atomic_load_explicit(&entry->valid, memory_order_relaxed)) {
+        return false;
+    }
     
-    // Release lock
-    registry_release_lock(registry);
+    uint16_t lease = atomic_load_explicit(&entry->lease, memory_order_relaxed);
+    if (lease >= REGISTRY_MAX_LEASES) {
+        return false;
+    }
     
-    return true;
+    return atomic_load_explicit(&shared->leases[lease].owner, memory_order_acquire) ==
+           atomic_load_explicit(&entry->owner, memory_order_relaxed);
 }
 
-// Unregister this process
-static void registry_unregister_process(window_registry_t* registry) {
-    if (!registry || !registry->shared) {
-        return;
+// Namespace selected by the environment, hashed so segment names stay short (FNV-1a)
+static uint32_t registry_namespace_from_env(void) {
+    const char* value = getenv(REGISTRY_NAMESPACE_ENV);
+    if (!value || value[0] == '\0') {
+        return 0;
+    }
+    
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* c = (const unsigned char*)value; *c; c++) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    
+    // 0 is reserved for the default namespace and free index slots
+    return hash != 0 ? hash : 1;
+}
+
+// Name of a namespace's header segment
+static void registry_header_name(char* name, uint32_t namespaceID) {
+    if (namespaceID == 0) {
+        snprintf(name, REGISTRY_SHM_NAME_MAX, "%s", REGISTRY_SHM_NAME);
+    } else {
+        snprintf(name, REGISTRY_SHM_NAME_MAX, "%s.%08x", REGISTRY_SHARD_SHM_PREFIX, namespaceID);
+    }
+}
+
+// Name of a shard segment version
+static void registry_shard_name(char* name, uint32_t namespaceID, int shard, uint32_t version) {
+    if (namespaceID == 0) {
+        snprintf(name, REGISTRY_SHM_NAME_MAX, "%s.%x.%x", REGISTRY_SHARD_SHM_PREFIX, shard, version);
+    } else {
+        snprintf(name, REGISTRY_SHM_NAME_MAX, "%s.%08x.%x.%x", REGISTRY_SHARD_SHM_PREFIX,
+                 namespaceID, shard, version);
+    }
+}
+
+// Map the global namespace index (zero-filled is the empty state, so it needs no setup)
+static registry_index_t* registry_index_map(bool create) {
+    int fd = shm_open(REGISTRY_INDEX_SHM_NAME, create ? (O_RDWR | O_CREAT) : O_RDONLY, 0666);
+    if (fd == -1) {
+        return NULL;
     }
     
-    // Acquire lock
-    if (!registry_acquire_lock(registry, true)) {
+    struct stat st;
+    if (create && fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(registry_index_t)) {
+        // Growing to the same size from several processes at once is harmless
+        if (ftruncate(fd, sizeof(registry_index_t)) == -1) {
+            WM_LOG_WARN("[Registry] Failed to size namespace index: %s\n", strerror(errno));
+        }
+    }
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(registry_index_t)) {
+        close(fd);
+        return NULL;
+    }
+    
+    registry_index_t* index = mmap(NULL, sizeof(registry_index_t), create ? (PROT_READ | PROT_WRITE) : PROT_READ,
+                                   MAP_SHARED, fd, 0);
+    close(fd);
+    return index == MAP_FAILED ? NULL : index;
+}
+
+// List a namespace in the global index, taking over slots of namespaces that are gone
+static void registry_index_register(uint32_t namespaceID) {
+    registry_index_t* index = registry_index_map(true);
+    if (!index) {
+        WM_LOG_WARN("[Registry] Namespace index unavailable, --stats won't see this namespace\n");
         return;
     }
     
-    // Find process
-    for (int i = 0; i < registry->shared->process_count; i++) {
-        if (registry->shared->active_processes[i] == registry->process_id) {
-            // Remove process by shifting all others down
-            for (int j = i; j < registry->shared->process_count - 1; j++) {
-                registry->shared->active_processes[j] = registry->shared->active_processes[j + 1];
+    bool listed = false;
+    for (int i = 0; i < REGISTRY_INDEX_SLOTS && !listed; i++) {
+        listed = atomic_load_explicit(&index->namespaces[i], memory_order_relaxed) == namespaceID;
+    }
+    
+    char name[REGISTRY_SHM_NAME_MAX];
+    for (int i = 0; i < REGISTRY_INDEX_SLOTS && !listed; i++) {
+        uint32_t current = atomic_load_explicit(&index->namespaces[i], memory_order_relaxed);
+        if (current != 0) {
+            // A namespace whose header is gone ended without unregistering
+            registry_header_name(name, current);
+            int fd = shm_open(name, O_RDONLY, 0);
+            if (fd != -1) {
+                close(fd);
+                continue;
+            }
+            if (errno != ENOENT) {
+                continue;
             }
-            registry->shared->process_count--;
-            break;
         }
+        listed = atomic_compare_exchange_strong_explicit(&index->namespaces[i], &current, namespaceID,
+                                                         memory_order_release, memory_order_relaxed);
     }
     
-    // Release lock
-    registry_release_lock(registry);
+    if (!listed) {
+        WM_LOG_WARN("[Registry] Namespace index full, --stats won't see this namespace\n");
+    }
+    munmap(index, sizeof(registry_index_t));
 }
 
-// Perform registry cleanup
-static bool registry_perform_cleanup(window_registry_t* registry) {
-    if (!registry || !registry->shared) {
-        return false;
+// Remove a namespace from the global index
+static void registry_index_unregister(uint32_t namespaceID) {
+    registry_index_t* index = registry_index_map(true);
+    if (!index) {
+        return;
     }
     
-    time_t now = time(NULL);
+    for (int i = 0; i < REGISTRY_INDEX_SLOTS; i++) {
+        uint32_t expected = namespaceID;
+        atomic_compare_exchange_strong_explicit(&index->namespaces[i], &expected, 0,
+                                                memory_order_release, memory_order_relaxed);
+    }
+    munmap(index, sizeof(registry_index_t));
+}
+
+// Bytes needed for a shard segment of the given capacity
+static size_t registry_segment_size(uint32_t capacity) {
+    return sizeof(registry_segment_t) + (size_t)capacity * sizeof(registry_entry_t) +
+           (size_t)capacity * 2 * sizeof(int32_t);
+}
+
+// Index of a shard segment (entry index + 1 per slot), stored after the entries
+static _Atomic int32_t* registry_segment_index(registry_segment_t* segment) {
+    return (_Atomic int32_t*)&segment->entries[segment->capacity];
+}
+
+// Current segment of a shard, remapping if it grew since we last looked (NULL if empty)
+static registry_segment_t* registry_shard_segment(window_registry_t* registry, int shard) {
+    uint32_t version = atomic_load_explicit(&registry->shared->shards[shard].version, memory_order_acquire);
+    registry_shard_view_t* view = atomic_load_explicit(&registry->views[shard], memory_order_acquire);
     
-    // Check if we need to clean up
-    if (now - registry->shared->last_cleanup < 60) {
-        // Less than a minute since last cleanup
-        return true;
+    if (view && view->version == version) {
+        return view->segment;
+    }
+    if (version == 0) {
+        return NULL;
     }
     
-    printf("[Registry] Performing cleanup (entries: %d, processes: %d)\n", 
-           registry->shared->entry_count, registry->shared->process_count);
+    return registry_map_shard(registry, shard);
+}
+
+// Map the current version of a shard segment
+static registry_segment_t* registry_map_shard(window_registry_t* registry, int shard) {
+    registry_shard_info_t* info = &registry->shared->shards[shard];
+    registry_segment_t* segment = NULL;
+    char name[REGISTRY_SHM_NAME_MAX];
+    
+    pthread_mutex_lock(&registry->map_mutex);
     
-    // Mark entries for dead processes as invalid
-    for (int i = 0; i < registry->shared->entry_count; i++) {
-        if (!registry->shared->entries[i].valid) {
+    for (int attempt = 0; attempt < REGISTRY_MAP_RETRIES && !segment; attempt++) {
+        uint32_t version = atomic_load_explicit(&info->version, memory_order_acquire);
+    
+        // Another thread may have mapped it already
+        registry_shard_view_t* view = atomic_load_explicit(&registry->views[shard], memory_order_acquire);
+        if (view && view->version == version) {
+            segment = view->segment;
+            break;
+        }
+    
+        // A segment that grew again before we opened it is already unlinked, try the next one
+        registry_shard_name(name, registry->namespace_id, shard, version);
+        int fd = shm_open(name, O_RDWR, 0666);
+        if (fd == -1) {
             continue;
         }
-        
-        // Check if process is still active
-        bool active = false;
-        for (int j = 0; j < registry->shared->process_count; j++) {
-            if (registry->shared->entries[i].processID == registry->shared->active_processes[j]) {
-                active = true;
-                break;
-            }
+    
+        struct stat st;
+        if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(registry_segment_t)) {
+            close(fd);
+            continue;
         }
-        
-        // If not active, mark as invalid
-        if (!active) {
-            registry->shared->entries[i].valid = false;
+    
+        size_t size = (size_t)st.st_size;
+        void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            WM_LOG_ERROR("[Registry] Failed to map shard %d: %s\n", shard, strerror(errno));
+            break;
+        }
+    
+        segment = mapped;
+        if (registry_segment_size(segment->capacity) > size) {
+            munmap(mapped, size);
+            segment = NULL;
+            continue;
         }
+    
+        registry_install_view(registry, shard, version, segment, size);
+    }
+    
+    pthread_mutex_unlock(&registry->map_mutex);
+    
+    if (!segment) {
+        WM_LOG_WARN("[Registry] Could not map shard %d\n", shard);
+    }
+    return segment;
+}
+
+// Make a mapping this process's current view of a shard (caller holds map_mutex)
+static void registry_install_view(window_registry_t* registry, int shard, uint32_t version,
+                                  registry_segment_t* segment, size_t size) {
+    registry_shard_view_t* view = malloc(sizeof(registry_shard_view_t));
+    if (!view) {
+        return; // The segment stays mapped and is simply looked up again next time
     }
     
-    // Compact registry
+    view->version = version;
+    view->segment = segment;
+    view->size = size;
+    
+    registry_shard_view_t* old = atomic_exchange_explicit(&registry->views[shard], view, memory_order_acq_rel);
+    if (old) {
+        old->retired = registry->retired_views;
+        registry->retired_views = old;
+    }
+}
+
+// Free an entry slot in a full shard (caller holds the shard lock). Dead processes
+// are retired first; a shard that is mostly dead weight is compacted in place,
+// otherwise it grows. Returns the segment to append to, or NULL if none.
+static registry_segment_t* registry_make_room(window_registry_t* registry, int shard, registry_segment_t* segment) {
+    if (!segment) {
+        return registry_grow_shard(registry, shard, NULL);
+    }
+    
+    registry_reclaim_leases(registry, true);
+    
+    int live = 0;
+    int entry_count = atomic_load_explicit(&segment->entry_count, memory_order_relaxed);
+    for (int i = 0; i < entry_count; i++) {
+        if (registry_entry_live(registry->shared, &segment->entries[i])) {
+            live++;
+        }
+    }
+    
+    if (live > (int)segment->capacity / 2) {
+        registry_segment_t* grown = registry_grow_shard(registry, shard, segment);
+        if (grown) {
+            return grown;
+        }
+    }
+    
+    registry_compact(registry, shard, segment);
+    if (atomic_load_explicit(&segment->entry_count, memory_order_relaxed) >= (int)segment->capacity) {
+        WM_LOG_WARN("[Registry] Shard %d full at %u entries\n", shard, segment->capacity);
+        return NULL;
+    }
+    
+    return segment;
+}
+
+// Move a shard's live entries into a new segment of twice the capacity and publish
+// it (caller holds the shard lock). The old segment is unlinked but stays valid for
+// processes that still have it mapped until they notice the new version.
+static registry_segment_t* registry_grow_shard(window_registry_t* registry, int shard, registry_segment_t* segment) {
+    registry_shard_info_t* info = &registry->shared->shards[shard];
+    uint32_t capacity = segment ? segment->capacity * 2 : REGISTRY_SHARD_INITIAL_CAPACITY;
+    if (capacity > REGISTRY_SHARD_MAX_CAPACITY) {
+        return NULL;
+    }
+    
+    uint32_t old_version = atomic_load_explicit(&info->version, memory_order_relaxed);
+    uint32_t version = old_version + 1;
+    size_t size = registry_segment_size(capacity);
+    char name[REGISTRY_SHM_NAME_MAX];
+    registry_shard_name(name, registry->namespace_id, shard, version);
+    
+    // Only the lock holder creates this name; anything there is left from a crashed grow
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd == -1) {
+        WM_LOG_ERROR("[Registry] Failed to create shard %d segment: %s\n", shard, strerror(errno));
+        return NULL;
+    }
+    
+    if (ftruncate(fd, (off_t)size) == -1) {
+        WM_LOG_ERROR("[Registry] Failed to size shard %d segment: %s\n", shard, strerror(errno));
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    
+    registry_segment_t* grown = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (grown == MAP_FAILED) {
+        WM_LOG_ERROR("[Registry] Failed to map shard %d segment: %s\n", shard, strerror(errno));
+        shm_unlink(name);
+        return NULL;
+    }
+    
+    // Fresh segments are zero-filled; only the geometry needs setting before the copy
+    grown->capacity = capacity;
+    grown->index_mask = capacity * 2 - 1;
+    
+    int count = 0;
+    int entry_count = segment ? atomic_load_explicit(&segment->entry_count, memory_order_relaxed) : 0;
+    for (int i = 0; i < entry_count; i++) {
+        registry_entry_t* src = &segment->entries[i];
+        if (!registry_entry_live(registry->shared, src)) {
+            continue;
+        }
+    
+        registry_entry_t* dst = &grown->entries[count];
+        CGSWindowID windowID = atomic_load_explicit(&src->windowID, memory_order_relaxed);
+        atomic_store_explicit(&dst->windowID, windowID, memory_order_relaxed);
+        atomic_store_explicit(&dst->owner,
+                              atomic_load_explicit(&src->owner, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_store_explicit(&dst->lease,
+                              atomic_load_explicit(&src->lease, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_store_explicit(&dst->timestamp,
+                              atomic_load_explicit(&src->timestamp, memory_order_relaxed),
+                              memory_order_relaxed);
+        atomic_store_explicit(&dst->valid, true, memory_order_relaxed);
+        registry_index_insert(grown, windowID, count);
+        count++;
+    }
+    atomic_store_explicit(&grown->entry_count, count, memory_order_relaxed);
+    
+    pthread_mutex_lock(&registry->map_mutex);
+    registry_install_view(registry, shard, version, grown, size);
+    pthread_mutex_unlock(&registry->map_mutex);
+    
+    // Publish: the release store orders the copy before any reader sees the version
+    atomic_store_explicit(&info->capacity, capacity, memory_order_relaxed);
+    atomic_store_explicit(&info->version, version, memory_order_release);
+    
+    if (old_version != 0) {
+        registry_shard_name(name, registry->namespace_id, shard, old_version);
+        shm_unlink(name);
+    }
+    
+    // Retired entries were left behind in the copy
+    if (count != entry_count) {
+        atomic_fetch_add_explicit(&registry->shared->generation, 1, memory_order_release);
+    }
+    
+    WM_LOG_INFO("[Registry] Shard %d grew to %u entries (%d live)\n", shard, capacity, count);
+    return grown;
+}
+
+// Drop retired entries in one pass and rebuild the index (caller holds the shard lock)
+static bool registry_compact(window_registry_t* registry, int shard, registry_segment_t* segment) {
+    registry_shared_t* shared = registry->shared;
+    registry_shard_info_t* info = &shared->shards[shard];
+    int entry_count = atomic_load_explicit(&segment->entry_count, memory_order_relaxed);
+    
+    // Readers retry while the sequence is odd, since entries move during compaction
+    atomic_fetch_add_explicit(&info->sequence, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
     int write_index = 0;
-    for (int i = 0; i < registry->shared->entry_count; i++) {
-        if (registry->shared->entries[i].valid) {
-            if (i != write_index) {
-                registry->shared->entries[write_index] = registry->shared->entries[i];
+    for (int i = 0; i < entry_count; i++) {
+        registry_entry_t* src = &segment->entries[i];
+        if (!registry_entry_live(shared, src)) {
+            atomic_store_explicit(&src->valid, false, memory_order_relaxed);
+            continue;
+        }
+    
+        if (i != write_index) {
+            registry_entry_t* dst = &segment->entries[write_index];
+            atomic_store_explicit(&dst->windowID,
+                                  atomic_load_explicit(&src->windowID, memory_order_relaxed),
+                                  memory_order_relaxed);
+            atomic_store_explicit(&dst->owner,
+                                  atomic_load_explicit(&src->owner, memory_order_relaxed),
+                                  memory_order_relaxed);
+            atomic_store_explicit(&dst->lease,
+                                  atomic_load_explicit(&src->lease, memory_order_relaxed),
+                                  memory_order_relaxed);
+            atomic_store_explicit(&dst->timestamp,
+                                  atomic_load_explicit(&src->timestamp, memory_order_relaxed),
+                                  memory_order_relaxed);
+            atomic_store_explicit(&dst->valid, true, memory_order_relaxed);
+            atomic_store_explicit(&src->valid, false, memory_order_relaxed);
+        }
+        write_index++;
+    }
+    
+    // Update entry count and index to match the compacted entries
+    atomic_store_explicit(&segment->entry_count, write_index, memory_order_relaxed);
+    registry_rebuild_index(shared, segment);
+    
+    // Invalidate every process's local cache if anything was removed
+    if (write_index != entry_count) {
+        atomic_fetch_add_explicit(&shared->generation, 1, memory_order_release);
+    }
+    
+    atomic_fetch_add_explicit(&info->sequence, 1, memory_order_release);
+    
+    WM_LOG_INFO("[Registry] Compacted shard %d (%d -> %d)\n", shard, entry_count, write_index);
+    
+    return write_index != entry_count;
+}
+
+// Acquire a shard's write lock. Waiters spin, then back off with short sleeps; a lock
+// left behind by a crashed process is taken over instead of blocking everyone.
+static bool registry_acquire_lock(window_registry_t* registry, int shard, bool block) {
+    if (!registry || !registry->shared || registry->lock_word == 0) {
+        return false;
+    }
+    
+    // Uncontended fast path; only waits are timed
+    if (registry_try_lock(registry, shard)) {
+        wm_stats_increment(WM_STAT_LOCK_ACQUIRED);
+        registry_trace_lock_held(registry, shard);
+        return true;
+    }
+    
+    if (!block) {
+        return false;
+    }
+    
+    wm_stats_increment(WM_STAT_LOCK_CONTENDED);
+    uint64_t wait_start = wm_stats_now();
+    
+    bool acquired = false;
+    useconds_t sleep_usec = 10;
+    long waited_usec = 0;
+    
+    for (int attempt = 1; !acquired; attempt++) {
+        if (attempt <= REGISTRY_LOCK_SPINS) {
+            sched_yield();
+        } else {
+            // The holder may have died; only worth checking once the wait gets long
+            if (registry_steal_dead_lock(registry, shard)) {
+                acquired = true;
+                break;
+            }
+    
+            if (waited_usec >= REGISTRY_LOCK_TIMEOUT_USEC) {
+                WM_LOG_WARN("[Registry] Shard %d lock held by lease %d for over %d ms, giving up\n",
+                            shard, REGISTRY_LOCK_LEASE(atomic_load(&registry->shared->shards[shard].lock_owner)),
+                            REGISTRY_LOCK_TIMEOUT_USEC / 1000);
+                break;
+            }
+    
+            usleep(sleep_usec);
+            waited_usec += sleep_usec;
+            if (sleep_usec < REGISTRY_LOCK_MAX_SLEEP_USEC) {
+                sleep_usec *= 2;
             }
-            write_index++;
         }
+    
+        acquired = registry_try_lock(registry, shard);
     }
     
-    // Update entry count
-    registry->shared->entry_count = write_index;
+    wm_stats_record_since(WM_HIST_LOCK_WAIT, wait_start);
+    
+    if (acquired) {
+        wm_stats_increment(WM_STAT_LOCK_ACQUIRED);
+        registry_trace_lock_held(registry, shard);
+    }
+    
+    return acquired;
+}
+
+// Try to take a shard's write lock once
+static bool registry_try_lock(window_registry_t* registry, int shard) {
+    uint64_t expected = 0;
+    return atomic_compare_exchange_strong_explicit(&registry->shared->shards[shard].lock_owner, &expected,
+                                                   registry->lock_word,
+                                                   memory_order_acquire, memory_order_relaxed);
+}
+
+// Take over a shard lock if its holder has exited, repairing what it left half done
+static bool registry_steal_dead_lock(window_registry_t* registry, int shard) {
+    registry_shard_info_t* info = &registry->shared->shards[shard];
+    uint64_t holder = atomic_load_explicit(&info->lock_owner, memory_order_relaxed);
     
-    // Update last cleanup time
-    registry->shared->last_cleanup = now;
+    if (holder == 0 || holder == registry->lock_word || !registry_lock_holder_dead(registry->shared, holder)) {
+        return false;
+    }
     
-    printf("[Registry] Cleanup complete (new entries: %d)\n", registry->shared->entry_count);
+    if (!atomic_compare_exchange_strong_explicit(&info->lock_owner, &holder, registry->lock_word,
+                                                 memory_order_acquire, memory_order_relaxed)) {
+        return false;
+    }
     
+    WM_LOG_WARN("[Registry] Took over shard %d lock from exited holder of lease %d\n", 
+                shard, REGISTRY_LOCK_LEASE(holder));
+    registry_recover_lock(registry, shard);
     return true;
 }
 
-// Clean up stale registry entries
-static void registry_cleanup_stale(window_registry_t* registry) {
+// Restore consistency after a holder died inside a critical section (caller holds the lock).
+// Entries are filled before they are published and a grown segment is only published
+// once complete, so only an interrupted removal or compaction, which runs with the
+// sequence odd, can leave the index out of step.
+static void registry_recover_lock(window_registry_t* registry, int shard) {
+    registry_shard_info_t* info = &registry->shared->shards[shard];
+    if (!(atomic_load_explicit(&info->sequence, memory_order_relaxed) & 1)) {
+        return;
+    }
+    
+    registry_segment_t* segment = registry_shard_segment(registry, shard);
+    if (segment) {
+        registry_rebuild_index(registry->shared, segment);
+    }
+    atomic_fetch_add_explicit(&registry->shared->generation, 1, memory_order_release);
+    atomic_fetch_add_explicit(&info->sequence, 1, memory_order_release);
+}
+
+// Release a shard lock
+static void registry_release_lock(window_registry_t* registry, int shard) {
     if (!registry || !registry->shared) {
         return;
     }
     
-    // Acquire lock
-    if (!registry_acquire_lock(registry, false)) {
+    WM_TRACE_END(registry->lock_span[shard], "RegistryLock");
+    atomic_store_explicit(&registry->shared->shards[shard].lock_owner, 0, memory_order_release);
+}
+
+// Open the lock hold signpost interval (a shard lock is held by one thread at a time)
+static void registry_trace_lock_held(window_registry_t* registry, int shard) {
+    if (!wm_trace_enabled) {
         return;
     }
     
-    // Perform cleanup
-    registry_perform_cleanup(registry);
+    registry->lock_span[shard] = wm_trace_make_id();
+    WM_TRACE_BEGIN(registry->lock_span[shard], "RegistryLock", "shard %d", shard);
+}
+
+// Check whether a process has exited
+static bool registry_process_dead(pid_t pid) {
+    return kill(pid, 0) == -1 && errno == ESRCH;
+}
+
+// Low 32 bits of a process's start time in microseconds (0 if unavailable); enough
+// to tell a reused PID from the process that held it
+static uint32_t registry_process_start_stamp(pid_t pid) {
+    struct kinfo_proc info;
+    size_t size = sizeof(info);
+    int mib[4] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, pid};
+    
+    if (sysctl(mib, 4, &info, &size, NULL, 0) != 0 || size == 0) {
+        return 0;
+    }
     
-    // Release lock
-    registry_release_lock(registry);
+    struct timeval started = info.kp_proc.p_starttime;
+    return (uint32_t)((uint64_t)started.tv_sec * 1000000 + (uint64_t)started.tv_usec);
 }
 
-// Acquire lock with timeout and retry functionality for better resilience
-static bool registry_acquire_lock(window_registry_t* registry, bool block) {
-    if (!registry || !registry->lock) {
+// Check whether a lease's holder has exited, including when its PID now belongs
+// to a newer process
+static bool registry_lease_holder_dead(registry_lease_t* lease, uint64_t owner) {
+    pid_t pid = REGISTRY_LEASE_PID(owner);
+    if (registry_process_dead(pid)) {
+        return true;
+    }
+    
+    // No start time recorded for this claim, the PID is all there is to go on
+    uint64_t identity = atomic_load_explicit(&lease->identity, memory_order_acquire);
+    if (REGISTRY_LEASE_EPOCH(identity) != REGISTRY_LEASE_EPOCH(owner)) {
         return false;
     }
     
-    int result;
+    uint32_t stamp = registry_process_start_stamp(pid);
+    return stamp != 0 && stamp != (uint32_t)identity;
+}
+
+// Check whether a shard lock's holder has exited: its lease was given up or
+// reclaimed since it took the lock, or the lease holder itself is gone
+static bool registry_lock_holder_dead(registry_shared_t* shared, uint64_t word) {
+    int lease = REGISTRY_LOCK_LEASE(word);
+    if (lease < 0 || lease >= REGISTRY_MAX_LEASES) {
+        return true;
+    }
+    
+    uint64_t owner = atomic_load_explicit(&shared->leases[lease].owner, memory_order_acquire);
+    if (REGISTRY_LEASE_PID(owner) == 0 || REGISTRY_LEASE_EPOCH(owner) != REGISTRY_LEASE_EPOCH(word)) {
+        return true;
+    }
     
-    if (block) {
-        // For blocking mode, implement a timeout and retry mechanism to avoid deadlocks
-        // This is especially important for cross-process locks which can be more fragile
-        int retries = 0;
-        const int max_retries = 3;
-        
-        do {
-            result = pthread_mutex_lock(registry->lock);
-            
-            // If successful or error other than timeout, break
-            if (result == 0 || result != ETIMEDOUT) {
-                break;
+    return registry_lease_holder_dead(&shared->leases[lease], owner);
+}
+
+// Hash a window ID (Fibonacci hashing); the top bits pick the shard, the low bits the index slot
+static uint32_t registry_hash(CGSWindowID windowID) {
+    return windowID * 2654435761u;
+}
+
+// Shard holding a window ID
+static int registry_shard_of(CGSWindowID windowID) {
+    return (int)(registry_hash(windowID) >> (32 - REGISTRY_SHARD_BITS));
+}
+
+// Probe a shard's index for a window ID, returns the entry index or -1
+static int registry_find_entry(registry_shared_t* shared, registry_segment_t* segment, CGSWindowID windowID) {
+    _Atomic int32_t* index = registry_segment_index(segment);
+    uint32_t mask = segment->index_mask;
+    uint32_t pos = registry_hash(windowID) & mask;
+    int entry_count = atomic_load_explicit(&segment->entry_count, memory_order_acquire);
+    
+    for (uint32_t probe = 0; probe <= mask; probe++) {
+        int32_t slot = atomic_load_explicit(&index[pos], memory_order_acquire);
+    
+        if (slot == REGISTRY_HASH_EMPTY) {
+            return -1;
+        }
+    
+        if (slot != REGISTRY_HASH_TOMBSTONE && slot <= entry_count) {
+            registry_entry_t* entry = &segment->entries[slot - 1];
+            if (atomic_load_explicit(&entry->windowID, memory_order_relaxed) == windowID &&
+                registry_entry_live(shared, entry)) {
+                return slot - 1;
             }
-            
-            // If timeout, log and retry
-            printf("[Registry] Lock acquisition timeout, retrying (%d/%d)...\n", 
-                   retries + 1, max_retries);
-            
-            // Small delay before retry to help with contention
-            usleep(10000 * (retries + 1));  // 10ms, 20ms, 30ms
-            retries++;
-        } while (retries < max_retries);
-    } else {
-        result = pthread_mutex_trylock(registry->lock);
+        }
+    
+        pos = (pos + 1) & mask;
     }
     
-    if (result != 0 && result != EBUSY) {
-        printf("[Registry] Lock acquisition failed: %s (error %d)\n", 
-               strerror(result), result);
+    return -1;
+}
+
+// Look up a window without the lock; returns false if a consistent read wasn't possible.
+// *segmentOut (optional) receives the segment the entry index refers to.
+static bool registry_lookup_lockfree(window_registry_t* registry, int shard, CGSWindowID windowID,
+                                     int* entryIndex, registry_segment_t** segmentOut) {
+    registry_shard_info_t* info = &registry->shared->shards[shard];
+    
+    for (int attempt = 0; attempt < REGISTRY_READ_RETRIES; attempt++) {
+        uint32_t begin = atomic_load_explicit(&info->sequence, memory_order_acquire);
+        if (begin & 1) {
+            // Index is being rebuilt, try again
+            continue;
+        }
+    
+        // A shard without a segment has never had an entry
+        registry_segment_t* segment = registry_shard_segment(registry, shard);
+        int result = segment ? registry_find_entry(registry->shared, segment, windowID) : -1;
+    
+        atomic_thread_fence(memory_order_acquire);
+        uint32_t end = atomic_load_explicit(&info->sequence, memory_order_relaxed);
+        if (begin == end) {
+            *entryIndex = result;
+            if (segmentOut) {
+                *segmentOut = segment;
+            }
+            return true;
+        }
     }
     
-    return (result == 0);
+    return false;
 }
 
-// Release lock
-static void registry_release_lock(window_registry_t* registry) {
-    if (!registry || !registry->lock) {
-        return;
+// Publish an entry in a shard's index (caller holds the shard lock)
+static void registry_index_insert(registry_segment_t* segment, CGSWindowID windowID, int entryIndex) {
+    _Atomic int32_t* index = registry_segment_index(segment);
+    uint32_t mask = segment->index_mask;
+    uint32_t pos = registry_hash(windowID) & mask;
+    
+    for (uint32_t probe = 0; probe <= mask; probe++) {
+        int32_t slot = atomic_load_explicit(&index[pos], memory_order_relaxed);
+        if (slot == REGISTRY_HASH_EMPTY || slot == REGISTRY_HASH_TOMBSTONE) {
+            if (slot == REGISTRY_HASH_TOMBSTONE) {
+                segment->tombstone_count--;
+            }
+            atomic_store_explicit(&index[pos], entryIndex + 1, memory_order_release);
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+// Find the index position that points at an entry (caller holds the shard lock), or -1
+static int registry_index_position(registry_segment_t* segment, CGSWindowID windowID, int entryIndex) {
+    _Atomic int32_t* index = registry_segment_index(segment);
+    uint32_t mask = segment->index_mask;
+    uint32_t pos = registry_hash(windowID) & mask;
+    
+    for (uint32_t probe = 0; probe <= mask; probe++) {
+        int32_t slot = atomic_load_explicit(&index[pos], memory_order_relaxed);
+        if (slot == REGISTRY_HASH_EMPTY) {
+            return -1;
+        }
+        if (slot == entryIndex + 1) {
+            return (int)pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    
+    return -1;
+}
+
+// Rebuild a shard's index from its entries (caller holds the shard lock with the
+// sequence odd). Duplicates left by an interrupted move are dropped.
+static void registry_rebuild_index(registry_shared_t* shared, registry_segment_t* segment) {
+    _Atomic int32_t* index = registry_segment_index(segment);
+    for (uint32_t i = 0; i <= segment->index_mask; i++) {
+        atomic_store_explicit(&index[i], REGISTRY_HASH_EMPTY, memory_order_relaxed);
     }
+    segment->tombstone_count = 0;
     
-    pthread_mutex_unlock(registry->lock);
+    int entry_count = atomic_load_explicit(&segment->entry_count, memory_order_relaxed);
+    for (int i = 0; i < entry_count; i++) {
+        registry_entry_t* entry = &segment->entries[i];
+        if (!atomic_load_explicit(&entry->valid, memory_order_relaxed)) {
+            continue;
+        }
+    
+        CGSWindowID windowID = atomic_load_explicit(&entry->windowID, memory_order_relaxed);
+        if (registry_find_entry(shared, segment, windowID) >= 0) {
+            atomic_store_explicit(&entry->valid, false, memory_order_relaxed);
+            continue;
+        }
+        registry_index_insert(segment, windowID, i);
+    }
+}
+
+// Pack a window ID with the generation it was observed under
+static uint64_t registry_local_cache_key(uint32_t generation, CGSWindowID windowID) {
+    return ((uint64_t)generation << 32) | windowID;
+}
+
+// Check the process-local cache for a window known to be modified
+static bool registry_local_cache_contains(window_registry_t* registry, CGSWindowID windowID, uint32_t generation) {
+    uint64_t key = registry_local_cache_key(generation, windowID);
+    uint32_t pos = registry_hash(windowID) & REGISTRY_LOCAL_CACHE_MASK;
+    
+    for (int probe = 0; probe < REGISTRY_LOCAL_CACHE_PROBES; probe++) {
+        uint64_t slot = atomic_load_explicit(&registry->local_cache[pos], memory_order_relaxed);
+        if (slot == key) {
+            return true;
+        }
+        if (slot == 0) {
+            return false;
+        }
+        pos = (pos + 1) & REGISTRY_LOCAL_CACHE_MASK;
+    }
+    
+    return false;
+}
+
+// Remember a window this process has seen in the registry
+static void registry_local_cache_insert(window_registry_t* registry, CGSWindowID windowID, uint32_t generation) {
+    uint64_t key = registry_local_cache_key(generation, windowID);
+    uint32_t home = registry_hash(windowID) & REGISTRY_LOCAL_CACHE_MASK;
+    uint32_t pos = home;
+    
+    for (int probe = 0; probe < REGISTRY_LOCAL_CACHE_PROBES; probe++) {
+        uint64_t slot = atomic_load_explicit(&registry->local_cache[pos], memory_order_relaxed);
+        if (slot == key) {
+            return;
+        }
+    
+        // Empty slots and slots from an older generation are free to reuse
+        if (slot == 0 || (uint32_t)(slot >> 32) != generation) {
+            if (atomic_compare_exchange_strong_explicit(&registry->local_cache[pos], &slot, key,
+                                                        memory_order_relaxed, memory_order_relaxed)) {
+                return;
+            }
+        }
+        pos = (pos + 1) & REGISTRY_LOCAL_CACHE_MASK;
+    }
+    
+    // Probe window full of current entries, evict the home slot
+    atomic_store_explicit(&registry->local_cache[home], key, memory_order_relaxed);
+}
+
+// Drop a window from the process-local cache. The slot is left holding an older
+// generation rather than zero, so probe chains through it stay intact.
+static void registry_local_cache_evict(window_registry_t* registry, CGSWindowID windowID, uint32_t generation) {
+    uint64_t key = registry_local_cache_key(generation, windowID);
+    uint64_t stale = registry_local_cache_key(generation - 1, windowID);
+    uint32_t pos = registry_hash(windowID) & REGISTRY_LOCAL_CACHE_MASK;
+    
+    for (int probe = 0; probe < REGISTRY_LOCAL_CACHE_PROBES; probe++) {
+        uint64_t slot = atomic_load_explicit(&registry->local_cache[pos], memory_order_relaxed);
+        if (slot == key) {
+            atomic_compare_exchange_strong_explicit(&registry->local_cache[pos], &slot, stale,
+                                                    memory_order_relaxed, memory_order_relaxed);
+            return;
+        }
+        if (slot == 0) {
+            return;
+        }
+        pos = (pos + 1) & REGISTRY_LOCAL_CACHE_MASK;
+    }
 }
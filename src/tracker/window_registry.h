@@ -4,6 +4,7 @@
 
 #include <stdbool.h>
 #include "../core/common_types.h"
+#include "window_stats.h"
 
 // Window registry opaque type
 typedef struct window_registry window_registry_t;
@@ -20,7 +21,13 @@ bool registry_mark_window_modified(window_registry_t* registry, CGSWindowID wind
 // Check if a window has been modified 
 bool registry_is_window_modified(window_registry_t* registry, CGSWindowID windowID);
 
+// Remove a window from the registry (e.g. when it is destroyed)
+bool registry_forget_window(window_registry_t* registry, CGSWindowID windowID);
+
 // Get modified window count
 int registry_get_modified_count(window_registry_t* registry);
 
+// Copy statistics of all live injected processes into slots (returns count)
+int registry_read_stats(wm_stats_slot_t* slots, int max_slots);
+
 #endif // WINDOW_REGISTRY_H
@@ -0,0 +1,453 @@
+// window_rules.c - Table-driven window classification
+#include "window_rules.h"
+#include "../core/logging.h"
+#include "../core/process_role.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <limits.h>
+
+#define FEATURE_BIT(feature) (1u << (feature))
+
+// Built-in rules
+static const window_rule_set_t default_rules = {
+    .panel_level_max = 3,
+    .helper_min_size = 50,
+    .helper_min_alpha = 0.3,
+    .standard_min_size = 100,
+    .ready_min_size = 50,
+    .ready_min_alpha = 0.0,
+    .utility_style_mask = 0x8,    // kCGSWindowStyleMask bits
+    .sheet_style_mask = 0x200,
+    .titled_style_mask = 0x1,
+    .feature_class = {
+        [WINDOW_FEATURE_SYSTEM_LEVEL] = WINDOW_CLASS_SYSTEM,
+        [WINDOW_FEATURE_PANEL_LEVEL] = WINDOW_CLASS_PANEL,
+        [WINDOW_FEATURE_OFF_LAYER] = WINDOW_CLASS_HELPER,
+        [WINDOW_FEATURE_TINY] = WINDOW_CLASS_HELPER,
+        [WINDOW_FEATURE_TRANSPARENT] = WINDOW_CLASS_HELPER,
+        [WINDOW_FEATURE_UTILITY_STYLE] = WINDOW_CLASS_PANEL,
+        [WINDOW_FEATURE_SHEET_STYLE] = WINDOW_CLASS_SHEET,
+        [WINDOW_FEATURE_CHILD] = WINDOW_CLASS_SHEET,
+        [WINDOW_FEATURE_TITLED] = WINDOW_CLASS_STANDARD,
+        [WINDOW_FEATURE_STANDARD_SIZE] = WINDOW_CLASS_STANDARD,
+        [WINDOW_FEATURE_DEFAULT] = WINDOW_CLASS_HELPER,
+    }
+};
+
+static const window_rule_set_t *_Atomic active_rules = &default_rules;
+
+// Rules compiled from the environment at init
+static window_rule_set_t configured_rules;
+static pthread_once_t rules_init_once = PTHREAD_ONCE_INIT;
+static bool rules_init_result = true;
+
+#define RULES_MAX_ENTRY 256          // Longest config entry
+#define RULES_MAX_FILE_SIZE 65536    // Largest WM_RULES_FILE accepted
+
+// Config names, indexed by window_feature_t / window_class_t
+static const char *feature_names[WINDOW_FEATURE_COUNT] = {
+    "system_level", "panel_level", "off_layer", "tiny", "transparent", "utility_style",
+    "sheet_style", "child", "titled", "standard_size", "default"
+};
+
+static const char *class_names[] = {
+    "unknown", "normal", "utility", "dialog", "popup", "sheet", "toolbar",
+    "menu", "splash", "helper", "standard", "panel", "system"
+};
+
+// Integer and real thresholds settable from the config
+typedef struct {
+    const char *key;
+    size_t offset;
+    bool is_real;
+    double min;
+    double max;
+} rule_threshold_t;
+
+static const rule_threshold_t rule_thresholds[] = {
+    {"panel_level_max", offsetof(window_rule_set_t, panel_level_max), false, 0, 10000},
+    {"helper_min_size", offsetof(window_rule_set_t, helper_min_size), false, 0, 100000},
+    {"helper_min_alpha", offsetof(window_rule_set_t, helper_min_alpha), true, 0, 1},
+    {"standard_min_size", offsetof(window_rule_set_t, standard_min_size), false, 0, 100000},
+    {"ready_min_size", offsetof(window_rule_set_t, ready_min_size), false, 0, 100000},
+    {"ready_min_alpha", offsetof(window_rule_set_t, ready_min_alpha), true, 0, 1},
+    {"utility_style_mask", offsetof(window_rule_set_t, utility_style_mask), false, 0, UINT32_MAX},
+    {"sheet_style_mask", offsetof(window_rule_set_t, sheet_style_mask), false, 0, UINT32_MAX},
+    {"titled_style_mask", offsetof(window_rule_set_t, titled_style_mask), false, 0, UINT32_MAX},
+};
+
+// Forward declarations
+static void window_rules_init_once(void);
+static bool window_rules_apply_entry(window_rule_set_t *rules, const char *key, const char *value,
+                                     char *error, size_t errorSize);
+static int window_rules_lookup(const char *name, const char *const *names, int count);
+static char *window_rules_read_file(const char *path);
+static char *window_rules_trim(char *text);
+
+// Classes left alone by the modifier, indexed by window_class_t
+static const bool utility_classes[] = {
+    [WINDOW_CLASS_UNKNOWN] = false,
+    [WINDOW_CLASS_NORMAL] = false,
+    [WINDOW_CLASS_UTILITY] = false,
+    [WINDOW_CLASS_DIALOG] = false,
+    [WINDOW_CLASS_POPUP] = true,
+    [WINDOW_CLASS_SHEET] = true,
+    [WINDOW_CLASS_TOOLBAR] = true,
+    [WINDOW_CLASS_MENU] = true,
+    [WINDOW_CLASS_SPLASH] = true,
+    [WINDOW_CLASS_HELPER] = true,
+    [WINDOW_CLASS_STANDARD] = false,
+    [WINDOW_CLASS_PANEL] = true,
+    [WINDOW_CLASS_SYSTEM] = true,
+};
+
+// Classify parsed window properties
+window_verdict_t window_rules_classify(const window_properties_t *props) {
+    window_verdict_t verdict = {WINDOW_CLASS_UNKNOWN, false};
+    if (!props) {
+        return verdict;
+    }
+    
+    const window_rule_set_t *rules = atomic_load_explicit(&active_rules, memory_order_acquire);
+    uint32_t present = props->present;
+    uint32_t hasAlpha = (present & WINDOW_PROP_HAS_ALPHA) != 0;
+    uint32_t hasSize = (present & WINDOW_PROP_HAS_SIZE) != 0;
+    uint32_t hasLayer = (present & WINDOW_PROP_HAS_LAYER) != 0;
+    uint32_t hasLevel = (present & WINDOW_PROP_HAS_LEVEL) != 0;
+    uint32_t hasStyle = (present & WINDOW_PROP_HAS_STYLE_MASK) != 0;
+    uint32_t style = props->style_mask;
+    
+    // Every predicate is evaluated unconditionally and packed into the mask
+    uint32_t features = FEATURE_BIT(WINDOW_FEATURE_DEFAULT);
+    features |= (hasLevel & (props->level > rules->panel_level_max)) << WINDOW_FEATURE_SYSTEM_LEVEL;
+    features |= (hasLevel & (props->level > 0)) << WINDOW_FEATURE_PANEL_LEVEL;
+    features |= (hasLayer & (props->layer != 0)) << WINDOW_FEATURE_OFF_LAYER;
+    features |= (hasSize & ((props->width < rules->helper_min_size) | 
+                            (props->height < rules->helper_min_size))) << WINDOW_FEATURE_TINY;
+    features |= (hasAlpha & (props->alpha < rules->helper_min_alpha)) << WINDOW_FEATURE_TRANSPARENT;
+    features |= (hasStyle & ((style & rules->utility_style_mask) != 0)) << WINDOW_FEATURE_UTILITY_STYLE;
+    features |= (hasStyle & ((style & rules->sheet_style_mask) != 0)) << WINDOW_FEATURE_SHEET_STYLE;
+    features |= ((present & WINDOW_PROP_HAS_PARENT) != 0) << WINDOW_FEATURE_CHILD;
+    features |= (hasStyle & ((style & rules->titled_style_mask) != 0)) << WINDOW_FEATURE_TITLED;
+    features |= (hasAlpha & (props->alpha >= rules->helper_min_alpha) &
+                 (props->width >= rules->standard_min_size) & 
+                 (props->height >= rules->standard_min_size)) << WINDOW_FEATURE_STANDARD_SIZE;
+    
+    // Highest-priority feature decides the class
+    verdict.window_class = (window_class_t)rules->feature_class[__builtin_ctz(features)];
+    
+    verdict.ready = (props->alpha > rules->ready_min_alpha) & (props->layer == 0) &
+                    (props->width > rules->ready_min_size) & (props->height > rules->ready_min_size);
+    
+    return verdict;
+}
+
+// Whether a class is left alone
+bool window_class_is_utility(window_class_t windowClass) {
+    if ((unsigned)windowClass >= sizeof(utility_classes) / sizeof(utility_classes[0])) {
+        return false;
+    }
+    
+    return utility_classes[windowClass];
+}
+
+// The built-in rule set
+const window_rule_set_t *window_rules_default(void) {
+    return &default_rules;
+}
+
+// The rule set currently used for classification
+const window_rule_set_t *window_rules_active(void) {
+    return atomic_load_explicit(&active_rules, memory_order_acquire);
+}
+
+// Compile a config for a process into *rules
+bool window_rules_compile(const char *config, const char *processName, window_rule_set_t *rules,
+                          char *error, size_t errorSize) {
+    if (!config || !rules) {
+        return false;
+    }
+    
+    window_rule_set_t compiled = *rules;
+    char entry[RULES_MAX_ENTRY];
+    char detail[128];
+    bool sectionApplies = true;
+    int entryNumber = 0;
+    const char *cursor = config;
+    
+    while (*cursor) {
+        size_t length = strcspn(cursor, "\n;");
+        const char *next = cursor[length] ? cursor + length + 1 : cursor + length;
+        entryNumber++;
+        
+        if (length >= sizeof(entry)) {
+            if (error) {
+                snprintf(error, errorSize, "entry %d: longer than %d characters", entryNumber, RULES_MAX_ENTRY - 1);
+            }
+            return false;
+        }
+        memcpy(entry, cursor, length);
+        entry[length] = '\0';
+        cursor = next;
+        
+        // Drop comments and blank entries
+        char *comment = strchr(entry, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        char *line = window_rules_trim(entry);
+        if (*line == '\0') {
+            continue;
+        }
+        
+        // Section header: [process name pattern]
+        if (*line == '[') {
+            char *close = strchr(line, ']');
+            if (!close || close[1] != '\0' || close == line + 1) {
+                if (error) {
+                    snprintf(error, errorSize, "entry %d: malformed section '%s'", entryNumber, line);
+                }
+                return false;
+            }
+            *close = '\0';
+            const char *pattern = window_rules_trim(line + 1);
+            sectionApplies = processName && strcasestr(processName, pattern) != NULL;
+            continue;
+        }
+        
+        char *equals = strchr(line, '=');
+        if (!equals) {
+            if (error) {
+                snprintf(error, errorSize, "entry %d: expected key = value, got '%s'", entryNumber, line);
+            }
+            return false;
+        }
+        *equals = '\0';
+        const char *key = window_rules_trim(line);
+        const char *value = window_rules_trim(equals + 1);
+        
+        // Entries of sections that don't apply are still checked
+        window_rule_set_t scratch;
+        window_rule_set_t *target = &compiled;
+        if (!sectionApplies) {
+            scratch = compiled;
+            target = &scratch;
+        }
+        if (!window_rules_apply_entry(target, key, value, detail, sizeof(detail))) {
+            if (error) {
+                snprintf(error, errorSize, "entry %d: %s", entryNumber, detail);
+            }
+            return false;
+        }
+    }
+    
+    *rules = compiled;
+    return true;
+}
+
+// Compile a config file
+bool window_rules_compile_file(const char *path, const char *processName, window_rule_set_t *rules,
+                               char *error, size_t errorSize) {
+    char *text = window_rules_read_file(path);
+    if (!text) {
+        if (error) {
+            snprintf(error, errorSize, "%s: %s", path, strerror(errno));
+        }
+        return false;
+    }
+    
+    char detail[160];
+    bool compiled = window_rules_compile(text, processName, rules, detail, sizeof(detail));
+    if (!compiled && error) {
+        snprintf(error, errorSize, "%s: %s", path, detail);
+    }
+    
+    free(text);
+    return compiled;
+}
+
+// Compile the environment's rules for this process and make them active
+bool window_rules_init(void) {
+    pthread_once(&rules_init_once, window_rules_init_once);
+    return rules_init_result;
+}
+
+// Make a rule set active
+void window_rules_set_active(const window_rule_set_t *rules) {
+    if (!rules) {
+        rules = &default_rules;
+    }
+    
+    for (int i = 0; i < rules->process_pattern_count; i++) {
+        process_role_add_pattern(rules->process_patterns[i].pattern, rules->process_patterns[i].role);
+    }
+    
+    atomic_store_explicit(&active_rules, rules, memory_order_release);
+}
+
+// Read WM_RULES_FILE and WM_RULES (in that order, so the variable can override the file)
+static void window_rules_init_once(void) {
+    const char *path = getenv("WM_RULES_FILE");
+    const char *inline_rules = getenv("WM_RULES");
+    if ((!path || !*path) && (!inline_rules || !*inline_rules)) {
+        return;
+    }
+    
+    const char *processName = getprogname();
+    window_rule_set_t rules = default_rules;
+    char error[PATH_MAX + 192];
+    
+    if (path && *path && !window_rules_compile_file(path, processName, &rules, error, sizeof(error))) {
+        WM_LOG_ERROR("[Rules] %s, using built-in rules\n", error);
+        rules_init_result = false;
+        return;
+    }
+    
+    if (inline_rules && *inline_rules &&
+        !window_rules_compile(inline_rules, processName, &rules, error, sizeof(error))) {
+        WM_LOG_ERROR("[Rules] WM_RULES: %s, using built-in rules\n", error);
+        rules_init_result = false;
+        return;
+    }
+    
+    configured_rules = rules;
+    window_rules_set_active(&configured_rules);
+    WM_LOG_INFO("[Rules] Configured rules active for %s (%d process pattern(s))\n", 
+                processName ? processName : "unknown", configured_rules.process_pattern_count);
+}
+
+// Apply one key = value entry
+static bool window_rules_apply_entry(window_rule_set_t *rules, const char *key, const char *value,
+                                     char *error, size_t errorSize) {
+    // class.<feature> = <class>
+    if (strncasecmp(key, "class.", 6) == 0) {
+        int feature = window_rules_lookup(key + 6, feature_names, WINDOW_FEATURE_COUNT);
+        int windowClass = window_rules_lookup(value, class_names, (int)(sizeof(class_names) / sizeof(class_names[0])));
+        if (feature < 0 || windowClass < 0) {
+            snprintf(error, errorSize, "unknown %s '%s'", feature < 0 ? "feature" : "class", 
+                     feature < 0 ? key + 6 : value);
+            return false;
+        }
+        rules->feature_class[feature] = (uint8_t)windowClass;
+        return true;
+    }
+    
+    // process.<role> = <executable name pattern>
+    if (strncasecmp(key, "process.", 8) == 0) {
+        const char *roleName = key + 8;
+        process_role_t role;
+        if (strcasecmp(roleName, "main") == 0) {
+            role = PROCESS_ROLE_MAIN;
+        } else if (strcasecmp(roleName, "ui") == 0) {
+            role = PROCESS_ROLE_UI;
+        } else if (strcasecmp(roleName, "utility") == 0) {
+            role = PROCESS_ROLE_UTILITY;
+        } else {
+            snprintf(error, errorSize, "unknown process role '%s'", roleName);
+            return false;
+        }
+        
+        if (*value == '\0' || strlen(value) >= sizeof(rules->process_patterns[0].pattern)) {
+            snprintf(error, errorSize, "process pattern must be 1-%zu characters", 
+                     sizeof(rules->process_patterns[0].pattern) - 1);
+            return false;
+        }
+        if (rules->process_pattern_count >= WINDOW_RULES_MAX_PROCESS_PATTERNS) {
+            snprintf(error, errorSize, "more than %d process patterns", WINDOW_RULES_MAX_PROCESS_PATTERNS);
+            return false;
+        }
+        
+        window_process_pattern_t *pattern = &rules->process_patterns[rules->process_pattern_count++];
+        strcpy(pattern->pattern, value);
+        pattern->role = role;
+        return true;
+    }
+    
+    // Thresholds
+    for (size_t i = 0; i < sizeof(rule_thresholds) / sizeof(rule_thresholds[0]); i++) {
+        const rule_threshold_t *threshold = &rule_thresholds[i];
+        if (strcasecmp(key, threshold->key) != 0) {
+            continue;
+        }
+        
+        char *end = NULL;
+        errno = 0;
+        double number = threshold->is_real ? strtod(value, &end) : (double)strtoll(value, &end, 0);
+        if (end == value || *end != '\0' || errno != 0 || number < threshold->min || number > threshold->max) {
+            snprintf(error, errorSize, "%s must be a number in %g..%g, got '%s'", 
+                     threshold->key, threshold->min, threshold->max, value);
+            return false;
+        }
+        
+        char *field = (char *)rules + threshold->offset;
+        if (threshold->is_real) {
+            *(double *)field = number;
+        } else if (threshold->max > INT32_MAX) {
+            *(uint32_t *)field = (uint32_t)number;
+        } else {
+            *(int *)field = (int)number;
+        }
+        return true;
+    }
+    
+    snprintf(error, errorSize, "unknown key '%s'", key);
+    return false;
+}
+
+// Index of a name in a table (case-insensitive), or -1
+static int window_rules_lookup(const char *name, const char *const *names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcasecmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Read a whole config file (caller frees), or NULL
+static char *window_rules_read_file(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return NULL;
+    }
+    
+    char *text = malloc(RULES_MAX_FILE_SIZE + 1);
+    if (!text) {
+        fclose(file);
+        errno = ENOMEM;
+        return NULL;
+    }
+    
+    size_t length = fread(text, 1, RULES_MAX_FILE_SIZE + 1, file);
+    int readError = ferror(file) ? EIO : (length > RULES_MAX_FILE_SIZE ? EFBIG : 0);
+    fclose(file);
+    
+    if (readError != 0) {
+        free(text);
+        errno = readError;
+        return NULL;
+    }
+    
+    text[length] = '\0';
+    return text;
+}
+
+// Strip leading and trailing whitespace in place
+static char *window_rules_trim(char *text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    
+    char *end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    *end = '\0';
+    return text;
+}
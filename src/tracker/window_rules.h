@@ -0,0 +1,103 @@
+// window_rules.h - Table-driven window classification
+#ifndef WINDOW_RULES_H
+#define WINDOW_RULES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../core/common_types.h"
+
+// One classifier for every path that needs a window's class or readiness.
+// A single pass turns the parsed properties into a bitmask of features using
+// the thresholds of the active rule set (comparisons only, no branches per
+// rule); the class is then looked up for the highest-priority feature present.
+
+// Features in priority order (lower bit wins)
+typedef enum {
+    WINDOW_FEATURE_SYSTEM_LEVEL,   // Level above the panel range
+    WINDOW_FEATURE_PANEL_LEVEL,    // Level in the panel range
+    WINDOW_FEATURE_OFF_LAYER,      // Not on the main layer
+    WINDOW_FEATURE_TINY,           // Smaller than the helper size limit
+    WINDOW_FEATURE_TRANSPARENT,    // Alpha below the helper alpha limit
+    WINDOW_FEATURE_UTILITY_STYLE,  // Utility style bit set
+    WINDOW_FEATURE_SHEET_STYLE,    // Sheet style bit set
+    WINDOW_FEATURE_CHILD,          // Has a parent window
+    WINDOW_FEATURE_TITLED,         // Title bar style bit set
+    WINDOW_FEATURE_STANDARD_SIZE,  // Large and opaque enough to be a main window
+    WINDOW_FEATURE_DEFAULT,        // Always set
+    WINDOW_FEATURE_COUNT
+} window_feature_t;
+
+// Maximum number of configured process name patterns
+#define WINDOW_RULES_MAX_PROCESS_PATTERNS 16
+
+// Executable name pattern forced to a process role by the config
+typedef struct {
+    char pattern[32];
+    process_role_t role;
+} window_process_pattern_t;
+
+// Thresholds and the class each feature maps to
+typedef struct {
+    int panel_level_max;           // Levels 1..panel_level_max are panels, above are system
+    int helper_min_size;           // Width or height below this is a helper
+    double helper_min_alpha;       // Alpha below this is a helper
+    int standard_min_size;         // Minimum width and height of an untitled standard window
+    int ready_min_size;            // Width and height must exceed this to be modified
+    double ready_min_alpha;        // Alpha must exceed this to be modified
+    uint32_t utility_style_mask;
+    uint32_t sheet_style_mask;
+    uint32_t titled_style_mask;
+    uint8_t feature_class[WINDOW_FEATURE_COUNT]; // window_class_t per feature
+    int process_pattern_count;
+    window_process_pattern_t process_patterns[WINDOW_RULES_MAX_PROCESS_PATTERNS];
+} window_rule_set_t;
+
+// Result of classifying a window
+typedef struct {
+    window_class_t window_class;
+    bool ready;                    // Visible, on the main layer and large enough to modify
+} window_verdict_t;
+
+// Classify parsed window properties (WINDOW_CLASS_UNKNOWN and not ready for NULL)
+window_verdict_t window_rules_classify(const window_properties_t *props);
+
+// Whether a class is left alone (panels, sheets, helpers, system windows...)
+bool window_class_is_utility(window_class_t windowClass);
+
+// The built-in rule set
+const window_rule_set_t *window_rules_default(void);
+
+// The rule set currently used for classification
+const window_rule_set_t *window_rules_active(void);
+
+// Rules configuration, so per-app policy changes don't need a rebuild. A config
+// is a list of `key = value` entries separated by newlines or `;` (`#` starts a
+// comment). A `[name]` entry starts a section that only applies to processes
+// whose executable name contains `name` (case-insensitive). Keys:
+//   panel_level_max, helper_min_size, helper_min_alpha, standard_min_size,
+//   ready_min_size, ready_min_alpha, utility_style_mask, sheet_style_mask,
+//   titled_style_mask      thresholds (masks accept 0x hex)
+//   class.<feature>        class a feature maps to, e.g. class.transparent = standard
+//   process.<role>         executable name pattern given a role (main, ui, utility)
+//
+// Compile a config for a process into *rules, on top of what it already holds
+// (start from a copy of window_rules_default()). Sections are checked but not
+// applied when processName is NULL. On failure *rules is left untouched and
+// error (if given) describes the first bad entry.
+bool window_rules_compile(const char *config, const char *processName, window_rule_set_t *rules,
+                          char *error, size_t errorSize);
+
+// Compile a config file (at most 64 KB) the same way
+bool window_rules_compile_file(const char *path, const char *processName, window_rule_set_t *rules,
+                               char *error, size_t errorSize);
+
+// Compile WM_RULES_FILE, then WM_RULES, for this process and make the result
+// active (runs once; the built-in rules stay active if either fails)
+bool window_rules_init(void);
+
+// Make a rule set active (the caller keeps it alive) and hand its process
+// patterns to process role detection
+void window_rules_set_active(const window_rule_set_t *rules);
+
+#endif // WINDOW_RULES_H
@@ -0,0 +1,316 @@
+// window_stats.c - Per-process performance counters and latency histograms
+#include "window_stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <mach/mach_time.h>
+
+// Slot this process records into
+static wm_stats_slot_t* _Atomic local_slot = NULL;
+static mach_timebase_info_data_t timebase;
+
+// libsystem_malloc's logging hook, called on every allocation and free once set
+typedef void (malloc_logger_t)(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3,
+                               uintptr_t result, uint32_t num_hot_frames_to_skip);
+#define WM_MALLOC_LOG_TYPE_ALLOCATE 2
+
+// Hot path depth lives in thread-specific data rather than a thread-local
+// variable: the first touch of a thread-local can allocate, which would
+// recurse into the hook
+static pthread_key_t hot_path_key;
+static _Atomic bool hot_path_tracking = false;
+static malloc_logger_t* previous_malloc_logger = NULL;
+static pthread_once_t alloc_tracking_once = PTHREAD_ONCE_INIT;
+
+static const char* counter_names[WM_STAT_COUNT] = {
+    "events_received",
+    "events_dropped",
+    "windows_modified",
+    "modify_failures",
+    "retries_queued",
+    "retry_attempts",
+    "retries_exhausted",
+    "cgs_calls",
+    "lock_acquired",
+    "lock_contended",
+    "sweeps",
+    "hot_path_allocs"
+};
+
+static const char* histogram_names[WM_HIST_COUNT] = {
+    "event_to_modified",
+    "lock_wait",
+    "cgs_call",
+    "sweep"
+};
+
+// Forward declarations
+static int wm_histogram_bucket(uint64_t value);
+static uint64_t wm_histogram_bucket_upper(int bucket);
+static void wm_stats_reset_slot(wm_stats_slot_t* slot);
+static void wm_alloc_tracking_setup(void);
+static void wm_count_hot_path_alloc(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3,
+                                    uintptr_t result, uint32_t num_hot_frames_to_skip);
+
+// Set the slot this process records into
+void wm_stats_attach(wm_stats_slot_t* slot) {
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    atomic_store_explicit(&local_slot, slot, memory_order_release);
+}
+
+// Claim a free or abandoned slot for this process
+wm_stats_slot_t* wm_stats_claim_slot(wm_stats_slot_t* slots, int slot_count) {
+    pid_t self = getpid();
+    
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < slot_count; i++) {
+            pid_t owner = atomic_load_explicit(&slots[i].pid, memory_order_acquire);
+            
+            // First pass takes free slots, second pass reclaims slots of dead processes
+            bool claimable = (owner == 0) || 
+                             (pass == 1 && owner != self && kill(owner, 0) == -1 && errno == ESRCH);
+            if (!claimable) {
+                continue;
+            }
+            
+            if (atomic_compare_exchange_strong_explicit(&slots[i].pid, &owner, self,
+                                                        memory_order_acq_rel, memory_order_relaxed)) {
+                wm_stats_reset_slot(&slots[i]);
+                const char* name = getprogname();
+                strncpy(slots[i].process_name, name ? name : "unknown", sizeof(slots[i].process_name) - 1);
+                slots[i].process_name[sizeof(slots[i].process_name) - 1] = '\0';
+                return &slots[i];
+            }
+        }
+    }
+    
+    return NULL;
+}
+
+// Release this process's slot
+void wm_stats_release_slot(wm_stats_slot_t* slot) {
+    if (!slot) {
+        return;
+    }
+    
+    if (atomic_load_explicit(&local_slot, memory_order_relaxed) == slot) {
+        wm_stats_attach(NULL);
+    }
+    
+    pid_t self = getpid();
+    atomic_compare_exchange_strong(&slot->pid, &self, 0);
+}
+
+// Current time in mach_absolute_time() ticks
+uint64_t wm_stats_now(void) {
+    return mach_absolute_time();
+}
+
+// Convert a tick interval to microseconds
+uint64_t wm_stats_ticks_to_us(uint64_t ticks) {
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return ticks * timebase.numer / timebase.denom / 1000;
+}
+
+// Add to a counter
+void wm_stats_add(wm_stat_counter_t counter, uint64_t value) {
+    wm_stats_slot_t* slot = atomic_load_explicit(&local_slot, memory_order_relaxed);
+    if (!slot) {
+        return;
+    }
+    
+    atomic_fetch_add_explicit(&slot->counters[counter], value, memory_order_relaxed);
+}
+
+// Record a latency in microseconds
+void wm_stats_record_us(wm_stat_histogram_t histogram, uint64_t value_us) {
+    wm_stats_slot_t* slot = atomic_load_explicit(&local_slot, memory_order_relaxed);
+    if (!slot) {
+        return;
+    }
+    
+    wm_histogram_t* hist = &slot->histograms[histogram];
+    atomic_fetch_add_explicit(&hist->buckets[wm_histogram_bucket(value_us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum_us, value_us, memory_order_relaxed);
+    
+    uint64_t max = atomic_load_explicit(&hist->max_us, memory_order_relaxed);
+    while (value_us > max &&
+           !atomic_compare_exchange_weak_explicit(&hist->max_us, &max, value_us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+        // max was reloaded, try again while we're still larger
+    }
+}
+
+// Record the time elapsed since a wm_stats_now() reading
+void wm_stats_record_since(wm_stat_histogram_t histogram, uint64_t start_ticks) {
+    if (!atomic_load_explicit(&local_slot, memory_order_relaxed)) {
+        return;
+    }
+    
+    wm_stats_record_us(histogram, wm_stats_ticks_to_us(mach_absolute_time() - start_ticks));
+}
+
+// Value below which the given fraction of samples fall (bucket upper bound)
+uint64_t wm_histogram_percentile(const wm_histogram_t* histogram, double fraction) {
+    uint64_t total = atomic_load_explicit(&((wm_histogram_t*)histogram)->count, memory_order_relaxed);
+    if (total == 0) {
+        return 0;
+    }
+    
+    uint64_t target = (uint64_t)(fraction * (double)total);
+    if (target == 0) {
+        target = 1;
+    }
+    
+    uint64_t seen = 0;
+    for (int i = 0; i < WM_HIST_BUCKETS; i++) {
+        seen += atomic_load_explicit(&((wm_histogram_t*)histogram)->buckets[i], memory_order_relaxed);
+        if (seen >= target) {
+            uint64_t upper = wm_histogram_bucket_upper(i);
+            uint64_t max = atomic_load_explicit(&((wm_histogram_t*)histogram)->max_us, memory_order_relaxed);
+            return upper < max ? upper : max;
+        }
+    }
+    
+    return atomic_load_explicit(&((wm_histogram_t*)histogram)->max_us, memory_order_relaxed);
+}
+
+// Install the allocation hook if WM_COUNT_ALLOCS=1 (once per process)
+void wm_alloc_tracking_init(void) {
+    pthread_once(&alloc_tracking_once, wm_alloc_tracking_setup);
+}
+
+// Mark this thread as running the event path
+void wm_hot_path_enter(void) {
+    if (!atomic_load_explicit(&hot_path_tracking, memory_order_relaxed)) {
+        return;
+    }
+    
+    intptr_t depth = (intptr_t)pthread_getspecific(hot_path_key);
+    pthread_setspecific(hot_path_key, (void*)(depth + 1));
+}
+
+// Leave the event path
+void wm_hot_path_exit(void) {
+    if (!atomic_load_explicit(&hot_path_tracking, memory_order_relaxed)) {
+        return;
+    }
+    
+    intptr_t depth = (intptr_t)pthread_getspecific(hot_path_key);
+    if (depth > 0) {
+        pthread_setspecific(hot_path_key, (void*)(depth - 1));
+    }
+}
+
+// Stop counting on this thread, returning the depth to restore
+int wm_hot_path_suspend(void) {
+    if (!atomic_load_explicit(&hot_path_tracking, memory_order_relaxed)) {
+        return 0;
+    }
+    
+    intptr_t depth = (intptr_t)pthread_getspecific(hot_path_key);
+    if (depth > 0) {
+        pthread_setspecific(hot_path_key, NULL);
+    }
+    return (int)depth;
+}
+
+// Resume counting at a depth returned by wm_hot_path_suspend()
+void wm_hot_path_resume(int depth) {
+    if (depth > 0 && atomic_load_explicit(&hot_path_tracking, memory_order_relaxed)) {
+        pthread_setspecific(hot_path_key, (void*)(intptr_t)depth);
+    }
+}
+
+// Display names
+const char* wm_stats_counter_name(wm_stat_counter_t counter) {
+    return (counter < WM_STAT_COUNT) ? counter_names[counter] : "unknown";
+}
+
+const char* wm_stats_histogram_name(wm_stat_histogram_t histogram) {
+    return (histogram < WM_HIST_COUNT) ? histogram_names[histogram] : "unknown";
+}
+
+// Map a value to its log-linear bucket
+static int wm_histogram_bucket(uint64_t value) {
+    if (value < WM_HIST_SUB_BUCKETS) {
+        return (int)value;
+    }
+    
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > WM_HIST_MAX_EXPONENT) {
+        return WM_HIST_BUCKETS - 1;
+    }
+    
+    // Top WM_HIST_SUB_BITS bits below the leading one select the sub-bucket
+    int sub = (int)((value >> (exponent - WM_HIST_SUB_BITS)) & (WM_HIST_SUB_BUCKETS - 1));
+    return (exponent - WM_HIST_SUB_BITS + 1) * WM_HIST_SUB_BUCKETS + sub;
+}
+
+// Largest value that maps to a bucket
+static uint64_t wm_histogram_bucket_upper(int bucket) {
+    if (bucket < WM_HIST_SUB_BUCKETS) {
+        return (uint64_t)bucket;
+    }
+    
+    int exponent = bucket / WM_HIST_SUB_BUCKETS + WM_HIST_SUB_BITS - 1;
+    int sub = bucket % WM_HIST_SUB_BUCKETS;
+    uint64_t base = (1ull << exponent) | ((uint64_t)sub << (exponent - WM_HIST_SUB_BITS));
+    return base + (1ull << (exponent - WM_HIST_SUB_BITS)) - 1;
+}
+
+// Zero a slot's counters and histograms (the pid is left alone)
+static void wm_stats_reset_slot(wm_stats_slot_t* slot) {
+    for (int i = 0; i < WM_STAT_COUNT; i++) {
+        atomic_store_explicit(&slot->counters[i], 0, memory_order_relaxed);
+    }
+    
+    for (int h = 0; h < WM_HIST_COUNT; h++) {
+        wm_histogram_t* hist = &slot->histograms[h];
+        atomic_store_explicit(&hist->count, 0, memory_order_relaxed);
+        atomic_store_explicit(&hist->sum_us, 0, memory_order_relaxed);
+        atomic_store_explicit(&hist->max_us, 0, memory_order_relaxed);
+        for (int i = 0; i < WM_HIST_BUCKETS; i++) {
+            atomic_store_explicit(&hist->buckets[i], 0, memory_order_relaxed);
+        }
+    }
+}
+
+// Hook malloc_logger, chaining to whatever was installed before (e.g. MallocStackLogging)
+static void wm_alloc_tracking_setup(void) {
+    const char* value = getenv("WM_COUNT_ALLOCS");
+    if (!value || strcmp(value, "1") != 0) {
+        return;
+    }
+    
+    malloc_logger_t** logger = dlsym(RTLD_DEFAULT, "malloc_logger");
+    if (!logger || pthread_key_create(&hot_path_key, NULL) != 0) {
+        return;
+    }
+    
+    previous_malloc_logger = *logger;
+    atomic_store(&hot_path_tracking, true);
+    *logger = wm_count_hot_path_alloc;
+}
+
+// Count allocations made by threads on the event path
+static void wm_count_hot_path_alloc(uint32_t type, uintptr_t arg1, uintptr_t arg2, uintptr_t arg3,
+                                    uintptr_t result, uint32_t num_hot_frames_to_skip) {
+    if ((type & WM_MALLOC_LOG_TYPE_ALLOCATE) && pthread_getspecific(hot_path_key) != NULL) {
+        wm_stats_increment(WM_STAT_HOT_PATH_ALLOCS);
+    }
+    
+    if (previous_malloc_logger) {
+        previous_malloc_logger(type, arg1, arg2, arg3, result, num_hot_frames_to_skip + 1);
+    }
+}
@@ -0,0 +1,114 @@
+// window_stats.h - Per-process performance counters and latency histograms
+#ifndef WINDOW_STATS_H
+#define WINDOW_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Each injected process owns one slot in the shared registry segment and
+// records into it with relaxed atomic adds, so any process (the injector's
+// --stats mode) can read every slot live. Recording before a slot has been
+// attached (no registry, lazy init not triggered yet) is a no-op.
+//
+// Histograms are log-linear (HDR-style): values in microseconds, exact below
+// WM_HIST_SUB_BUCKETS, then WM_HIST_SUB_BUCKETS buckets per power of two
+// (12.5% resolution), clamped at about two hours.
+
+// Counters
+typedef enum {
+    WM_STAT_EVENTS_RECEIVED,      // CGS notifications received
+    WM_STAT_EVENTS_DROPPED,       // Notifications dropped (event queue full)
+    WM_STAT_WINDOWS_MODIFIED,     // Successful window modifications
+    WM_STAT_MODIFY_FAILURES,      // Modification attempts that failed
+    WM_STAT_RETRIES_QUEUED,       // Windows added to the retry queue
+    WM_STAT_RETRY_ATTEMPTS,       // Retry attempts made
+    WM_STAT_RETRIES_EXHAUSTED,    // Windows that hit the retry limit
+    WM_STAT_CGS_CALLS,            // CGS calls made on behalf of windows
+    WM_STAT_LOCK_ACQUIRED,        // Registry lock acquisitions
+    WM_STAT_LOCK_CONTENDED,       // Acquisitions that had to wait
+    WM_STAT_SWEEPS,               // Full window sweeps
+    WM_STAT_HOT_PATH_ALLOCS,      // Heap allocations on the event path (WM_COUNT_ALLOCS=1)
+    WM_STAT_COUNT
+} wm_stat_counter_t;
+
+// Histograms
+typedef enum {
+    WM_HIST_EVENT_TO_MODIFIED,    // First notification -> successful modification
+    WM_HIST_LOCK_WAIT,            // Registry lock wait
+    WM_HIST_CGS_CALL,             // Single CGS call
+    WM_HIST_SWEEP,                // applyAllWindowModifications duration
+    WM_HIST_COUNT
+} wm_stat_histogram_t;
+
+#define WM_HIST_SUB_BITS 3
+#define WM_HIST_SUB_BUCKETS (1 << WM_HIST_SUB_BITS)
+#define WM_HIST_MAX_EXPONENT 32
+#define WM_HIST_BUCKETS (WM_HIST_SUB_BUCKETS * (WM_HIST_MAX_EXPONENT - WM_HIST_SUB_BITS + 2))
+
+// Maximum number of processes with a stats slot
+#define WM_STATS_MAX_SLOTS 64
+
+// Latency histogram
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum_us;
+    _Atomic uint64_t max_us;
+    _Atomic uint32_t buckets[WM_HIST_BUCKETS];
+} wm_histogram_t;
+
+// One process's statistics (lives in shared memory)
+typedef struct {
+    _Atomic pid_t pid;                     // Owning process (0 = free)
+    char process_name[32];                 // Owning process name
+    _Atomic uint64_t counters[WM_STAT_COUNT];
+    wm_histogram_t histograms[WM_HIST_COUNT];
+} wm_stats_slot_t;
+
+// Set the slot this process records into (NULL to detach)
+void wm_stats_attach(wm_stats_slot_t* slot);
+
+// Claim a free or abandoned slot for this process from a shared array
+wm_stats_slot_t* wm_stats_claim_slot(wm_stats_slot_t* slots, int slot_count);
+
+// Release this process's slot
+void wm_stats_release_slot(wm_stats_slot_t* slot);
+
+// Current time in mach_absolute_time() ticks
+uint64_t wm_stats_now(void);
+
+// Convert a tick interval to microseconds
+uint64_t wm_stats_ticks_to_us(uint64_t ticks);
+
+// Add to a counter
+void wm_stats_add(wm_stat_counter_t counter, uint64_t value);
+
+// Record a latency in microseconds
+void wm_stats_record_us(wm_stat_histogram_t histogram, uint64_t value_us);
+
+// Record the time elapsed since a wm_stats_now() reading
+void wm_stats_record_since(wm_stat_histogram_t histogram, uint64_t start_ticks);
+
+// Value (in microseconds) below which the given fraction of samples fall
+uint64_t wm_histogram_percentile(const wm_histogram_t* histogram, double fraction);
+
+// Display names
+const char* wm_stats_counter_name(wm_stat_counter_t counter);
+const char* wm_stats_histogram_name(wm_stat_histogram_t histogram);
+
+#define wm_stats_increment(counter) wm_stats_add((counter), 1)
+
+// Hot path allocation accounting. With WM_COUNT_ALLOCS=1 a malloc_logger hook
+// counts every allocation a thread makes between wm_hot_path_enter() and
+// wm_hot_path_exit() into WM_STAT_HOT_PATH_ALLOCS. Without it the markers
+// cost one relaxed load.
+void wm_alloc_tracking_init(void);
+void wm_hot_path_enter(void);
+void wm_hot_path_exit(void);
+
+// Stop counting on this thread around an allocation the caller can't avoid,
+// returning the nesting depth to hand back to wm_hot_path_resume()
+int wm_hot_path_suspend(void);
+void wm_hot_path_resume(int depth);
+
+#endif // WINDOW_STATS_H
@@ -0,0 +1,473 @@
+// window_table.c - Per-process table of tracked windows
+#include "window_table.h"
+#include "../core/logging.h"
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+// Index size (power of two, 2x capacity keeps probe chains short)
+#define WINDOW_TABLE_INDEX_SIZE (WINDOW_TABLE_CAPACITY * 2)
+#define WINDOW_TABLE_INDEX_MASK (WINDOW_TABLE_INDEX_SIZE - 1)
+#define WINDOW_TABLE_INDEX_EMPTY 0   // Index slots hold record slot + 1
+
+// Record flags
+#define WINDOW_RECORD_INITIALIZED (1 << 0)
+#define WINDOW_RECORD_HANDLED     (1 << 1)   // Modified in-process through NSWindow
+#define WINDOW_RECORD_ORIGINAL    (1 << 2)   // Pre-modification attributes captured
+
+// Flat record storage (struct-of-arrays)
+static CGSWindowID table_ids[WINDOW_TABLE_CAPACITY];
+static uint8_t table_classes[WINDOW_TABLE_CAPACITY];
+static uint8_t table_state[WINDOW_TABLE_CAPACITY];
+static uint8_t table_flags[WINDOW_TABLE_CAPACITY];
+static time_t table_first_seen[WINDOW_TABLE_CAPACITY];
+static uint64_t table_pending_event[WINDOW_TABLE_CAPACITY]; // Ticks of the oldest unhandled event
+static int table_original_level[WINDOW_TABLE_CAPACITY];
+static int8_t table_original_sharing[WINDOW_TABLE_CAPACITY];
+static uint8_t table_original_flags[WINDOW_TABLE_CAPACITY];  // WINDOW_ORIGINAL_* flags
+
+// Window ID -> record slot
+static uint16_t table_index[WINDOW_TABLE_INDEX_SIZE];
+
+// Free record slots (stack)
+static uint16_t table_free_slots[WINDOW_TABLE_CAPACITY];
+static int table_free_count = 0;
+static int table_count = 0;
+
+// Running counts of standard windows, updated on every class or flag change
+static int table_standard_count = 0;
+static int table_initialized_standard_count = 0;
+
+static pthread_mutex_t table_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool table_initialized = false;
+
+// Forward declarations
+static uint32_t window_table_home(CGSWindowID windowID);
+static int window_table_find_index(CGSWindowID windowID);
+static int window_table_find_slot(CGSWindowID windowID);
+static void window_table_reset(void);
+static void window_table_account(int slot, int delta);
+
+// Initialize the table
+bool window_table_init(void) {
+    pthread_mutex_lock(&table_mutex);
+    if (!table_initialized) {
+        window_table_reset();
+        table_initialized = true;
+    }
+    pthread_mutex_unlock(&table_mutex);
+    
+    return true;
+}
+
+// Clean up the table
+void window_table_cleanup(void) {
+    pthread_mutex_lock(&table_mutex);
+    window_table_reset();
+    table_initialized = false;
+    pthread_mutex_unlock(&table_mutex);
+}
+
+// Start tracking a window
+bool window_table_track(CGSWindowID windowID, window_class_t windowClass, bool *created) {
+    if (created) {
+        *created = false;
+    }
+    if (windowID == 0) {
+        return false;
+    }
+    
+    pthread_mutex_lock(&table_mutex);
+    
+    if (!table_initialized) {
+        window_table_reset();
+        table_initialized = true;
+    }
+    
+    if (window_table_find_slot(windowID) >= 0) {
+        pthread_mutex_unlock(&table_mutex);
+        return true;
+    }
+    
+    if (table_free_count == 0) {
+        pthread_mutex_unlock(&table_mutex);
+        WM_LOG_WARN("[WindowTable] Table full, not tracking window %d\n", windowID);
+        return false;
+    }
+    
+    int slot = table_free_slots[--table_free_count];
+    table_ids[slot] = windowID;
+    table_classes[slot] = (uint8_t)windowClass;
+    table_state[slot] = 0;
+    table_flags[slot] = 0;
+    table_first_seen[slot] = time(NULL);
+    table_pending_event[slot] = 0;
+    table_original_flags[slot] = 0;
+    window_table_account(slot, 1);
+    
+    uint32_t pos = window_table_home(windowID);
+    while (table_index[pos] != WINDOW_TABLE_INDEX_EMPTY) {
+        pos = (pos + 1) & WINDOW_TABLE_INDEX_MASK;
+    }
+    table_index[pos] = (uint16_t)(slot + 1);
+    table_count++;
+    
+    pthread_mutex_unlock(&table_mutex);
+    
+    if (created) {
+        *created = true;
+    }
+    return true;
+}
+
+// Check if a window is tracked
+bool window_table_contains(CGSWindowID windowID) {
+    pthread_mutex_lock(&table_mutex);
+    bool found = window_table_find_slot(windowID) >= 0;
+    pthread_mutex_unlock(&table_mutex);
+    
+    return found;
+}
+
+// Copy a window's record
+bool window_table_get(CGSWindowID windowID, window_init_state_t *record) {
+    pthread_mutex_lock(&table_mutex);
+    
+    int slot = window_table_find_slot(windowID);
+    if (slot >= 0 && record) {
+        record->window_id = table_ids[slot];
+        record->window_class = (window_class_t)table_classes[slot];
+        record->window_state = table_state[slot];
+        record->is_initialized = (table_flags[slot] & WINDOW_RECORD_INITIALIZED) != 0;
+        record->first_seen = table_first_seen[slot];
+    }
+    
+    pthread_mutex_unlock(&table_mutex);
+    return slot >= 0;
+}
+
+// Get a window's class
+window_class_t window_table_get_class(CGSWindowID windowID) {
+    pthread_mutex_lock(&table_mutex);
+    int slot = window_table_find_slot(windowID);
+    window_class_t windowClass = (slot >= 0) ? (window_class_t)table_classes[slot] : WINDOW_CLASS_UNKNOWN;
+    pthread_mutex_unlock(&table_mutex);
+    
+    return windowClass;
+}
+
+// Set a window's class
+bool window_table_set_class(CGSWindowID windowID, window_class_t windowClass) {
+    pthread_mutex_lock(&table_mutex);
+    int slot = window_table_find_slot(windowID);
+    if (slot >= 0) {
+        window_table_account(slot, -1);
+        table_classes[slot] = (uint8_t)windowClass;
+        window_table_account(slot, 1);
+    }
+    pthread_mutex_unlock(&table_mutex);
+    
+    return slot >= 0;
+}
+
+// OR state bits into a window's state
+int window_table_add_state(CGSWindowID windowID, int stateBits, bool *became_initialized) {
+    if (became_initialized) {
+        *became_initialized = false;
+    }
+    
+    pthread_mutex_lock(&table_mutex);
+    
+    int slot = window_table_find_slot(windowID);
+    if (slot < 0) {
+        pthread_mutex_unlock(&table_mutex);
+        return -1;
+    }
+    
+    table_state[slot] |= (uint8_t)stateBits;
+    int state = table_state[slot];
+    
+    // Initialization is latched once all state bits have been seen
+    if (!(table_flags[slot] & WINDOW_RECORD_INITIALIZED) &&
+        (state & WINDOW_STATE_FULLY_INITIALIZED) == WINDOW_STATE_FULLY_INITIALIZED) {
+        window_table_account(slot, -1);
+        table_flags[slot] |= WINDOW_RECORD_INITIALIZED;
+        window_table_account(slot, 1);
+        if (became_initialized) {
+            *became_initialized = true;
+        }
+    }
+    
+    pthread_mutex_unlock(&table_mutex);
+    return state;
+}
+
+// Clear state bits
+int window_table_clear_state(CGSWindowID windowID, int stateBits) {
+    pthread_mutex_lock(&table_mutex);
+    
+    int slot = window_table_find_slot(windowID);
+    int state = -1;
+    if (slot >= 0) {
+        table_state[slot] &= (uint8_t)~stateBits;
+        state = table_state[slot];
+    }
+    
+    pthread_mutex_unlock(&table_mutex);
+    return state;
+}
+
+// Check if a window is fully initialized
+bool window_table_is_initialized(CGSWindowID windowID) {
+    pthread_mutex_lock(&table_mutex);
+    int slot = window_table_find_slot(windowID);
+    bool initialized = (slot >= 0) && (table_flags[slot] & WINDOW_RECORD_INITIALIZED);
+    pthread_mutex_unlock(&table_mutex);
+    
+    return initialized;
+}
+
+// Stop tracking a window, using backward-shift deletion in the index
+bool window_table_remove(CGSWindowID windowID) {
+    pthread_mutex_lock(&table_mutex);
+    
+    int found = window_table_find_index(windowID);
+    if (found < 0) {
+        pthread_mutex_unlock(&table_mutex);
+        return false;
+    }
+    
+    int slot = table_index[found] - 1;
+    
+    uint32_t hole = (uint32_t)found;
+    uint32_t next = (hole + 1) & WINDOW_TABLE_INDEX_MASK;
+    
+    while (table_index[next] != WINDOW_TABLE_INDEX_EMPTY) {
+        uint32_t home = window_table_home(table_ids[table_index[next] - 1]);
+        
+        // Move the entry back if the hole lies on its probe path
+        if (((next - home) & WINDOW_TABLE_INDEX_MASK) >= ((next - hole) & WINDOW_TABLE_INDEX_MASK)) {
+            table_index[hole] = table_index[next];
+            hole = next;
+        }
+        next = (next + 1) & WINDOW_TABLE_INDEX_MASK;
+    }
+    table_index[hole] = WINDOW_TABLE_INDEX_EMPTY;
+    
+    window_table_account(slot, -1);
+    table_ids[slot] = 0;
+    table_classes[slot] = WINDOW_CLASS_UNKNOWN;
+    table_state[slot] = 0;
+    table_flags[slot] = 0;
+    table_pending_event[slot] = 0;
+    table_original_flags[slot] = 0;
+    table_free_slots[table_free_count++] = (uint16_t)slot;
+    table_count--;
+    
+    pthread_mutex_unlock(&table_mutex);
+    return true;
+}
+
+// Record that a window was modified in-process through its NSWindow
+bool window_table_mark_handled(CGSWindowID windowID, window_class_t windowClass) {
+    if (!window_table_track(windowID, windowClass, NULL)) {
+        return false;
+    }
+    
+    pthread_mutex_lock(&table_mutex);
+    int slot = window_table_find_slot(windowID);
+    if (slot >= 0) {
+        // Tracked before it could be classified (e.g. to save its original state)
+        if (table_classes[slot] == WINDOW_CLASS_UNKNOWN) {
+            window_table_account(slot, -1);
+            table_classes[slot] = (uint8_t)windowClass;
+            window_table_account(slot, 1);
+        }
+        table_flags[slot] |= WINDOW_RECORD_HANDLED;
+    }
+    pthread_mutex_unlock(&table_mutex);
+    
+    return slot >= 0;
+}
+
+// Check if a window was modified in-process through its NSWindow
+bool window_table_is_handled(CGSWindowID windowID) {
+    pthread_mutex_lock(&table_mutex);
+    int slot = window_table_find_slot(windowID);
+    bool handled = (slot >= 0) && (table_flags[slot] & WINDOW_RECORD_HANDLED);
+    pthread_mutex_unlock(&table_mutex);
+    
+    return handled;
+}
+
+// Remember when a window's oldest unhandled event arrived
+bool window_table_note_event(CGSWindowID windowID, uint64_t ticks) {
+    pthread_mutex_lock(&table_mutex);
+    
+    int slot = window_table_find_slot(windowID);
+    if (slot >= 0 && table_pending_event[slot] == 0) {
+        table_pending_event[slot] = ticks;
+    }
+    
+    pthread_mutex_unlock(&table_mutex);
+    return slot >= 0;
+}
+
+// Return and clear a window's pending event time (0 if none)
+uint64_t window_table_take_event(CGSWindowID windowID) {
+    pthread_mutex_lock(&table_mutex);
+    
+    uint64_t ticks = 0;
+    int slot = window_table_find_slot(windowID);
+    if (slot >= 0) {
+        ticks = table_pending_event[slot];
+        table_pending_event[slot] = 0;
+    }
+    
+    pthread_mutex_unlock(&table_mutex);
+    return ticks;
+}
+
+// Remember a window's pre-modification attributes (first capture wins)
+bool window_table_save_original(const window_original_state_t *original) {
+    if (!original || !window_table_track(original->window_id, WINDOW_CLASS_UNKNOWN, NULL)) {
+        return false;
+    }
+    
+    pthread_mutex_lock(&table_mutex);
+    
+    int slot = window_table_find_slot(original->window_id);
+    bool saved = (slot >= 0) && !(table_flags[slot] & WINDOW_RECORD_ORIGINAL);
+    if (saved) {
+        table_original_level[slot] = original->level;
+        table_original_sharing[slot] = (int8_t)original->sharing_state;
+        table_original_flags[slot] = (uint8_t)original->flags;
+        table_flags[slot] |= WINDOW_RECORD_ORIGINAL;
+    }
+    
+    pthread_mutex_unlock(&table_mutex);
+    return saved;
+}
+
+// Check if a window's original attributes have been captured
+bool window_table_has_original(CGSWindowID windowID) {
+    pthread_mutex_lock(&table_mutex);
+    int slot = window_table_find_slot(windowID);
+    bool captured = (slot >= 0) && (table_flags[slot] & WINDOW_RECORD_ORIGINAL);
+    pthread_mutex_unlock(&table_mutex);
+    
+    return captured;
+}
+
+// Copy out and clear captured originals in one pass over the records
+size_t window_table_take_originals(window_original_state_t *originals, size_t maxCount) {
+    size_t count = 0;
+    
+    pthread_mutex_lock(&table_mutex);
+    for (int i = 0; i < WINDOW_TABLE_CAPACITY && count < maxCount; i++) {
+        if (table_ids[i] == 0 || !(table_flags[i] & WINDOW_RECORD_ORIGINAL)) {
+            continue;
+        }
+        
+        originals[count].window_id = table_ids[i];
+        originals[count].level = table_original_level[i];
+        originals[count].sharing_state = table_original_sharing[i];
+        originals[count].flags = table_original_flags[i];
+        count++;
+        
+        table_flags[i] &= (uint8_t)~WINDOW_RECORD_ORIGINAL;
+        table_original_flags[i] = 0;
+    }
+    pthread_mutex_unlock(&table_mutex);
+    
+    return count;
+}
+
+// Count tracked standard windows
+void window_table_count_standard(int *standardCount, int *initializedCount) {
+    pthread_mutex_lock(&table_mutex);
+    int standard = table_standard_count;
+    int initialized = table_initialized_standard_count;
+    pthread_mutex_unlock(&table_mutex);
+    
+    if (standardCount) {
+        *standardCount = standard;
+    }
+    if (initializedCount) {
+        *initializedCount = initialized;
+    }
+}
+
+// Number of tracked windows
+int window_table_count(void) {
+    pthread_mutex_lock(&table_mutex);
+    int count = table_count;
+    pthread_mutex_unlock(&table_mutex);
+    
+    return count;
+}
+
+// Home index position of a window ID (Fibonacci hashing)
+static uint32_t window_table_home(CGSWindowID windowID) {
+    return (windowID * 2654435761u) & WINDOW_TABLE_INDEX_MASK;
+}
+
+// Find a window's index position (caller holds the mutex), or -1
+static int window_table_find_index(CGSWindowID windowID) {
+    if (windowID == 0) {
+        return -1;
+    }
+    
+    uint32_t pos = window_table_home(windowID);
+    while (table_index[pos] != WINDOW_TABLE_INDEX_EMPTY) {
+        if (table_ids[table_index[pos] - 1] == windowID) {
+            return (int)pos;
+        }
+        pos = (pos + 1) & WINDOW_TABLE_INDEX_MASK;
+    }
+    
+    return -1;
+}
+
+// Find a window's record slot (caller holds the mutex), or -1
+static int window_table_find_slot(CGSWindowID windowID) {
+    int pos = window_table_find_index(windowID);
+    return (pos >= 0) ? table_index[pos] - 1 : -1;
+}
+
+// Reset all storage (caller holds the mutex)
+static void window_table_reset(void) {
+    memset(table_ids, 0, sizeof(table_ids));
+    memset(table_classes, 0, sizeof(table_classes));
+    memset(table_state, 0, sizeof(table_state));
+    memset(table_flags, 0, sizeof(table_flags));
+    memset(table_first_seen, 0, sizeof(table_first_seen));
+    memset(table_pending_event, 0, sizeof(table_pending_event));
+    memset(table_original_level, 0, sizeof(table_original_level));
+    memset(table_original_sharing, 0, sizeof(table_original_sharing));
+    memset(table_original_flags, 0, sizeof(table_original_flags));
+    memset(table_index, 0, sizeof(table_index));
+    
+    // Hand out low slots first
+    for (int i = 0; i < WINDOW_TABLE_CAPACITY; i++) {
+        table_free_slots[i] = (uint16_t)(WINDOW_TABLE_CAPACITY - 1 - i);
+    }
+    table_free_count = WINDOW_TABLE_CAPACITY;
+    table_count = 0;
+    table_standard_count = 0;
+    table_initialized_standard_count = 0;
+}
+
+// Add or remove a record's contribution to the standard window counts
+// (caller holds the mutex)
+static void window_table_account(int slot, int delta) {
+    if (table_classes[slot] != WINDOW_CLASS_STANDARD) {
+        return;
+    }
+    
+    table_standard_count += delta;
+    if (table_flags[slot] & WINDOW_RECORD_INITIALIZED) {
+        table_initialized_standard_count += delta;
+    }
+}
@@ -0,0 +1,84 @@
+// window_table.h - Per-process table of tracked windows
+#ifndef WINDOW_TABLE_H
+#define WINDOW_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../core/common_types.h"
+
+// This module replaces the per-window dictionaries previously kept by the
+// modifier, the CGS layer and the classifier with one table. Records are
+// stored as flat arrays (struct-of-arrays) in fixed storage and found through
+// an open-addressing hash on the window ID. All functions are thread-safe.
+
+// Maximum number of windows tracked at once
+#define WINDOW_TABLE_CAPACITY 4096
+
+// Initialize / clean up the table
+bool window_table_init(void);
+void window_table_cleanup(void);
+
+// Start tracking a window with the given class (no-op if already tracked).
+// Returns false if the table is full. *created reports whether a record was added.
+bool window_table_track(CGSWindowID windowID, window_class_t windowClass, bool *created);
+
+// Check if a window is tracked
+bool window_table_contains(CGSWindowID windowID);
+
+// Copy a window's record (window_init_state_t is the record layout)
+bool window_table_get(CGSWindowID windowID, window_init_state_t *record);
+
+// Get a window's class (WINDOW_CLASS_UNKNOWN if untracked)
+window_class_t window_table_get_class(CGSWindowID windowID);
+
+// Set a window's class
+bool window_table_set_class(CGSWindowID windowID, window_class_t windowClass);
+
+// OR state bits into a window's state. Returns the new state or -1 if untracked;
+// *became_initialized is set when this call completed WINDOW_STATE_FULLY_INITIALIZED.
+int window_table_add_state(CGSWindowID windowID, int stateBits, bool *became_initialized);
+
+// Clear state bits (e.g. VISIBLE on order-out); initialization stays latched.
+// Returns the new state or -1 if untracked.
+int window_table_clear_state(CGSWindowID windowID, int stateBits);
+
+// Check if a window is fully initialized
+bool window_table_is_initialized(CGSWindowID windowID);
+
+// Stop tracking a window
+bool window_table_remove(CGSWindowID windowID);
+
+// Record that a window was modified in-process through its NSWindow (tracking it
+// with the given class if needed, or filling in an unknown class), so CGS events
+// for it can be short-circuited
+bool window_table_mark_handled(CGSWindowID windowID, window_class_t windowClass);
+
+// Check if a window was modified in-process through its NSWindow
+bool window_table_is_handled(CGSWindowID windowID);
+
+// Remember when the oldest not-yet-handled event for a window arrived
+// (mach_absolute_time() ticks); later events keep the earlier time
+bool window_table_note_event(CGSWindowID windowID, uint64_t ticks);
+
+// Return and clear a window's pending event time (0 if none)
+uint64_t window_table_take_event(CGSWindowID windowID);
+
+// Remember a window's pre-modification attributes (tracking it if needed). Only
+// the first capture is kept, so re-modifications never overwrite the originals.
+bool window_table_save_original(const window_original_state_t *original);
+
+// Check if a window's original attributes have been captured
+bool window_table_has_original(CGSWindowID windowID);
+
+// Copy out and clear up to maxCount captured originals, returning how many
+size_t window_table_take_originals(window_original_state_t *originals, size_t maxCount);
+
+// Count tracked standard windows, and how many of them are initialized
+// (running counters kept up to date by every table update, so this is O(1))
+void window_table_count_standard(int *standardCount, int *initializedCount);
+
+// Number of tracked windows
+int window_table_count(void);
+
+#endif // WINDOW_TABLE_H